@@ -1,14 +1,56 @@
 #ifndef MLREVIEW_DATABASE_CONNECTION_MONGODB_HPP
 #define MLREVIEW_DATABASE_CONNECTION_MONGODB_HPP
 #include <memory>
+#include <string>
+#include <chrono>
+#include <cstdint>
 namespace MLReview::Database::Connection
 {
 /// @name MongoDB "mongodb.hpp" "mlReview/database/connection/mongodb.hpp"
-/// @brief Defines a MongoDB connection.
+/// @brief Defines a MongoDB connection.  The connection is a pool of
+///        clients.  A mongocxx client must not be used by more than one
+///        thread at a time so each user leases a client from the pool for
+///        the duration of its work and the client is returned when the
+///        lease is destroyed.
 /// @copyright Ben Baker (University of Utah) distributed under the MIT license. 
 class MongoDB
 {
 public:
+    /// @brief Exclusive use of a client from the pool.  The client is
+    ///        returned to the pool when the lease is destroyed.
+    class Lease
+    {
+    public:
+        /// @brief Move constructor.
+        Lease(Lease &&lease) noexcept;
+        /// @brief Move assignment.
+        Lease& operator=(Lease &&lease) noexcept;
+        /// @result A pointer to the leased mongocxx::client.  This is valid
+        ///         for the lifetime of the lease.
+        [[nodiscard]] std::uintptr_t getSession() const noexcept;
+        /// @brief Destructor.  This returns the client to the pool.
+        ~Lease();
+        Lease(const Lease &) = delete;
+        Lease& operator=(const Lease &) = delete;
+    private:
+        friend class MongoDB;
+        class LeaseImpl;
+        explicit Lease(std::unique_ptr<LeaseImpl> &&pImpl);
+        std::unique_ptr<LeaseImpl> pImpl;
+    };
+    /// @brief The pool's usage.
+    struct PoolStatistics
+    {
+        int64_t nLeases{0}; /*!< The number of leases granted. */
+        int nLeased{0};     /*!< The number of clients currently leased. */
+        int64_t nWaits{0};  /*!< The number of leases that had to wait for
+                                 a client to be returned. */
+        std::chrono::microseconds totalWaitTime{0};   /*!< The total time
+                                                           spent waiting. */
+        std::chrono::microseconds maximumWaitTime{0}; /*!< The longest
+                                                           wait. */
+    };
+
     /// @name Constructors
     /// @{
 
@@ -104,6 +146,34 @@ public:
     [[nodiscard]] std::string getApplication() const noexcept;
     /// @}
 
+    /// @name Pool Size
+    /// @{
+
+    /// @brief Sets the number of clients the pool keeps open.
+    /// @throws std::invalid_argument if nClients is negative.
+    /// @note This takes effect on the next \c connect().
+    void setMinimumPoolSize(int nClients);
+    /// @result The number of clients the pool keeps open.  By default
+    ///         this is 1.
+    [[nodiscard]] int getMinimumPoolSize() const noexcept;
+    /// @brief Sets the maximum number of clients in the pool.  Once this
+    ///        many are leased \c acquire() waits for one to be returned.
+    /// @throws std::invalid_argument if nClients is not positive.
+    /// @note This takes effect on the next \c connect().
+    void setMaximumPoolSize(int nClients);
+    /// @result The maximum number of clients in the pool.  By default this
+    ///         is 16.
+    [[nodiscard]] int getMaximumPoolSize() const noexcept;
+    /// @brief Sets the longest that \c acquire() waits for a client to be
+    ///        returned to the pool.
+    /// @throws std::invalid_argument if the timeout is not positive.
+    /// @note This takes effect on the next \c connect().
+    void setAcquireTimeout(const std::chrono::milliseconds &timeout);
+    /// @result The longest that \c acquire() waits for a client.  By
+    ///         default this is 10 seconds.
+    [[nodiscard]] std::chrono::milliseconds getAcquireTimeout() const noexcept;
+    /// @}
+
     /// @name Driver
     /// @{
 
@@ -117,14 +187,24 @@ public:
     /// @result The connection string.
     [[nodiscard]] std::string getConnectionString() const;
     /// @brief Establishes a connection from the above resources.
+    /// @throws std::invalid_argument if the minimum pool size exceeds the
+    ///         maximum pool size.
+    /// @throws std::runtime_error if the pool cannot be created.
     void connect();
     /// @result True indicates the connection was established.
     [[nodiscard]] bool isConnected() const noexcept;
     /// @}
 
-    /// @result A shared pointer to the session.
-    /// @throws std::runtime_error if \c isConnected() is false.
-    [[nodiscard]] std::uintptr_t getSession() const;
+    /// @result A lease on a client from the pool.  If every client is
+    ///         leased then this waits until one is returned.
+    /// @throws std::runtime_error if \c isConnected() is false or no client
+    ///         was returned within the acquire timeout.
+    /// @note Leases should be held only as long as the work that needs
+    ///       them so the pool is not exhausted.
+    [[nodiscard]] Lease acquire() const;
+    /// @result The pool's usage.  Waits that exceed the slow wait
+    ///         threshold are also logged as they happen.
+    [[nodiscard]] PoolStatistics getPoolStatistics() const noexcept;
 
     /// @name Disconnect
     /// @{
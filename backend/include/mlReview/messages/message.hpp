@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>
 #include <optional>
+#include <functional>
 #include <nlohmann/json.hpp>
 namespace MLReview::Messages
 {
@@ -16,6 +17,12 @@ public:
     /// @result The data associated with this request.
     ///         By default this is null.
     [[nodiscard]] virtual std::optional<nlohmann::json> getData() const noexcept; 
+    /// @result A function that returns the serialized data one piece at a
+    ///         time and nothing once all the data has been returned.  This
+    ///         allows large responses to be sent without ever holding them
+    ///         in memory.  By default this is null in which case the data
+    ///         is given by \c getData().
+    [[nodiscard]] virtual std::function<std::optional<std::string> ()> getDataStream() const noexcept;
     /// @result The status code associated with this request.
     [[nodiscard]] virtual int getStatusCode() const noexcept;
     /// @result True indicates the API call was a success.
@@ -23,6 +30,10 @@ public:
     /// @result True a message accompanying the response.
     ///         By defualt this is null.
     [[nodiscard]] virtual std::optional<std::string> getMessage() const noexcept;
+    /// @result A tag identifying the version of the data - e.g., for HTTP
+    ///         conditional requests.  Clients that already hold data with
+    ///         this tag need not receive it again.  By default this is null.
+    [[nodiscard]] virtual std::optional<std::string> getETag() const noexcept;
     /// @brief Converts the message to a binary representation.
     //[[nodiscard]] std::vector<uint8_t> toCBOR(const bool compress = false) const;
 };
@@ -33,6 +44,14 @@ public:
 ///           "success": true,
 ///           "data": {"more": "stuff"}
 ///         }
+///         If the message has an ETag then it is given by an "etag" field
+///         which precedes the data.
 std::string toJSON(const std::unique_ptr<IMessage> &message, const int indent =-1);
+/// @result A function that returns the same serialization as \c toJSON()
+///         one piece at a time and nothing when finished.  If the message
+///         has a data stream then the data is pulled from it as the pieces
+///         are requested.
+/// @note The message is consumed.
+std::function<std::optional<std::string> ()> toJSONStream(std::unique_ptr<IMessage> &&message);
 }
 #endif
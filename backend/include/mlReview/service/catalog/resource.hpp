@@ -1,11 +1,18 @@
 #ifndef MLREVIEW_SERVICE_CATALOG_RESOURCE_HPP
 #define MLREVIEW_SERVICE_CATALOG_RESOURCE_HPP
 #include <memory>
+#include <vector>
+#include <optional>
+#include <functional>
 #include <mlReview/service/resource.hpp>
 namespace MLReview::Database::Connection
 {
  class MongoDB;
 }
+namespace MLReview::Service
+{
+ class Geofence;
+}
 namespace MLReview::Service::Catalog
 {
 /// @class Resource "resource.hpp" "drp/service/catalog/resource.hpp"
@@ -18,10 +25,81 @@ class Resource : public MLReview::Service::IResource
 public:
     explicit Resource(std::shared_ptr<MLReview::Database::Connection::MongoDB> &mongoClient);
 
+    /// @brief Sets a function to call with the identifiers of events that
+    ///        newly appear in the catalog - e.g., to prefetch their
+    ///        waveforms.  The function is called from the polling thread.
+    void setNewEventsCallback(const std::function<void (const std::vector<int64_t> &)> &callback);
+
+    /// @result A function that returns the (latitude, longitude) in degrees
+    ///         of an event's preferred origin or nothing if the event is not
+    ///         in the standard catalog.  This is intended for other
+    ///         resources, such as the stations, and can safely outlive this
+    ///         resource in which case it always returns nothing.
+    [[nodiscard]] std::function<std::optional<std::pair<double, double>> (int64_t)> getEpicenterCallback() const;
+
+    /// @brief Sets the regions that requests can filter on by name.
+    void setGeofence(const std::shared_ptr<const MLReview::Service::Geofence> &geofence);
+
+    /// @brief Subscribes to catalog changes.  After each change the
+    ///        callback is given a notification whose data holds the events
+    ///        upserted and removed since the previous notification, or,
+    ///        when that would be large, just the new version.  Either way
+    ///        the data has fromVersion and version so a subscriber that
+    ///        missed a notification can catch up with sinceVersion.
+    /// @note The callback is called from the polling thread.
+    [[nodiscard]] int64_t subscribe(const std::function<void (const std::shared_ptr<const std::string> &)> &callback) override final;
+    /// @brief Removes the subscription with the given identifier.
+    void unsubscribe(int64_t identifier) noexcept override final;
+
+    /// @brief Applies changes to the events collection as they happen by
+    ///        watching a MongoDB change stream rather than polling.  This
+    ///        requires the database be a replica set - a single-node
+    ///        replica set suffices.  If the change stream cannot be opened
+    ///        then the catalog falls back to polling and periodically
+    ///        tries again.
+    void enableChangeStream() noexcept;
+    /// @brief Polls the events collection for changes.  This is the default.
+    /// @note An open change stream is closed within a few seconds.
+    void disableChangeStream() noexcept;
+    /// @result True indicates the catalog should be updated from a change
+    ///         stream.
+    [[nodiscard]] bool isChangeStreamEnabled() const noexcept;
+
+    /// @brief Sets the number of exports that can run at once.  Each export
+    ///        holds a database client for as long as the download takes so
+    ///        this should be well below the database pool size.  Further
+    ///        export requests are refused until one finishes.
+    /// @throws std::invalid_argument if nExports is not positive.
+    void setMaximumNumberOfConcurrentExports(int nExports);
+    /// @result The number of exports that can run at once.  By default
+    ///         this is 4.
+    [[nodiscard]] int getMaximumNumberOfConcurrentExports() const noexcept;
+
     /// @brief Destructor
     ~Resource() override;
     /// @brief Processes the user request.
+    /// @note For the standard catalog, a request with sinceVersion returns
+    ///       only the events upserted and removed since that version.  If
+    ///       the server no longer has those changes then the full catalog
+    ///       is returned.  The full field distinguishes the two.
+    /// @note A request with pageSize returns at most that many events in
+    ///       the window sorted by origin time along with a
+    ///       continuationToken.  Passing the token back returns the next
+    ///       page.  The token is null on the last page.
+    /// @note A request with export set to true streams every event in the
+    ///       window from the database as it is read.  Exports are only
+    ///       available over HTTP and are refused with a 503 error when the
+    ///       maximum number of concurrent exports are running.
+    /// @note Requests can be restricted to events whose epicenters are in
+    ///       a bbox, {minLatitude, minLongitude, maxLatitude, maxLongitude},
+    ///       a named region, or within a radius, {latitude, longitude,
+    ///       distance}, where the distance is in kilometers.  The events
+    ///       in memory are found with a spatial index.
     [[nodiscard]] std::unique_ptr<MLReview::Messages::IMessage> processRequest(const nlohmann::json &request) override;
+    /// @result The catalog version for requests for the standard catalog
+    ///         or its changes since a version.  Other requests are not
+    ///         tagged.
+    [[nodiscard]] std::optional<std::string> getETag(const nlohmann::json &request) const override final;
     /// @result The resource's name.
     [[nodiscard]] std::string getName() const noexcept override final;
     /// @result The resource's documentation.
@@ -1,7 +1,9 @@
 #ifndef MLREVIEW_SERVICE_CATALOG_RESPONSE_HPP
 #define MLREVIEW_SERVICE_CATALOG_RESPONSE_HPP
 #include <memory>
+#include <string>
 #include <optional>
+#include <functional>
 #include <mlReview/messages/message.hpp>
 namespace MLReview::Service::Catalog
 {
@@ -25,6 +27,16 @@ public:
     /// @param[in,out] object  The response data.  On exit, object's behavior
     ///                        is undefined.
     void setData(nlohmann::json &&object) noexcept;
+    /// @brief Sets a function that produces the serialized response data
+    ///        one piece at a time - e.g., while reading a database cursor.
+    ///        When set, this is used instead of the response data.
+    /// @param[in] dataStream  Returns the next piece of serialized data and
+    ///                        nothing when finished.
+    void setDataStream(const std::function<std::optional<std::string> ()> &dataStream) noexcept;
+    /// @brief Sets the response data to already serialized JSON.  This
+    ///        lets many responses share one serialization.
+    /// @param[in] data  The serialized response data.
+    void setSerializedData(const std::shared_ptr<const std::string> &data) noexcept;
     /// @brief Sets the an accompanying message with the response.
     /// @param[in] message   An accompanying response message.
     void setMessage(const std::string &message) noexcept;
@@ -32,6 +44,10 @@ public:
     [[nodiscard]] std::optional<std::string> getMessage() const noexcept override final;
     /// @result The data portion of the response message.
     [[nodiscard]] std::optional<nlohmann::json> getData() const noexcept override final;
+    /// @result The function that produces the serialized response data.
+    ///         This is set by \c setDataStream() or
+    ///         \c setSerializedData() otherwise null.
+    [[nodiscard]] std::function<std::optional<std::string> ()> getDataStream() const noexcept override final;
 
     ~Response() override;
 private:
@@ -0,0 +1,87 @@
+#ifndef MLREVIEW_SERVICE_GEOFENCE_HPP
+#define MLREVIEW_SERVICE_GEOFENCE_HPP
+#include <array>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+namespace MLReview::Service
+{
+/// @class Geofence "geofence.hpp" "mlReview/service/geofence.hpp"
+/// @brief A set of named regions, e.g., authoritative regions, against
+///        which points can be classified.  The region polygons are built
+///        once when the region is added and indexed by their bounding boxes
+///        so that classifying a point only tests the polygons that could
+///        contain it.
+/// @note After the regions are added the geofence can be shared by many
+///       threads.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class Geofence
+{
+public:
+    /// @brief Constructor.  There are no regions.
+    Geofence();
+    /// @brief Copy constructor.
+    /// @param[in] geofence  The geofence from which to initialize this class.
+    Geofence(const Geofence &geofence);
+    /// @brief Move constructor.
+    /// @param[in,out] geofence  The geofence from which to initialize this
+    ///                          class.  On exit, geofence's behavior is
+    ///                          undefined.
+    Geofence(Geofence &&geofence) noexcept;
+
+    /// @brief Adds a region.
+    /// @param[in] name      The region's name - e.g., utah.
+    /// @param[in] vertices  The (latitude, longitude) pairs in degrees that
+    ///                      define the region's boundary.  The polygon is
+    ///                      closed if the last vertex is not the first.
+    /// @throws std::invalid_argument if the name is empty or exists, there
+    ///         are fewer than three vertices, or a latitude is not in the
+    ///         range [-90,90].
+    void addRegion(const std::string &name,
+                   const std::vector<std::pair<double, double>> &vertices);
+    /// @brief Adds the regions defined in an initialization file.  Each
+    ///        section is a region and its polygon key is a whitespace
+    ///        separated list of latitude,longitude vertices - e.g.,
+    ///        [utah]
+    ///        polygon = 36.75,-114.25 36.75,-108.75 42.5,-108.75 42.5,-114.25
+    /// @throws std::invalid_argument if the file does not exist or a region
+    ///         is invalid.
+    void load(const std::filesystem::path &initializationFile);
+    /// @result The region names in the order they were added.
+    [[nodiscard]] std::vector<std::string> getRegions() const noexcept;
+    /// @result True indicates the region exists.
+    [[nodiscard]] bool haveRegion(const std::string &name) const noexcept;
+    /// @result The region's bounding box as {minimum latitude,
+    ///         minimum longitude, maximum latitude, maximum longitude}.
+    /// @throws std::invalid_argument if the region does not exist.
+    [[nodiscard]] std::array<double, 4> getBoundingBox(const std::string &name) const;
+
+    /// @result True indicates the point is in the region.
+    /// @throws std::invalid_argument if the region does not exist or the
+    ///         latitude is not in the range [-90,90].
+    [[nodiscard]] bool isInRegion(const std::string &name,
+                                  double latitude, double longitude) const;
+    /// @result The name of the first region, in the order the regions were
+    ///         added, that contains the point or an empty string if no
+    ///         region contains the point.
+    /// @throws std::invalid_argument if the latitude is not in the range
+    ///         [-90,90].
+    [[nodiscard]] std::string classify(double latitude, double longitude) const;
+    /// @result The classification of each (latitude, longitude) point.
+    /// @throws std::invalid_argument if a latitude is not in the range
+    ///         [-90,90].
+    [[nodiscard]] std::vector<std::string> classify(const std::vector<std::pair<double, double>> &points) const;
+
+    /// @brief Destructor.
+    ~Geofence();
+    /// @brief Copy assignment.
+    Geofence& operator=(const Geofence &geofence);
+    /// @brief Move assignment.
+    Geofence& operator=(Geofence &&geofence) noexcept;
+private:
+    class GeofenceImpl;
+    std::unique_ptr<GeofenceImpl> pImpl;
+};
+}
+#endif
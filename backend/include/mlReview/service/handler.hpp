@@ -1,6 +1,10 @@
 #ifndef MLREVIEW_SERVICE_HANDLER_HPP
 #define MLREVIEW_SERVICE_HANDLER_HPP
 #include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
 #include <mlReview/messages/message.hpp>
 namespace MLReview::Service
 {
@@ -24,13 +28,37 @@ public:
     /// @brief Processes a request.
     /// @param[in] request  The input request message - this can be binary
     ///                     (e.g., CBOR) or string data (e.g., JSON).
+    /// @note If the request's ifNoneMatch field matches the resource's
+    ///       current ETag then a 304 message without data is returned.
+    ///       Otherwise, the response carries the resource's ETag if it has
+    ///       one.
     [[nodiscard]] std::unique_ptr<MLReview::Messages::IMessage> process(const std::string &request) const;
 
+    /// @result A tag identifying the version of the data the request would
+    ///         return or nothing if the resource does not tag the request.
+    ///         This does not build the response.
+    [[nodiscard]] std::optional<std::string> getETag(const std::string &request) const noexcept;
+
     /// @brief Inserts a resource to the handler.
     void insert(std::unique_ptr<IResource > &&resource);
 
     [[nodiscard]] std::vector<std::string> getResources() const noexcept;
 
+    /// @brief Subscribes to a resource's changes.
+    /// @param[in] resource  The name of the resource.
+    /// @param[in] callback  The function to call with the serialized
+    ///                      notification whenever the resource changes.
+    /// @result An identifier with which to unsubscribe.
+    /// @throws std::invalid_argument if the resource does not exist or does
+    ///         not support subscriptions.
+    [[nodiscard]] int64_t subscribe(const std::string &resource,
+                                    const std::function<void (const std::shared_ptr<const std::string> &)> &callback) const;
+    /// @brief Removes a subscription to a resource's changes.
+    /// @param[in] resource    The name of the resource.
+    /// @param[in] identifier  The identifier returned by \c subscribe().
+    void unsubscribe(const std::string &resource,
+                     int64_t identifier) const noexcept;
+
     /// @brief Destructor.
     ~Handler();
 
@@ -1,6 +1,9 @@
 #ifndef MLREVIEW_SERVICE_RESOURCE_HPP
 #define MLREVIEW_SERVICE_RESOURCE_HPP
 #include <string>
+#include <memory>
+#include <optional>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include <mlReview/messages/message.hpp>
 namespace MLReview::Service
@@ -26,6 +29,23 @@ public:
     [[nodiscard]] virtual std::string getName() const noexcept = 0;
     /// @result The resource's documentation.
     [[nodiscard]] virtual std::string getDocumentation() const noexcept;
+    /// @result A tag identifying the version of the data the request would
+    ///         return.  This must be cheap to compute since it is used to
+    ///         skip building responses the client already has.  Nothing
+    ///         indicates the response cannot be tagged.  By default the
+    ///         resource does not tag its responses.
+    [[nodiscard]] virtual std::optional<std::string> getETag(const nlohmann::json &request) const;
+    /// @brief Subscribes to the resource's changes.
+    /// @param[in] callback  The function to call with the serialized
+    ///                      notification whenever the resource changes.
+    ///                      This is called from the resource's thread so it
+    ///                      must not block.
+    /// @result An identifier with which to unsubscribe.
+    /// @throws std::invalid_argument if the callback is not set or the
+    ///         resource does not support subscriptions.
+    [[nodiscard]] virtual int64_t subscribe(const std::function<void (const std::shared_ptr<const std::string> &)> &callback);
+    /// @brief Removes the subscription with the given identifier.
+    virtual void unsubscribe(int64_t identifier) noexcept;
 };
 }
 #endif
@@ -1,26 +1,69 @@
 #ifndef MLREVIEW_SERVICE_STATIONS_RESOURCE_HPP
 #define MLREVIEW_SERVICE_STATIONS_RESOURCE_HPP
 #include <memory>
+#include <optional>
+#include <functional>
 #include <mlReview/service/resource.hpp>
 namespace MLReview::Database::Connection
 {
  class PostgreSQL;
 }
+namespace MLReview::Service
+{
+ class Geofence;
+}
+namespace MLReview::WaveServer
+{
+ class ChannelEpochs;
+}
 namespace MLReview::Service::Stations
 {
 /// @class Resource "resource.hpp" "drp/service/stations/resource.hpp"
 /// @brief The station resource is responsible for returning station 
 ///        information.
+/// @note The stations and channels are reloaded from the AQMS database hourly.  Each
+///       load is indexed and serialized once then swapped in whole so
+///       requests never wait on a reload.
 /// @copyright Ben Baker (University of Utah) distributed under the MIT license.
 class Resource : public MLReview::Service::IResource
 {
 public:
     explicit Resource(std::shared_ptr<MLReview::Database::Connection::PostgreSQL> &postgresClient);
 
+    /// @brief Sets the regions that requests can filter on by name.
+    /// @note This should be set before requests are processed.
+    void setGeofence(const std::shared_ptr<const MLReview::Service::Geofence> &geofence);
+
+    /// @brief Sets the function that returns an event's (latitude, longitude)
+    ///        so that the nearest stations can be requested by event.
+    /// @note This should be set before requests are processed.
+    void setEpicenterCallback(const std::function<std::optional<std::pair<double, double>> (int64_t)> &callback);
+
+    /// @result The channel epochs from the most recent refresh - e.g., to
+    ///         plan waveform requests with a MultiClient.
+    [[nodiscard]] std::shared_ptr<const MLReview::WaveServer::ChannelEpochs> getChannelEpochs() const noexcept;
+
     /// @brief Destructor
     ~Resource() override;
     /// @brief Processes the user request.
+    /// @note Requests can be restricted to stations in a bbox, a named
+    ///       region, or within a radius as for the catalog.
+    /// @note A request with
+    ///       "nearest": {"identifier": event, "count": K} or
+    ///       "nearest": {"latitude": , "longitude": , "count": K}
+    ///       returns the K active stations closest to the event's epicenter
+    ///       or the point ordered by distance.  Each station has its
+    ///       geodesic distance in km, the azimuth from the source to the
+    ///       station, and the back azimuth from the station to the source
+    ///       in degrees.  Results for events are cached.
+    /// @note A request with
+    ///       "channels": {"network": , "station": , "time": }
+    ///       returns the station's channel epochs.  If the time, in UTC
+    ///       seconds, is given then only the channels operating at that
+    ///       time are returned.
     [[nodiscard]] std::unique_ptr<MLReview::Messages::IMessage> processRequest(const nlohmann::json &request) override;
+    /// @result A hash of the station list and the requested filters.
+    [[nodiscard]] std::optional<std::string> getETag(const nlohmann::json &request) const override final;
     /// @result The resource's name.
     [[nodiscard]] std::string getName() const noexcept override final;
     /// @result The resource's documentation.
@@ -1,7 +1,9 @@
 #ifndef MLREVIEW_SERVICE_STATIONS_RESPONSE_HPP
 #define MLREVIEW_SERVICE_STATIONS_RESPONSE_HPP
 #include <memory>
+#include <string>
 #include <optional>
+#include <functional>
 #include <mlReview/messages/message.hpp>
 namespace MLReview::Service::Stations
 {
@@ -25,6 +27,10 @@ public:
     /// @param[in,out] object  The response data.  On exit, object's behavior
     ///                        is undefined.
     void setData(nlohmann::json &&object) noexcept;
+    /// @brief Sets the response data to already serialized JSON.  This
+    ///        lets many responses share one serialization.
+    /// @param[in] data  The serialized response data.
+    void setSerializedData(const std::shared_ptr<const std::string> &data) noexcept;
     /// @brief Sets the an accompanying message with the response.
     /// @param[in] message   An accompanying response message.
     void setMessage(const std::string &message) noexcept;
@@ -32,6 +38,9 @@ public:
     [[nodiscard]] std::optional<std::string> getMessage() const noexcept override final;
     /// @result The data portion of the response message.
     [[nodiscard]] std::optional<nlohmann::json> getData() const noexcept override final;
+    /// @result The serialized data if it was set with
+    ///         \c setSerializedData() otherwise null.
+    [[nodiscard]] std::function<std::optional<std::string> ()> getDataStream() const noexcept override final;
 
     ~Response() override;
 private:
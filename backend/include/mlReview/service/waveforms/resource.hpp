@@ -1,6 +1,8 @@
 #ifndef MLREVIEW_SERVICE_WAVEFORMS_RESOURCE_HPP
 #define MLREVIEW_SERVICE_WAVEFORMS_RESOURCE_HPP
 #include <memory>
+#include <vector>
+#include <functional>
 #include <mlReview/service/resource.hpp>
 namespace MLReview::Database::Connection
 {
@@ -18,10 +20,25 @@ class Resource : public MLReview::Service::IResource
 public:
     explicit Resource(std::shared_ptr<MLReview::Database::Connection::MongoDB> &mongoClient);
 
+    /// @brief Queues events whose waveforms should be loaded into the cache
+    ///        before they are requested - e.g., events that just entered the
+    ///        catalog.  The waveforms are loaded by low-priority background
+    ///        threads that back off while reviewers' requests are running.
+    /// @param[in] identifiers  The event identifiers.
+    void prefetch(const std::vector<int64_t> &identifiers);
+    /// @result A function that queues events for prefetching.  This is
+    ///         intended for other resources, such as the catalog, and can
+    ///         safely outlive this resource in which case it does nothing.
+    [[nodiscard]] std::function<void (const std::vector<int64_t> &)> getPrefetchCallback() const;
+
     /// @brief Destructor
     ~Resource() override;
     /// @brief Processes the user request.
     [[nodiscard]] std::unique_ptr<MLReview::Messages::IMessage> processRequest(const nlohmann::json &request) override;
+    /// @result A hash of the event's waveforms if they are in the cache.
+    ///         Otherwise, the request is not tagged until the waveforms
+    ///         are loaded.
+    [[nodiscard]] std::optional<std::string> getETag(const nlohmann::json &request) const override final;
     /// @result The resource's name.
     [[nodiscard]] std::string getName() const noexcept override final;
     /// @result The resource's documentation.
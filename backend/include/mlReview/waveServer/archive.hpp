@@ -0,0 +1,67 @@
+#ifndef MLREVIEW_WAVE_SERVER_ARCHIVE_HPP
+#define MLREVIEW_WAVE_SERVER_ARCHIVE_HPP
+#include <memory>
+#include <filesystem>
+#include <mlReview/waveServer/client.hpp>
+namespace MLReview::WaveServer
+{
+/// @class Archive "archive.hpp" "mlReview/waveServer/archive.hpp"
+/// @brief Serves data from a local directory of miniSEED day-files in the
+///        SeisComP Data Structure (SDS) layout, i.e.,
+///        YEAR/NET/STA/CHAN.D/NET.STA.LOC.CHAN.D.YEAR.DAY
+///        Files are memory-mapped and each file's records are indexed by
+///        time.  The index is built on first use and saved next to the
+///        file with an .idx extension so that subsequent uses need not
+///        rescan the file.
+/// @note Optionally, the archive can be given a write-through client.
+///       Requests that the archive cannot satisfy are forwarded to that
+///       client and the returned data is appended to the archive.  This
+///       lets re-reviews run without the network.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class Archive final : public IClient
+{
+public:
+    Archive() = delete;
+    /// @brief Constructor.
+    /// @param[in] directory  The root directory of the archive.  This will
+    ///                       be created if it does not exist.
+    /// @throws std::invalid_argument if the directory exists but is not a
+    ///         directory.
+    explicit Archive(const std::filesystem::path &directory);
+
+    /// @brief Sets the client to query when the archive does not have the
+    ///        data.  Data obtained from this client is appended to the
+    ///        archive.
+    /// @param[in,out] client  The write-through client - e.g., a MultiClient
+    ///                        of the remote sources.  On exit, the archive
+    ///                        takes ownership of the client.
+    void setWriteThroughClient(std::unique_ptr<IClient> &&client);
+    /// @result True indicates a write-through client was set.
+    [[nodiscard]] bool haveWriteThroughClient() const noexcept;
+
+    /// @brief Appends the waveform's data to the archive.  Samples already
+    ///        in the archive are not written again.
+    /// @throws std::invalid_argument if the waveform's network, station, or
+    ///         channel is not set.
+    /// @note This is thread safe.
+    void write(const Waveform &waveform);
+
+    /// @result The archive's root directory.
+    [[nodiscard]] std::filesystem::path getDirectory() const noexcept;
+    /// @brief Fetches the data from the archive and, if necessary and set,
+    ///        the write-through client.
+    /// @note This is thread safe.
+    [[nodiscard]] Waveform getData(const Request &request) const override final;
+    /// @result The client type which is Archive.
+    [[nodiscard]] std::string getType() const noexcept final;
+    /// @brief Destructor.
+    ~Archive() override;
+
+    Archive(const Archive &) = delete;
+    Archive& operator=(const Archive &) = delete;
+private:
+    class ArchiveImpl;
+    std::unique_ptr<ArchiveImpl> pImpl;
+};
+}
+#endif
@@ -0,0 +1,88 @@
+#ifndef MLREVIEW_WAVE_SERVER_CHANNEL_EPOCHS_HPP
+#define MLREVIEW_WAVE_SERVER_CHANNEL_EPOCHS_HPP
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <optional>
+namespace MLReview::WaveServer
+{
+ class Request;
+}
+namespace MLReview::WaveServer
+{
+/// @class ChannelEpochs "channelEpochs.hpp" "mlReview/waveServer/channelEpochs.hpp"
+/// @brief The operating epochs of channels - e.g., from the AQMS channel
+///        tables.  The epochs are held in one vector sorted by channel
+///        then on date so a channel's epoch at a given time is found with
+///        a binary search.
+/// @note After construction this is read only so it can be shared by many
+///       threads.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class ChannelEpochs
+{
+public:
+    /// @brief A period over which a channel operated.
+    struct Epoch
+    {
+        std::string network;       /*!< The network - e.g., UU. */
+        std::string station;       /*!< The station - e.g., CTU. */
+        std::string channel;       /*!< The channel - e.g., HHZ. */
+        std::string locationCode;  /*!< The location code - e.g., 01.  This
+                                        is empty when there is none. */
+        double samplingRate{0};    /*!< The sampling rate in Hz. */
+        std::chrono::microseconds onDate{0};  /*!< The epoch's start (UTC). */
+        std::chrono::microseconds offDate{0}; /*!< The epoch's end (UTC). */
+    };
+
+    /// @brief Constructor.  There are no epochs.
+    ChannelEpochs();
+    /// @brief Constructs from the given epochs.
+    /// @param[in,out] epochs  The channel epochs.  On exit, epochs's
+    ///                        behavior is undefined.
+    /// @throws std::invalid_argument if an epoch's network, station, or
+    ///         channel is empty or its off date precedes its on date.
+    explicit ChannelEpochs(std::vector<Epoch> &&epochs);
+    /// @brief Copy constructor.
+    ChannelEpochs(const ChannelEpochs &epochs);
+    /// @brief Move constructor.
+    ChannelEpochs(ChannelEpochs &&epochs) noexcept;
+
+    /// @result The number of epochs.
+    [[nodiscard]] size_t size() const noexcept;
+    /// @result True indicates there are epochs for the station.
+    [[nodiscard]] bool haveStation(const std::string &network,
+                                   const std::string &station) const noexcept;
+    /// @result The channel's epoch that contains the given time or nothing
+    ///         if the channel was not operating at that time.
+    [[nodiscard]] std::optional<Epoch> find(const std::string &network,
+                                            const std::string &station,
+                                            const std::string &channel,
+                                            const std::string &locationCode,
+                                            const std::chrono::microseconds &time) const;
+    /// @result The station's channel epochs sorted by channel then on date.
+    ///         If a time is given then only the epochs that contain it are
+    ///         returned.
+    [[nodiscard]] std::vector<Epoch> getEpochs(const std::string &network,
+                                               const std::string &station,
+                                               const std::optional<std::chrono::microseconds> &time = std::nullopt) const;
+    /// @result False indicates the request's station is known and none of
+    ///         the channel's epochs overlap the request's time window so
+    ///         there is no point in asking a wave server for its data.
+    ///         Channels of unknown stations are assumed to have data.
+    /// @throws std::runtime_error if the request's network, station,
+    ///         channel, or times are not set.
+    [[nodiscard]] bool mayHaveData(const Request &request) const;
+
+    /// @brief Destructor.
+    ~ChannelEpochs();
+    /// @brief Copy assignment.
+    ChannelEpochs& operator=(const ChannelEpochs &epochs);
+    /// @brief Move assignment.
+    ChannelEpochs& operator=(ChannelEpochs &&epochs) noexcept;
+private:
+    class ChannelEpochsImpl;
+    std::unique_ptr<ChannelEpochsImpl> pImpl;
+};
+}
+#endif
@@ -14,8 +14,20 @@ class IClient
 {
 public:
     virtual ~IClient();
+    /// @brief Fetches the data for many requests.
+    /// @result result[i] is the waveform corresponding to requests[i].  If
+    ///         the request failed or found no data then result[i] will
+    ///         have no segments.
+    /// @throws std::runtime_error if every request failed.  Finding no data
+    ///         is not a failure.
     [[nodiscard]] virtual std::vector<Waveform> getData(const std::vector<Request> &requests) const;
     [[nodiscard]] virtual Waveform getData(const Request &request) const = 0;
+    /// @result True indicates the client's batched getData schedules the
+    ///         requests itself (e.g., it bounds its own concurrency or
+    ///         collects the batch in a single pass) so the whole batch should
+    ///         be handed to it in one call rather than split into chunks.
+    ///         By default this is false.
+    [[nodiscard]] virtual bool batchesRequests() const noexcept;
     [[nodiscard]] virtual std::string getType() const noexcept = 0;
 };
 }
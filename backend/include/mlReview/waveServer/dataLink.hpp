@@ -14,13 +14,34 @@ public:
     /// @brief Constructor. 
     /// @param[in] url         The URL of the DataLink server.
     /// @param[in] clientName  The name of this client.
+    /// @param[in] maximumNumberOfConnections  The maximum number of
+    ///                                        persistent connections to the
+    ///                                        server.  This bounds the number
+    ///                                        of threads that can
+    ///                                        simultaneously fetch data.
     explicit DataLink(const std::string &url,
-                      const std::string &clientName = "DataLinkClient");
+                      const std::string &clientName = "DataLinkClient",
+                      int maximumNumberOfConnections = 4);
 
-    /// @result True indicates the client is connected.
+    /// @result True indicates the client holds an idle connection to the
+    ///         server.
     [[nodiscard]] bool isConnected() const noexcept;
+    /// @brief Fetches the data for many streams.  Rather than making one
+    ///        pass over the ring per stream, the streams are matched in
+    ///        bounded batches and each batch is collected in a single pass.
+    /// @param[in] requests  The waveform requests.
+    /// @result result[i] is the waveform corresponding to requests[i].  If
+    ///         no data was found or the request failed then result[i] will
+    ///         have no segments.
+    /// @throws std::runtime_error if every request failed.
+    /// @note This is thread safe.
+    [[nodiscard]] std::vector<Waveform> getData(const std::vector<Request> &requests) const override final;
     /// @brief Fetches the data from the DataLink client.
+    /// @note This is thread safe.
     [[nodiscard]] Waveform getData(const Request &request) const override final;
+    /// @result True since a batch is collected in a single pass over
+    ///         the ring.
+    [[nodiscard]] bool batchesRequests() const noexcept final;
     /// @result The client type which is DataLink
     [[nodiscard]] std::string getType() const noexcept final;
     /// @brief Destructor.
@@ -1,6 +1,7 @@
 #ifndef MLREVIEW_WAVE_SERVER_FDSN_HPP
 #define MLREVIEW_WAVE_SERVER_FDSN_HPP
 #include <mlReview/waveServer/client.hpp>
+#include <functional>
 #include <memory>
 namespace MLReview::WaveServer
 {
@@ -14,7 +15,36 @@ public:
     FDSN(); 
     explicit FDSN(const std::string &url);
 
+    /// @brief Sets the maximum number of requests that can be in flight
+    ///        to the FDSN server at any one time.
+    /// @param[in] nRequests  The maximum number of concurrent requests.
+    /// @throws std::invalid_argument if nRequests is not positive.
+    void setMaximumNumberOfConcurrentRequests(int nRequests);
+    /// @result The maximum number of concurrent requests.  By default this
+    ///         is 8.
+    [[nodiscard]] int getMaximumNumberOfConcurrentRequests() const noexcept;
+
+    /// @brief Fetches the data for many requests concurrently.
+    /// @param[in] requests  The waveform requests.
+    /// @result result[i] is the waveform corresponding to requests[i].  If
+    ///         the request failed or found no data then result[i] will
+    ///         have no segments.
+    /// @throws std::runtime_error if every request failed.
+    [[nodiscard]] std::vector<Waveform> getData(const std::vector<Request> &requests) const final;
+    /// @brief Fetches the data for many requests concurrently and returns
+    ///        each waveform as its request completes.
+    /// @param[in] requests  The waveform requests.
+    /// @param[in] callback  Invoked with the index of the request and its
+    ///                      waveform in the order that the requests complete.
+    ///                      Failed requests are reported with an empty
+    ///                      waveform.
+    void getData(const std::vector<Request> &requests,
+                 const std::function<void (size_t, Waveform &&)> &callback) const;
+    /// @brief Fetches the data for a single request.
     [[nodiscard]] Waveform getData(const Request &request) const final;
+    /// @result True since the batched requests share this client's
+    ///         concurrency limit.
+    [[nodiscard]] bool batchesRequests() const noexcept final;
     /// @result The client type which is FDSN.
     [[nodiscard]] std::string getType() const noexcept final;
     /// @brief Destrutor.
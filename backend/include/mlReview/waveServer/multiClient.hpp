@@ -1,20 +1,108 @@
 #ifndef MLREVIEW_WAVE_SERVER_MULTI_CLIENT_HPP
 #define MLREVIEW_WAVE_SERVER_MULTI_CLIENT_HPP
 #include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
 #include <mlReview/waveServer/client.hpp>
 namespace MLReview::WaveServer
 {
  class Waveform;
+ class ChannelEpochs;
 }
 namespace MLReview::WaveServer
 {
 class MultiClient final : public IClient
 {
 public:
+    /// @brief The state of a client's circuit breaker.
+    enum class CircuitState
+    {
+        Closed,   /*!< The client is healthy and receives requests. */
+        Open,     /*!< The client is failing and is skipped. */
+        HalfOpen  /*!< A probe request will decide whether the client
+                       is healthy again. */
+    };
+    /// @brief A snapshot of a client's health.
+    struct ClientHealth
+    {
+        std::string type;  /*!< The client type - e.g., FDSN. */
+        int priority{0};   /*!< The client's priority. */
+        CircuitState state{CircuitState::Closed}; /*!< The circuit's state. */
+        double errorRate{0}; /*!< The fraction of recent requests that
+                                  failed or were too slow. */
+        std::chrono::microseconds latency95{0}; /*!< The 95th percentile
+                                                     latency of recent
+                                                     requests. */
+    };
+
     MultiClient();
     void insert(std::unique_ptr<IClient> &&client, int priority);
+    /// @brief Sets the number of threads across which a batch of requests
+    ///        is split when handed to a client.  Clients that batch
+    ///        requests themselves (see IClient::batchesRequests()) are
+    ///        always handed the whole batch.  This also bounds the number
+    ///        of hedged requests that run at once against each client.  A
+    ///        client with that many hedged requests still running is
+    ///        skipped.
+    /// @param[in] nRequests  The maximum number of concurrent requests.
+    /// @throws std::invalid_argument if nRequests is not positive.
+    /// @note This should not be called while requests are in progress.
+    void setMaximumNumberOfConcurrentRequests(int nRequests);
+    /// @result The maximum number of concurrent requests.  By default this
+    ///         is 8.
+    [[nodiscard]] int getMaximumNumberOfConcurrentRequests() const noexcept;
+    /// @brief Enables hedged requests.  Rather than waiting on each client
+    ///        in turn, the highest priority client is launched and, if it
+    ///        has not answered within the hedge delay, the next client is
+    ///        launched as well.  The first sufficiently complete result
+    ///        wins and the outstanding requests are abandoned.
+    /// @param[in] hedgeDelay  The time to wait on a client before launching
+    ///                        the next.  If zero then each client's
+    ///                        observed 95th percentile latency is used.
+    /// @note This applies to single requests.
+    void enableHedging(const std::chrono::milliseconds &hedgeDelay = std::chrono::milliseconds {0});
+    /// @brief Clients are queried in sequence by priority.  This is the
+    ///        default.
+    void disableHedging() noexcept;
+    /// @result True indicates hedged requests are enabled.
+    [[nodiscard]] bool isHedgingEnabled() const noexcept;
+    /// @result The health of each client in priority order.  A client whose
+    ///         recent requests mostly fail or time out has its circuit
+    ///         opened and is skipped until a probe request succeeds.
+    ///         Requests that find no data are not failures.
+    /// @note While requests are being made the health is also logged every
+    ///       five minutes.
+    [[nodiscard]] std::vector<ClientHealth> getClientHealth() const;
+    /// @brief Sets how long a failing client is skipped before it is
+    ///        probed.
+    /// @throws std::invalid_argument if the duration is negative.
+    void setCircuitOpenDuration(const std::chrono::seconds &openDuration);
+    /// @result How long a failing client is skipped.  By default this is
+    ///         30 seconds.
+    [[nodiscard]] std::chrono::seconds getCircuitOpenDuration() const noexcept;
+    /// @brief Enables gap-filling.  Rather than keeping the single most
+    ///        complete waveform, each client is asked, in priority order,
+    ///        for only the intervals that are still missing and the
+    ///        results are stitched into one waveform.  Where sources
+    ///        overlap the higher priority source's data is kept.
+    void enableStitching() noexcept;
+    /// @brief Keeps the single most complete waveform.  This is the default.
+    void disableStitching() noexcept;
+    /// @result True indicates gap-filling is enabled.
+    [[nodiscard]] bool isStitchingEnabled() const noexcept;
+    /// @brief Sets the channel epochs used to plan requests.  Requests for
+    ///        channels of known stations that were not operating during
+    ///        the request's window are not sent to any client and get an
+    ///        empty waveform.
+    /// @param[in] channelEpochs  The channel epochs.  If null then every
+    ///                           request is sent.
+    /// @note This can be called while requests are in progress - e.g.,
+    ///       when the channel metadata is refreshed.
+    void setChannelEpochs(const std::shared_ptr<const ChannelEpochs> &channelEpochs) noexcept;
     [[nodiscard]] std::vector<Waveform> getData(const std::vector<Request> &requests) const override final;
     [[nodiscard]] Waveform getData(const Request &request) const override final;
+    [[nodiscard]] bool batchesRequests() const noexcept override final;
     [[nodiscard]] std::string getType() const noexcept override final;
     ~MultiClient() override;
 private:
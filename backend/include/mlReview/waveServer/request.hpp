@@ -4,6 +4,7 @@
 #include <chrono>
 #include <string>
 #include <optional>
+#include <functional>
 namespace MLReview::WaveServer
 {
 /// @name Request "request.hpp" "mlReview/waveServer/request.hpp"
@@ -111,4 +112,11 @@ private:
 bool operator==(const Request &lhs, const Request &rhs);
 bool operator!=(const Request &lhs, const Request &rhs);
 }
+/// @brief Hashes a request so that it can be used as a key in unordered
+///        containers.  Requests that compare equal hash equally.
+template<>
+struct std::hash<MLReview::WaveServer::Request>
+{
+    [[nodiscard]] size_t operator()(const MLReview::WaveServer::Request &request) const noexcept;
+};
 #endif
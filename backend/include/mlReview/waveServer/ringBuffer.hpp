@@ -0,0 +1,58 @@
+#ifndef MLREVIEW_WAVE_SERVER_RING_BUFFER_HPP
+#define MLREVIEW_WAVE_SERVER_RING_BUFFER_HPP
+#include <memory>
+#include <chrono>
+#include <mlReview/waveServer/client.hpp>
+namespace MLReview::WaveServer
+{
+/// @class RingBuffer "ringBuffer.hpp" "mlReview/waveServer/ringBuffer.hpp"
+/// @brief Holds the most recent data for a set of streams in memory.  The
+///        buffer is fed by a long-lived subscription to a DataLink
+///        (ring)server and requests that are covered by the buffer are
+///        answered without touching the network.  Since this is the
+///        cheapest source it should be given the highest priority in a
+///        MultiClient.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class RingBuffer final : public IClient
+{
+public:
+    RingBuffer() = delete;
+    /// @brief Constructor.  This subscribes to the server and begins
+    ///        filling the buffer.
+    /// @param[in] url           The URL of the DataLink server.
+    /// @param[in] matchPattern  A regular expression of the DataLink stream
+    ///                          identifiers to buffer - e.g.,
+    ///                          ^UU_.*_(HH|EN)[ZNE12]/MSEED$
+    /// @param[in] duration      The amount of data to retain per stream.
+    /// @param[in] clientName    The name of this client.
+    /// @throws std::invalid_argument if the url or match pattern is empty
+    ///         or the duration is not positive.
+    RingBuffer(const std::string &url,
+               const std::string &matchPattern,
+               const std::chrono::seconds &duration = std::chrono::minutes {60},
+               const std::string &clientName = "RingBufferClient");
+
+    /// @result True indicates the subscription is connected.
+    [[nodiscard]] bool isConnected() const noexcept;
+    /// @result The amount of data retained per stream.
+    [[nodiscard]] std::chrono::seconds getDuration() const noexcept;
+    /// @result The number of streams currently in the buffer.
+    [[nodiscard]] int getNumberOfStreams() const noexcept;
+    /// @brief Fetches the data from the buffer.
+    /// @result The waveform.  If the buffer holds no data for the request
+    ///         then there will be no segments.
+    /// @note This is thread safe.
+    [[nodiscard]] Waveform getData(const Request &request) const override final;
+    /// @result The client type which is RingBuffer.
+    [[nodiscard]] std::string getType() const noexcept final;
+    /// @brief Destructor.
+    ~RingBuffer() override;
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer& operator=(const RingBuffer &) = delete;
+private:
+    class RingBufferImpl;
+    std::unique_ptr<RingBufferImpl> pImpl;
+};
+}
+#endif
@@ -1,7 +1,12 @@
 #include <iostream>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 #include <bsoncxx/json.hpp>
 #include <mongocxx/client.hpp>
+#include <mongocxx/instance.hpp>
+#include <mongocxx/pool.hpp>
 #include <mongocxx/uri.hpp>
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
@@ -9,15 +14,92 @@
 
 using namespace MLReview::Database::Connection;
 
-class MongoDB::MongoDBImpl
+namespace
+{
+/// The pool and its usage.  Leases share this so the pool outlives every
+/// client taken from it.
+struct PoolState
+{
+    explicit PoolState(const mongocxx::uri &uri) :
+        pool(uri)
+    {
+    }
+    void recordWait(const std::chrono::microseconds &waitTime)
+    {
+        nWaits.fetch_add(1);
+        totalWaitTime.fetch_add(waitTime.count());
+        auto maximum = maximumWaitTime.load();
+        while (waitTime.count() > maximum &&
+               !maximumWaitTime.compare_exchange_weak(maximum,
+                                                      waitTime.count()))
+        {
+        }
+    }
+    mongocxx::pool pool;
+    std::atomic<int64_t> nLeases{0};
+    std::atomic<int> nLeased{0};
+    std::atomic<int64_t> nWaits{0};
+    std::atomic<int64_t> totalWaitTime{0};
+    std::atomic<int64_t> maximumWaitTime{0};
+};
+}
+
+class MongoDB::Lease::LeaseImpl
 {
 public:
-    MongoDBImpl()
+    LeaseImpl(std::shared_ptr<::PoolState> state,
+              mongocxx::pool::entry &&entry) :
+        mState(std::move(state)),
+        mEntry(std::move(entry))
     {
-        mSessionPtr = &mSession;
+        mState->nLeases.fetch_add(1);
+        mState->nLeased.fetch_add(1);
     }
-    mongocxx::client mSession;
-    void *mSessionPtr{nullptr};
+    ~LeaseImpl()
+    {
+        // Return the client before the pool can go away
+        mEntry.reset();
+        mState->nLeased.fetch_sub(1);
+    }
+    std::shared_ptr<::PoolState> mState{nullptr};
+    mongocxx::pool::entry mEntry;
+};
+
+/// Lease constructor
+MongoDB::Lease::Lease(std::unique_ptr<LeaseImpl> &&pImplIn) :
+    pImpl(std::move(pImplIn))
+{
+}
+
+/// Lease move constructor
+MongoDB::Lease::Lease(Lease &&lease) noexcept
+{
+    *this = std::move(lease);
+}
+
+/// Lease move assignment
+MongoDB::Lease& MongoDB::Lease::operator=(Lease &&lease) noexcept
+{
+    if (&lease == this){return *this;}
+    pImpl = std::move(lease.pImpl);
+    return *this;
+}
+
+/// Lease destructor
+MongoDB::Lease::~Lease() = default;
+
+/// Leased client
+std::uintptr_t MongoDB::Lease::getSession() const noexcept
+{
+    if (!pImpl){return 0;}
+    return reinterpret_cast<std::uintptr_t> (pImpl->mEntry.get());
+}
+
+class MongoDB::MongoDBImpl
+{
+public:
+    std::shared_ptr<::PoolState> mPoolState{nullptr};
+    std::chrono::milliseconds mSlowWaitThreshold{100};
     std::string mConnectionString;
     std::string mUser;
     std::string mPassword;
@@ -25,6 +107,9 @@ public:
     std::string mAddress;
     std::string mApplication{"drp"};
     int mPort{27017};
+    int mMinimumPoolSize{1};
+    std::chrono::milliseconds mAcquireTimeout{10000};
+    int mMaximumPoolSize{16};
 };
 
 /// Constructor
@@ -161,6 +246,52 @@ std::string MongoDB::getApplication() const noexcept
     return pImpl->mApplication;
 }
 
+/// Pool size
+void MongoDB::setMinimumPoolSize(const int nClients)
+{
+    if (nClients < 0)
+    {
+        throw std::invalid_argument("Minimum pool size cannot be negative");
+    }
+    pImpl->mConnectionString.clear();
+    pImpl->mMinimumPoolSize = nClients;
+}
+
+int MongoDB::getMinimumPoolSize() const noexcept
+{
+    return pImpl->mMinimumPoolSize;
+}
+
+void MongoDB::setMaximumPoolSize(const int nClients)
+{
+    if (nClients < 1)
+    {
+        throw std::invalid_argument("Maximum pool size must be positive");
+    }
+    pImpl->mConnectionString.clear();
+    pImpl->mMaximumPoolSize = nClients;
+}
+
+int MongoDB::getMaximumPoolSize() const noexcept
+{
+    return pImpl->mMaximumPoolSize;
+}
+
+/// Acquire timeout
+void MongoDB::setAcquireTimeout(const std::chrono::milliseconds &timeout)
+{
+    if (timeout.count() <= 0)
+    {
+        throw std::invalid_argument("Acquire timeout must be positive");
+    }
+    pImpl->mAcquireTimeout = timeout;
+}
+
+std::chrono::milliseconds MongoDB::getAcquireTimeout() const noexcept
+{
+    return pImpl->mAcquireTimeout;
+}
+
 /// Drivername
 std::string MongoDB::getDriver() noexcept
 {
@@ -187,6 +318,12 @@ std::string MongoDB::getConnectionString() const
                              + ":" + cPort
                              + "/" + dbname
                              + "?connectTimeoutMS=10000"
+                             + "&minPoolSize="
+                             + std::to_string(getMinimumPoolSize())
+                             + "&maxPoolSize="
+                             + std::to_string(getMaximumPoolSize())
+                             + "&waitQueueTimeoutMS="
+                             + std::to_string(getAcquireTimeout().count())
                              + "&appName=" + appName;
     return pImpl->mConnectionString;
 }
@@ -194,34 +331,95 @@ std::string MongoDB::getConnectionString() const
 /// Connect
 void MongoDB::connect()
 {
+    if (getMinimumPoolSize() > getMaximumPoolSize())
+    {
+        throw std::invalid_argument(
+            "Minimum pool size cannot exceed maximum pool size");
+    }
+    // The driver must be initialized once before any client is created
+    static mongocxx::instance instance{};
     mongocxx::uri uri{getConnectionString()}; // Throws
     try
     {
-        pImpl->mSession = std::move(mongocxx::client {uri});
-        if (!pImpl->mSession)
-        {
-            throw std::runtime_error("Failed to connect to MongoDB");
-        }
+        pImpl->mPoolState = std::make_shared<::PoolState> (uri);
     }
     catch (const std::exception &e)
     {
-        throw std::runtime_error("Failed to connect to postgresql with error:\n"
+        throw std::runtime_error("Failed to connect to MongoDB with error:\n"
                                + std::string{e.what()});
     }
 }
 
 bool MongoDB::isConnected() const noexcept
 {
-    return pImpl->mSession ? true : false;
+    return pImpl->mPoolState != nullptr;
 }
 
 /// Disconnect
 void MongoDB::disconnect()
 {
-    //if (pImpl->mSession.is_connected()){pImpl->mSession.close();}
+    // Outstanding leases keep the pool alive until they are returned
+    pImpl->mPoolState = nullptr;
+}
+
+/// Lease a client
+MongoDB::Lease MongoDB::acquire() const
+{
+    auto state = pImpl->mPoolState;
+    if (!state){throw std::runtime_error("Not connected to MongoDB");}
+    auto entry = state->pool.try_acquire();
+    if (!entry)
+    {
+        // Every client is leased so wait for one to be returned.  The
+        // driver gives up after waitQueueTimeoutMS.
+        auto startTime = std::chrono::steady_clock::now();
+        try
+        {
+            entry = state->pool.acquire();
+        }
+        catch (const std::exception &e)
+        {
+            state->recordWait(
+                std::chrono::duration_cast<std::chrono::microseconds>
+                (std::chrono::steady_clock::now() - startTime));
+            spdlog::warn("Timed out waiting for a MongoDB client; "
+                       + std::to_string(state->nLeased.load())
+                       + " of " + std::to_string(getMaximumPoolSize())
+                       + " clients are leased");
+            throw std::runtime_error("No MongoDB client available after "
+                                   + std::to_string(getAcquireTimeout().count())
+                                   + " ms");
+        }
+        auto waitTime
+            = std::chrono::duration_cast<std::chrono::microseconds>
+              (std::chrono::steady_clock::now() - startTime);
+        state->recordWait(waitTime);
+        if (waitTime > pImpl->mSlowWaitThreshold)
+        {
+            spdlog::warn("Waited "
+                       + std::to_string(waitTime.count()/1000)
+                       + " ms for a MongoDB client; "
+                       + std::to_string(state->nLeased.load())
+                       + " of " + std::to_string(getMaximumPoolSize())
+                       + " clients are leased");
+        }
+    }
+    return Lease {std::make_unique<Lease::LeaseImpl> (state,
+                                                      std::move(*entry))};
 }
 
-std::uintptr_t MongoDB::getSession() const
+/// Pool statistics
+MongoDB::PoolStatistics MongoDB::getPoolStatistics() const noexcept
 {
-    return reinterpret_cast<std::uintptr_t> (pImpl->mSessionPtr);
+    PoolStatistics result;
+    auto state = pImpl->mPoolState;
+    if (!state){return result;}
+    result.nLeases = state->nLeases.load();
+    result.nLeased = state->nLeased.load();
+    result.nWaits = state->nWaits.load();
+    result.totalWaitTime
+        = std::chrono::microseconds {state->totalWaitTime.load()};
+    result.maximumWaitTime
+        = std::chrono::microseconds {state->maximumWaitTime.load()};
+    return result;
 }
@@ -11,12 +11,14 @@
 #include "mlReview/database/connection/postgresql.hpp"
 #include "mlReview/database/connection/mongodb.hpp"
 #include "mlReview/service/handler.hpp"
+#include "mlReview/service/geofence.hpp"
 #include "mlReview/service/actions/acceptEventToAWS.hpp"
 #include "mlReview/service/actions/deleteEventFromAWS.hpp"
 #include "mlReview/service/catalog/resource.hpp"
 #include "mlReview/service/stations/resource.hpp"
 #include "mlReview/service/waveforms/resource.hpp"
 #include "mlReview/webServer/listener.hpp"
+#include "private/regions.hpp"
 
 namespace
 {
@@ -36,7 +38,13 @@ struct ProgramOptions
     boost::asio::ip::address address{boost::asio::ip::make_address("0.0.0.0")};
     std::filesystem::path documentRoot{"./"}; 
     int nThreads{1};
+    int minimumMongoDBPoolSize{1};
+    int maximumMongoDBPoolSize{16};
+    int mongoDBAcquireTimeout{10000};
+    int maximumNumberOfExports{4};
     unsigned short port{80};
+    std::filesystem::path regionsFile;
+    bool useChangeStream{false};
     bool helpOnly{false};
 };
 
@@ -59,7 +67,19 @@ Allowed options)""");
         ("document_root", boost::program_options::value<std::string> ()->default_value("./"),
                     "The document root in case files are served")
         ("n_threads", boost::program_options::value<int> ()->default_value(1),
-                     "The number of threads");
+                     "The number of threads")
+        ("use_change_stream", boost::program_options::value<bool> ()->default_value(false),
+                     "If true then the catalog is updated from a MongoDB change stream rather than by polling.  This requires a replica set.")
+        ("mongodb_minimum_pool_size", boost::program_options::value<int> ()->default_value(1),
+                     "The number of MongoDB clients kept open")
+        ("mongodb_maximum_pool_size", boost::program_options::value<int> ()->default_value(16),
+                     "The maximum number of MongoDB clients.  This should exceed the number of threads plus the background workers.")
+        ("mongodb_acquire_timeout", boost::program_options::value<int> ()->default_value(10000),
+                     "The number of milliseconds to wait for a MongoDB client to be returned to the pool before a request fails")
+        ("maximum_number_of_exports", boost::program_options::value<int> ()->default_value(4),
+                     "The number of catalog exports that can run at once.  Each export holds a MongoDB client for the duration of the download so this should be well below the maximum pool size.")
+        ("regions_file", boost::program_options::value<std::string> (),
+                     "An initialization file defining the regions by which events and stations can be filtered.  By default these are the Utah and Yellowstone authoritative regions.");
     boost::program_options::variables_map vm;
     boost::program_options::store(
         boost::program_options::parse_command_line(argc, argv, desc), vm); 
@@ -98,6 +118,70 @@ Allowed options)""");
         if (nThreads < 1){throw std::invalid_argument("Number of threads must be positive");}
         result.nThreads = nThreads;
     }
+    if (vm.count("use_change_stream"))
+    {
+        result.useChangeStream = vm["use_change_stream"].as<bool> ();
+    }
+    if (vm.count("mongodb_minimum_pool_size"))
+    {
+        result.minimumMongoDBPoolSize
+            = vm["mongodb_minimum_pool_size"].as<int> ();
+    }
+    if (vm.count("mongodb_maximum_pool_size"))
+    {
+        result.maximumMongoDBPoolSize
+            = vm["mongodb_maximum_pool_size"].as<int> ();
+    }
+    if (result.minimumMongoDBPoolSize < 0)
+    {
+        throw std::invalid_argument(
+            "MongoDB minimum pool size cannot be negative");
+    }
+    if (result.maximumMongoDBPoolSize < 1)
+    {
+        throw std::invalid_argument(
+            "MongoDB maximum pool size must be positive");
+    }
+    if (result.minimumMongoDBPoolSize > result.maximumMongoDBPoolSize)
+    {
+        throw std::invalid_argument(
+            "MongoDB minimum pool size cannot exceed maximum pool size");
+    }
+    if (vm.count("mongodb_acquire_timeout"))
+    {
+        result.mongoDBAcquireTimeout
+            = vm["mongodb_acquire_timeout"].as<int> ();
+    }
+    if (result.mongoDBAcquireTimeout < 1)
+    {
+        throw std::invalid_argument(
+            "MongoDB acquire timeout must be positive");
+    }
+    if (vm.count("maximum_number_of_exports"))
+    {
+        result.maximumNumberOfExports
+            = vm["maximum_number_of_exports"].as<int> ();
+    }
+    if (result.maximumNumberOfExports < 1)
+    {
+        throw std::invalid_argument(
+            "Maximum number of exports must be positive");
+    }
+    if (result.maximumNumberOfExports >= result.maximumMongoDBPoolSize)
+    {
+        throw std::invalid_argument(
+            "Maximum number of exports must be less than the MongoDB maximum pool size");
+    }
+    if (vm.count("regions_file"))
+    {
+        auto regionsFile = vm["regions_file"].as<std::string> ();
+        if (!std::filesystem::exists(regionsFile))
+        {
+            throw std::runtime_error("Regions file: " + regionsFile
+                                   + " does not exist");
+        }
+        result.regionsFile = regionsFile;
+    }
     return result;
 }
 
@@ -152,6 +236,10 @@ int main(int argc, char *argv[])
     mongoDatabaseConnection->setAddress(std::getenv("MLREVIEW_MONGODB_DATABASE_HOST"));
     mongoDatabaseConnection->setPort(std::stoi(std::getenv("MLREVIEW_MONGODB_DATABASE_PORT")));
     mongoDatabaseConnection->setApplication("mlReviewClientBackend");
+    mongoDatabaseConnection->setMinimumPoolSize(programOptions.minimumMongoDBPoolSize);
+    mongoDatabaseConnection->setMaximumPoolSize(programOptions.maximumMongoDBPoolSize);
+    mongoDatabaseConnection->setAcquireTimeout(
+        std::chrono::milliseconds {programOptions.mongoDBAcquireTimeout});
     mongoDatabaseConnection->connect();
 
     //getWaveform(*mlDatabaseConnection);
@@ -162,15 +250,46 @@ int main(int argc, char *argv[])
     auto deleteEventFromAWS
         = std::make_unique<MLReview::Service::Actions::DeleteEventFromAWS>
           (mongoDatabaseConnection);
+    // The regions are built once and shared by the resources
+    std::shared_ptr<MLReview::Service::Geofence> geofence;
+    if (programOptions.regionsFile.empty())
+    {
+        geofence = std::make_shared<MLReview::Service::Geofence>
+                   (::createAuthoritativeRegionsGeofence());
+    }
+    else
+    {
+        geofence = std::make_shared<MLReview::Service::Geofence> ();
+        try
+        {
+            geofence->load(programOptions.regionsFile);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::critical("Failed to load regions: "
+                           + std::string {e.what()});
+            return EXIT_FAILURE;
+        }
+    }
     auto catalogResource
         = std::make_unique<MLReview::Service::Catalog::Resource>
           (mongoDatabaseConnection);
+    if (programOptions.useChangeStream){catalogResource->enableChangeStream();}
+    catalogResource->setGeofence(geofence);
+    catalogResource->setMaximumNumberOfConcurrentExports(
+        programOptions.maximumNumberOfExports);
     auto stationsResource
         = std::make_unique<MLReview::Service::Stations::Resource>
           (aqmsDatabaseConnection);
+    stationsResource->setGeofence(geofence);
+    stationsResource->setEpicenterCallback(
+        catalogResource->getEpicenterCallback());
     auto waveformsResource
         = std::make_unique<MLReview::Service::Waveforms::Resource>
           (mongoDatabaseConnection);
+    // Warm the waveforms cache as events arrive
+    catalogResource->setNewEventsCallback(
+        waveformsResource->getPrefetchCallback());
 
     auto handler = std::make_shared<MLReview::Service::Handler> ();
     handler->insert(std::move(catalogResource));
@@ -1,4 +1,6 @@
 #include <string>
+#include <memory>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "mlReview/messages/message.hpp"
 
@@ -25,17 +27,62 @@ std::optional<nlohmann::json> IMessage::getData() const noexcept
     return std::nullopt;
 }
 
+/// Data stream
+std::function<std::optional<std::string> ()> IMessage::getDataStream() const noexcept
+{
+    return nullptr;
+}
+
 /// Message?
 std::optional<std::string> IMessage::getMessage() const noexcept
 {
     return std::nullopt;
 }
 
+/// ETag
+std::optional<std::string> IMessage::getETag() const noexcept
+{
+    return std::nullopt;
+}
+
+namespace
+{
+/// Everything in the serialized message up to the data
+std::string toJSONPrefix(const IMessage &message)
+{
+    auto messageDetails = message.getMessage();
+    nlohmann::json messageObject = nullptr;
+    if (messageDetails){messageObject = std::move(*messageDetails);}
+    std::string result
+        = "{\"success\":" + nlohmann::json(message.getSuccess()).dump()
+        + ",\"statusCode\":" + std::to_string(message.getStatusCode())
+        + ",\"message\":" + messageObject.dump();
+    auto eTag = message.getETag();
+    if (eTag){result = result + ",\"etag\":" + nlohmann::json(*eTag).dump();}
+    return result + ",\"data\":";
+}
+}
+
 std::string MLReview::Messages::toJSON(const std::unique_ptr<IMessage> &message,
                                        const int indentIn)
 {
     const int indent = indentIn >= 0 ? indentIn : -1;
     std::string result;
+    // Streamed data is already serialized so splice it in
+    if (message)
+    {
+        auto dataStream = message->getDataStream();
+        if (dataStream)
+        {
+            result = ::toJSONPrefix(*message);
+            while (auto piece = dataStream())
+            {
+                result.append(*piece);
+            }
+            result.append("}");
+            return result;
+        }
+    }
     nlohmann::json object;
     if (message)
     {
@@ -50,6 +97,8 @@ std::string MLReview::Messages::toJSON(const std::unique_ptr<IMessage> &message,
         {
             object["message"] = nullptr;
         }
+        auto eTag = message->getETag();
+        if (eTag){object["etag"] = std::move(*eTag);}
         auto data = message->getData();
         if (data)
         {
@@ -69,3 +118,46 @@ std::string MLReview::Messages::toJSON(const std::unique_ptr<IMessage> &message,
     }
     return object.dump(indent);
 }
+
+std::function<std::optional<std::string> ()>
+MLReview::Messages::toJSONStream(std::unique_ptr<IMessage> &&messageIn)
+{
+    std::function<std::optional<std::string> ()> dataStream{nullptr};
+    if (messageIn){dataStream = messageIn->getDataStream();}
+    // Nothing to stream so the message goes out in one piece
+    if (!dataStream)
+    {
+        auto result
+            = std::make_shared<std::optional<std::string>> (toJSON(messageIn));
+        return [result]()
+               {
+                   std::optional<std::string> piece;
+                   std::swap(piece, *result);
+                   return piece;
+               };
+    }
+    std::shared_ptr<IMessage> message{std::move(messageIn)};
+    // 0 - prefix, 1 - data, 2 - suffix, 3 - done
+    auto state = std::make_shared<int> (0);
+    return [message, dataStream, state]() mutable
+           -> std::optional<std::string>
+           {
+               if (*state == 0)
+               {
+                   *state = 1;
+                   return ::toJSONPrefix(*message);
+               }
+               if (*state == 1)
+               {
+                   auto piece = dataStream();
+                   if (piece){return piece;}
+                   *state = 2;
+               }
+               if (*state == 2)
+               {
+                   *state = 3;
+                   return std::string {"}"};
+               }
+               return std::nullopt;
+           };
+}
@@ -1,12 +1,56 @@
 #ifndef PRIVATE_REGIONS_HPP
 #define PRIVATE_REGIONS_HPP
+#include <vector>
+#include <utility>
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
+#include "mlReview/service/geofence.hpp"
 #include "lonTo180.hpp"
 namespace
 {
 
+/// The (latitude, longitude) vertices of the UUSS's Yellowstone
+/// authoritative region
+const std::vector<std::pair<double, double>> YELLOWSTONE_VERTICES
+{
+    {44.00,  -111.333},
+    {44.00,  -109.750},
+    {45.167, -109.750},
+    {45.167, -111.333},
+    {44.00,  -111.333}
+};
+
+/// The (latitude, longitude) vertices of the UUSS's Utah authoritative
+/// region
+const std::vector<std::pair<double, double>> UTAH_VERTICES
+{
+    {36.75, -114.25},
+    {36.75, -108.75},
+    {42.50, -108.75},
+    {42.50, -114.25},
+    {36.75, -114.25}
+};
+
+using LatitudeLongitudePolygon
+    = boost::geometry::model::polygon
+      <boost::geometry::model::d2::point_xy<double>>;
+
+/// @result The polygon whose points are (latitude, longitude)
+[[nodiscard]]
+LatitudeLongitudePolygon toPolygon(
+    const std::vector<std::pair<double, double>> &vertices)
+{
+    LatitudeLongitudePolygon polygon;
+    for (const auto &vertex : vertices)
+    {
+        boost::geometry::append(polygon.outer(),
+            boost::geometry::model::d2::point_xy<double>
+               {vertex.first, vertex.second});
+    }
+    return polygon;
+}
+
 /// @result True indicates the event is in the UUSS's Yellowstone 
 ///         authoritative region. 
 [[nodiscard]]
@@ -19,16 +63,8 @@ bool isInYellowstone(const double latitude, const double longitudeIn)
     auto longitude = ::lonTo180(longitudeIn);    
     namespace bg = boost::geometry;
     const bg::model::d2::point_xy<double> point {latitude, longitude};
-    const bg::model::polygon<bg::model::d2::point_xy<double>> polygon
-    {   
-     {   
-      {44.00,  -111.333},
-      {44.00,  -109.750},
-      {45.167, -109.750},
-      {45.167, -111.333},
-      {44.00,  -111.333}
-     }   
-    };  
+    // Built on first use
+    static const auto polygon = ::toPolygon(YELLOWSTONE_VERTICES);
     return bg::within(point, polygon);
 }
 
@@ -44,16 +80,8 @@ bool isInUtah(const double latitude, const double longitudeIn)
     auto longitude = ::lonTo180(longitudeIn);
     namespace bg = boost::geometry;
     const bg::model::d2::point_xy<double> point {latitude, longitude};
-    const bg::model::polygon<bg::model::d2::point_xy<double>> polygon
-    {   
-     {   
-      {36.75, -114.25},
-      {36.75, -108.75},
-      {42.50, -108.75},
-      {42.50, -114.25},
-      {36.75, -114.25}
-     }   
-    };  
+    // Built on first use
+    static const auto polygon = ::toPolygon(UTAH_VERTICES);
     return bg::within(point, polygon);
 }
 
@@ -66,5 +94,15 @@ bool isInAuthoritativeRegion(const double latitude, const double longitude)
     return false;
 }
 
+/// @result A geofence with the UUSS's authoritative regions.
+[[nodiscard]]
+MLReview::Service::Geofence createAuthoritativeRegionsGeofence()
+{
+    MLReview::Service::Geofence geofence;
+    geofence.addRegion("utah", UTAH_VERTICES);
+    geofence.addRegion("yellowstone", YELLOWSTONE_VERTICES);
+    return geofence;
+}
+
 }
 #endif
@@ -0,0 +1,280 @@
+#ifndef PRIVATE_SPATIAL_INDEX_HPP
+#define PRIVATE_SPATIAL_INDEX_HPP
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <nlohmann/json.hpp>
+#include "mlReview/service/geofence.hpp"
+#include "private/lonTo180.hpp"
+namespace
+{
+
+/// @result The great-circle distance in kilometers between two points on a
+///         spherical Earth.
+[[nodiscard]] double greatCircleDistance(const double latitude1,
+                                         const double longitude1,
+                                         const double latitude2,
+                                         const double longitude2)
+{
+    constexpr double earthRadius{6371.0088};
+    constexpr double toRadians{M_PI/180};
+    auto dLatitude = (latitude2 - latitude1)*toRadians;
+    auto dLongitude = (longitude2 - longitude1)*toRadians;
+    auto a = std::sin(dLatitude/2)*std::sin(dLatitude/2)
+           + std::cos(latitude1*toRadians)*std::cos(latitude2*toRadians)
+            *std::sin(dLongitude/2)*std::sin(dLongitude/2);
+    return 2*earthRadius*std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+/// A circle on the Earth's surface
+struct Circle
+{
+    double latitude{0};
+    double longitude{0};
+    /// The radius in kilometers
+    double radius{0};
+};
+
+/// @brief The spatial constraints on a query.  A point must satisfy every
+///        constraint that is set.
+struct SpatialFilter
+{
+    /// {minimum latitude, minimum longitude, maximum latitude, maximum
+    /// longitude}.  The box crosses the antimeridian when the minimum
+    /// longitude exceeds the maximum longitude.
+    std::optional<std::array<double, 4>> boundingBox;
+    std::optional<std::string> region;
+    std::optional<Circle> circle;
+    /// True indicates the point satisfies the constraints
+    [[nodiscard]] bool contains(const double latitude,
+                                const double longitudeIn,
+                                const MLReview::Service::Geofence *geofence) const
+    {
+        auto longitude = ::lonTo180(longitudeIn);
+        if (boundingBox)
+        {
+            const auto &box = *boundingBox;
+            if (latitude < box[0] || latitude > box[2]){return false;}
+            if (box[1] <= box[3])
+            {
+                if (longitude < box[1] || longitude > box[3]){return false;}
+            }
+            else if (longitude < box[1] && longitude > box[3])
+            {
+                return false;
+            }
+        }
+        if (circle)
+        {
+            if (::greatCircleDistance(circle->latitude, circle->longitude,
+                                      latitude, longitude) > circle->radius)
+            {
+                return false;
+            }
+        }
+        if (region)
+        {
+            if (geofence == nullptr ||
+                !geofence->isInRegion(*region, latitude, longitude))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    /// The most selective box that bounds the points that can satisfy the
+    /// constraints
+    [[nodiscard]] std::array<double, 4>
+        getBoundingBox(const MLReview::Service::Geofence *geofence) const
+    {
+        if (circle)
+        {
+            constexpr double earthRadius{6371.0088};
+            constexpr double toDegrees{180/M_PI};
+            auto angle = circle->radius/earthRadius;
+            auto minLatitude = circle->latitude - angle*toDegrees;
+            auto maxLatitude = circle->latitude + angle*toDegrees;
+            // The circle contains a pole or is larger than a hemisphere
+            auto cosLatitude = std::cos(circle->latitude/toDegrees);
+            if (minLatitude <= -90 || maxLatitude >= 90 ||
+                std::sin(angle) >= cosLatitude || angle >= M_PI/2)
+            {
+                return std::array<double, 4> {std::max(-90.0, minLatitude),
+                                              -180,
+                                              std::min(90.0, maxLatitude),
+                                              180};
+            }
+            auto dLongitude
+                = std::asin(std::sin(angle)/cosLatitude)*toDegrees;
+            return std::array<double, 4>
+                   {minLatitude,
+                    ::lonTo180(circle->longitude - dLongitude),
+                    maxLatitude,
+                    ::lonTo180(circle->longitude + dLongitude)};
+        }
+        if (region && geofence)
+        {
+            return geofence->getBoundingBox(*region);
+        }
+        if (boundingBox){return *boundingBox;}
+        return std::array<double, 4> {-90, -180, 90, 180};
+    }
+};
+
+/// @result The spatial constraints in the request or nothing if there are
+///         none.  The request may have
+///         "bbox": {"minLatitude": , "minLongitude": ,
+///                  "maxLatitude": , "maxLongitude": }
+///         "region": name
+///         "radius": {"latitude": , "longitude": , "distance": km}
+/// @throws std::invalid_argument if a constraint is invalid.
+[[nodiscard]] std::optional<SpatialFilter>
+    parseSpatialFilter(const nlohmann::json &request,
+                       const MLReview::Service::Geofence *geofence)
+{
+    SpatialFilter filter;
+    bool haveFilter{false};
+    if (request.contains("bbox") && !request["bbox"].is_null())
+    {
+        const auto &box = request["bbox"];
+        auto minLongitude = box.at("minLongitude").template get<double> ();
+        auto maxLongitude = box.at("maxLongitude").template get<double> ();
+        std::array<double, 4> boundingBox
+        {
+            box.at("minLatitude").template get<double> (),
+            ::lonTo180(minLongitude),
+            box.at("maxLatitude").template get<double> (),
+            ::lonTo180(maxLongitude)
+        };
+        // A box spanning every longitude would otherwise collapse since,
+        // e.g., -180 and 180 normalize to the same longitude
+        if (maxLongitude - minLongitude >= 360)
+        {
+            boundingBox[1] = -180;
+            boundingBox[3] = 180;
+        }
+        if (boundingBox[0] < -90 || boundingBox[2] > 90 ||
+            boundingBox[0] > boundingBox[2])
+        {
+            throw std::invalid_argument(
+                "bbox latitudes must be increasing and in range [-90,90]");
+        }
+        filter.boundingBox = boundingBox;
+        haveFilter = true;
+    }
+    if (request.contains("region") && !request["region"].is_null())
+    {
+        auto region = request["region"].template get<std::string> ();
+        if (geofence == nullptr || !geofence->haveRegion(region))
+        {
+            throw std::invalid_argument("Unknown region: " + region);
+        }
+        filter.region = region;
+        haveFilter = true;
+    }
+    if (request.contains("radius") && !request["radius"].is_null())
+    {
+        const auto &radius = request["radius"];
+        Circle circle;
+        circle.latitude = radius.at("latitude").template get<double> ();
+        circle.longitude
+            = ::lonTo180(radius.at("longitude").template get<double> ());
+        circle.radius = radius.at("distance").template get<double> ();
+        if (circle.latitude < -90 || circle.latitude > 90)
+        {
+            throw std::invalid_argument(
+                "radius latitude must be in range [-90,90]");
+        }
+        if (circle.radius <= 0)
+        {
+            throw std::invalid_argument("radius distance must be positive");
+        }
+        filter.circle = circle;
+        haveFilter = true;
+    }
+    if (!haveFilter){return std::nullopt;}
+    return std::optional<SpatialFilter> (std::move(filter));
+}
+
+/// @brief An R-tree of keyed points, e.g., events or stations, that answers
+///        spatial queries without visiting every point.
+/// @note This is not thread safe.
+template<class Key>
+class SpatialIndex
+{
+public:
+    void insert(const Key &key, const double latitude, const double longitude)
+    {
+        mTree.insert(Value {toPoint(latitude, longitude), key});
+    }
+    void erase(const Key &key, const double latitude, const double longitude)
+    {
+        mTree.remove(Value {toPoint(latitude, longitude), key});
+    }
+    void clear() noexcept
+    {
+        mTree.clear();
+    }
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mTree.size();
+    }
+    /// @result The keys of the points that satisfy the filter.
+    [[nodiscard]] std::vector<Key>
+        query(const SpatialFilter &filter,
+              const MLReview::Service::Geofence *geofence) const
+    {
+        auto bounds = filter.getBoundingBox(geofence);
+        std::vector<Box> boxes;
+        if (bounds[1] <= bounds[3])
+        {
+            boxes.push_back(Box {Point {bounds[1], bounds[0]},
+                                 Point {bounds[3], bounds[2]}});
+        }
+        else
+        {
+            // Split boxes that cross the antimeridian
+            boxes.push_back(Box {Point {bounds[1], bounds[0]},
+                                 Point {180, bounds[2]}});
+            boxes.push_back(Box {Point {-180, bounds[0]},
+                                 Point {bounds[3], bounds[2]}});
+        }
+        std::vector<Key> result;
+        for (const auto &box : boxes)
+        {
+            for (auto it = mTree.qbegin(boost::geometry::index::covered_by(box));
+                 it != mTree.qend(); ++it)
+            {
+                auto latitude = boost::geometry::get<1> (it->first);
+                auto longitude = boost::geometry::get<0> (it->first);
+                if (filter.contains(latitude, longitude, geofence))
+                {
+                    result.push_back(it->second);
+                }
+            }
+        }
+        return result;
+    }
+private:
+    // Points are (longitude, latitude)
+    using Point = boost::geometry::model::point
+                  <double, 2, boost::geometry::cs::cartesian>;
+    using Box = boost::geometry::model::box<Point>;
+    using Value = std::pair<Point, Key>;
+    [[nodiscard]] static Point toPoint(const double latitude,
+                                       const double longitude)
+    {
+        return Point {::lonTo180(longitude), latitude};
+    }
+    boost::geometry::index::rtree<Value, boost::geometry::index::rstar<16>> mTree;
+};
+
+}
+#endif
@@ -50,8 +50,9 @@ nlohmann::json getParametricData(
     nlohmann::json jsonObject;
     auto databaseName = connection.getDatabaseName();
     using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
     auto client
-        = reinterpret_cast<mongocxx::client *> (connection.getSession());
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
     auto database = client->database(databaseName);
     if (database)
     {
@@ -27,8 +27,9 @@ bool checkIfEventExists(
 {
     auto databaseName = connection.getDatabaseName();
     using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
     auto client
-        = reinterpret_cast<mongocxx::client *> (connection.getSession());
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
     auto database = client->database(databaseName);
     if (database)
     {   
@@ -63,8 +64,9 @@ void updateEventSubmittedInMongoDB(
 {
     auto databaseName = connection.getDatabaseName();
     using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
     auto client
-        = reinterpret_cast<mongocxx::client *> (connection.getSession());
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
     auto database = client->database(databaseName);
     if (database)
     {
@@ -124,8 +126,9 @@ nlohmann::json getParametricData(
     nlohmann::json jsonObject;
     auto databaseName = connection.getDatabaseName();
     using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
     auto client
-        = reinterpret_cast<mongocxx::client *> (connection.getSession());
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
     auto database = client->database(databaseName);
     if (database)
     {   
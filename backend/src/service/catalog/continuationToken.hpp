@@ -0,0 +1,62 @@
+#ifndef CONTINUATION_TOKEN_HPP
+#define CONTINUATION_TOKEN_HPP
+#include <array>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include "eventStore.hpp"
+namespace
+{
+
+/// Encodes the key of the last event on a page.  Clients should treat
+/// this as opaque.
+std::string toContinuationToken(const ::EventKey &key)
+{
+    constexpr char hexDigits[]{"0123456789abcdef"};
+    std::string token;
+    token.reserve(32);
+    for (const auto value : {static_cast<uint64_t> (key.first.count()),
+                             static_cast<uint64_t> (key.second)})
+    {
+        for (int shift = 60; shift >= 0; shift = shift - 4)
+        {
+            token.push_back(hexDigits[(value >> shift) & 0xF]);
+        }
+    }
+    return token;
+}
+
+/// Decodes a continuation token
+::EventKey fromContinuationToken(const std::string &token)
+{
+    if (token.size() != 32)
+    {
+        throw std::invalid_argument("Invalid continuation token");
+    }
+    std::array<uint64_t, 2> values{0, 0};
+    for (size_t i = 0; i < token.size(); ++i)
+    {
+        auto c = token[i];
+        uint64_t digit{0};
+        if (c >= '0' && c <= '9')
+        {
+            digit = static_cast<uint64_t> (c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            digit = static_cast<uint64_t> (c - 'a' + 10);
+        }
+        else
+        {
+            throw std::invalid_argument("Invalid continuation token");
+        }
+        values[i/16] = (values[i/16] << 4) | digit;
+    }
+    return ::EventKey {std::chrono::microseconds
+                          {static_cast<int64_t> (values[0])},
+                       static_cast<int64_t> (values[1])};
+}
+
+}
+#endif
@@ -0,0 +1,389 @@
+#ifndef EVENT_STORE_HPP
+#define EVENT_STORE_HPP
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+#include <optional>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "mlReview/service/catalog/event.hpp"
+#include "mlReview/service/catalog/origin.hpp"
+#include "mlReview/service/geofence.hpp"
+#include "private/spatialIndex.hpp"
+namespace
+{
+
+/// An event as loaded from the database along with its serialized form.
+struct StoredEvent
+{
+    MLReview::Service::Catalog::Event event;
+    nlohmann::json object;
+    std::chrono::microseconds originTime{0};
+    /// The preferred origin's epicenter in degrees
+    double latitude{0};
+    double longitude{0};
+    std::chrono::seconds loadDate{0};
+    std::chrono::seconds lastUpdate{0};
+    /// The serialized event.  This is set by the store.
+    std::string serialized;
+    /// A hash of the serialized event.  This is set by the store.
+    size_t hash{0};
+};
+
+/// Hashes the serialized event.  Content hashes of a set of events are
+/// combined with XOR so the set's hash can be updated one event at a time.
+[[nodiscard]] size_t hashEvent(const nlohmann::json &object)
+{
+    try
+    {
+        return std::hash<std::string> {}(object.dump());
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Failed to hash event: " + std::string {e.what()});
+    }
+    return 0;
+}
+
+/// Orders events by origin time then event identifier
+using EventKey = std::pair<std::chrono::microseconds, int64_t>;
+
+/// A page of serialized events
+struct EventPage
+{
+    nlohmann::json events = nlohmann::json::array();
+    /// The key of the last event on the page
+    std::optional<EventKey> last;
+    /// Set when there may be more events after this page
+    std::optional<EventKey> next;
+    /// The combined hash of the events on the page
+    size_t hash{0};
+};
+
+/// @brief The events in the catalog keyed on the event identifier.  Each
+///        event is serialized when it is loaded so that refreshing the
+///        catalog costs as much as the number of changed events rather
+///        than the number of events.
+/// @note The events are also indexed by origin time for time-range queries
+///       and by epicenter for spatial queries.
+/// @note Every change increments the store's version and is recorded in a
+///       bounded log so that clients can ask for what changed since the
+///       version they hold.  The initial version is the construction time
+///       in microseconds so versions keep increasing across restarts.
+/// @note The store's hash is the XOR of the hashes of the serialized events.
+///       It is updated as events change so it never requires a traversal
+///       of the catalog.
+/// @note This is not thread safe.
+class EventStore
+{
+public:
+    EventStore() :
+        mVersion(static_cast<uint64_t>
+                 (std::chrono::duration_cast<std::chrono::microseconds>
+                    (std::chrono::system_clock::now().time_since_epoch())
+                  .count()))
+    {
+    }
+    enum class Change
+    {
+        None,     /*!< The event was already stored as is. */
+        Inserted, /*!< The event is new. */
+        Updated   /*!< The stored event was replaced. */
+    };
+    /// Inserts or replaces the event
+    Change upsert(StoredEvent &&storedEvent)
+    {
+        auto identifier = storedEvent.event.getIdentifier();
+        storedEvent.serialized = storedEvent.object.dump();
+        storedEvent.hash = std::hash<std::string> {}(storedEvent.serialized);
+        auto it = mEvents.find(identifier);
+        if (it == mEvents.end())
+        {
+            mHash = mHash ^ storedEvent.hash;
+            mTimeIndex.insert(std::pair {storedEvent.originTime, identifier});
+            mSpatialIndex.insert(identifier,
+                                 storedEvent.latitude, storedEvent.longitude);
+            mEvents.insert(std::pair {identifier, std::move(storedEvent)});
+            record(identifier);
+            return Change::Inserted;
+        }
+        if (it->second.lastUpdate == storedEvent.lastUpdate &&
+            it->second.hash == storedEvent.hash)
+        {
+            return Change::None;
+        }
+        mHash = mHash ^ it->second.hash ^ storedEvent.hash;
+        // Relocations can move the origin time
+        mTimeIndex.erase(std::pair {it->second.originTime, identifier});
+        mTimeIndex.insert(std::pair {storedEvent.originTime, identifier});
+        mSpatialIndex.erase(identifier,
+                            it->second.latitude, it->second.longitude);
+        mSpatialIndex.insert(identifier,
+                             storedEvent.latitude, storedEvent.longitude);
+        it->second = std::move(storedEvent);
+        record(identifier);
+        return Change::Updated;
+    }
+    /// True indicates the event was removed
+    bool erase(const int64_t identifier)
+    {
+        auto it = mEvents.find(identifier);
+        if (it != mEvents.end())
+        {
+            erase(it);
+            return true;
+        }
+        return false;
+    }
+    /// Removes the events loaded before the given time
+    std::vector<int64_t> ageOut(const std::chrono::seconds &oldestLoadDate)
+    {
+        std::vector<int64_t> removed;
+        for (auto it = mEvents.begin(); it != mEvents.end();)
+        {
+            if (it->second.loadDate <= oldestLoadDate)
+            {
+                removed.push_back(it->first);
+                it = erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return removed;
+    }
+    /// Removes the events that are not in the given set - e.g., events
+    /// that were deleted from the database
+    std::vector<int64_t> retainOnly(const std::set<int64_t> &identifiers)
+    {
+        std::vector<int64_t> removed;
+        for (auto it = mEvents.begin(); it != mEvents.end();)
+        {
+            if (!identifiers.contains(it->first))
+            {
+                removed.push_back(it->first);
+                it = erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return removed;
+    }
+    [[nodiscard]] bool contains(const int64_t identifier) const noexcept
+    {
+        return mEvents.contains(identifier);
+    }
+    [[nodiscard]] const StoredEvent *find(const int64_t identifier) const
+    {
+        auto it = mEvents.find(identifier);
+        if (it == mEvents.end()){return nullptr;}
+        return &it->second;
+    }
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mEvents.size();
+    }
+    /// @result Up to maxEvents serialized events whose origin times are in
+    ///         the window [startTime, endTime) and that come after the given
+    ///         (origin time, event identifier) key.  If there may be more
+    ///         events then the key of the last returned event is set.
+    [[nodiscard]] EventPage query(const std::chrono::microseconds &startTime,
+                                  const std::chrono::microseconds &endTime,
+                                  const std::optional<EventKey> &after,
+                                  const size_t maxEvents) const
+    {
+        EventPage page;
+        EventKey startKey{startTime, std::numeric_limits<int64_t>::lowest()};
+        auto first = after && *after >= startKey ?
+                     mTimeIndex.upper_bound(*after) :
+                     mTimeIndex.lower_bound(startKey);
+        for (auto it = first; it != mTimeIndex.end(); ++it)
+        {
+            if (it->first >= endTime){break;}
+            if (page.events.size() >= maxEvents)
+            {
+                page.next = page.last;
+                break;
+            }
+            auto eventIt = mEvents.find(it->second);
+            if (eventIt != mEvents.end())
+            {
+                page.events.push_back(eventIt->second.object);
+                page.hash = page.hash ^ eventIt->second.hash;
+                page.last = *it;
+            }
+        }
+        return page;
+    }
+    /// @result Up to maxEvents serialized events whose origin times are in
+    ///         the window [startTime, endTime), that come after the given
+    ///         key, and whose epicenters satisfy the spatial filter.
+    [[nodiscard]] EventPage query(const std::chrono::microseconds &startTime,
+                                  const std::chrono::microseconds &endTime,
+                                  const std::optional<EventKey> &after,
+                                  const size_t maxEvents,
+                                  const ::SpatialFilter &filter,
+                                  const MLReview::Service::Geofence *geofence) const
+    {
+        EventPage page;
+        std::vector<EventKey> keys;
+        for (const auto &identifier : mSpatialIndex.query(filter, geofence))
+        {
+            auto it = mEvents.find(identifier);
+            if (it == mEvents.end()){continue;}
+            EventKey key{it->second.originTime, identifier};
+            if (key.first < startTime || key.first >= endTime){continue;}
+            if (after && key <= *after){continue;}
+            keys.push_back(key);
+        }
+        std::sort(keys.begin(), keys.end());
+        for (const auto &key : keys)
+        {
+            if (page.events.size() >= maxEvents)
+            {
+                page.next = page.last;
+                break;
+            }
+            const auto &storedEvent = mEvents.at(key.second);
+            page.events.push_back(storedEvent.object);
+            page.hash = page.hash ^ storedEvent.hash;
+            page.last = key;
+        }
+        return page;
+    }
+    /// Assembles the serialized catalog from the serialized events.  This
+    /// is {"events":[...],"full":true,"hash":...,"version":...}.
+    [[nodiscard]] std::string serialize() const
+    {
+        size_t length{64};
+        for (const auto &it : mEvents)
+        {
+            length = length + it.second.serialized.size() + 1;
+        }
+        std::string result;
+        result.reserve(length);
+        result.append("{\"events\":[");
+        bool isFirst{true};
+        for (const auto &it : mEvents)
+        {
+            if (!isFirst){result.push_back(',');}
+            result.append(it.second.serialized);
+            isFirst = false;
+        }
+        result.append("],\"full\":true,\"hash\":" + std::to_string(mHash)
+                    + ",\"version\":" + std::to_string(mVersion) + "}");
+        return result;
+    }
+    /// @result The hash of the stored events' contents.
+    [[nodiscard]] size_t getHash() const noexcept
+    {
+        return mHash;
+    }
+    /// @result The current version of the store.
+    [[nodiscard]] uint64_t getVersion() const noexcept
+    {
+        return mVersion;
+    }
+    /// @result The events upserted and removed after the given version.
+    ///         The upserted events are given as they are now.  If the log
+    ///         no longer reaches back to the version then nothing is
+    ///         returned and the client needs the full catalog.
+    [[nodiscard]] std::optional<nlohmann::json>
+        getChangesSince(const uint64_t version) const
+    {
+        if (version > mVersion){return std::nullopt;}
+        if (version < mVersion)
+        {
+            if (mChangeLog.empty() ||
+                mChangeLog.front().version > version + 1)
+            {
+                return std::nullopt;
+            }
+        }
+        std::set<int64_t> changedEvents;
+        auto first = std::partition_point(mChangeLog.begin(),
+                                          mChangeLog.end(),
+                                          [=](const LogEntry &entry)
+                                          {
+                                              return entry.version <= version;
+                                          });
+        for (auto it = first; it != mChangeLog.end(); ++it)
+        {
+            changedEvents.insert(it->identifier);
+        }
+        nlohmann::json upserted = nlohmann::json::array();
+        nlohmann::json removed = nlohmann::json::array();
+        for (const auto &identifier : changedEvents)
+        {
+            auto it = mEvents.find(identifier);
+            if (it != mEvents.end())
+            {
+                upserted.push_back(it->second.object);
+            }
+            else
+            {
+                removed.push_back(identifier);
+            }
+        }
+        nlohmann::json result;
+        result["fromVersion"] = version;
+        result["version"] = mVersion;
+        result["upserted"] = std::move(upserted);
+        result["removed"] = std::move(removed);
+        return std::optional<nlohmann::json> (std::move(result));
+    }
+    [[nodiscard]] std::map<int64_t, StoredEvent>::const_iterator
+        begin() const noexcept
+    {
+        return mEvents.cbegin();
+    }
+    [[nodiscard]] std::map<int64_t, StoredEvent>::const_iterator
+        end() const noexcept
+    {
+        return mEvents.cend();
+    }
+private:
+    struct LogEntry
+    {
+        uint64_t version{0};
+        int64_t identifier{0};
+    };
+    std::map<int64_t, StoredEvent>::iterator
+        erase(std::map<int64_t, StoredEvent>::iterator it)
+    {
+        mTimeIndex.erase(std::pair {it->second.originTime, it->first});
+        mSpatialIndex.erase(it->first,
+                            it->second.latitude, it->second.longitude);
+        mHash = mHash ^ it->second.hash;
+        record(it->first);
+        return mEvents.erase(it);
+    }
+    void record(const int64_t identifier)
+    {
+        mVersion = mVersion + 1;
+        mChangeLog.push_back(LogEntry {mVersion, identifier});
+        while (mChangeLog.size() > mMaximumChangeLogSize)
+        {
+            mChangeLog.pop_front();
+        }
+    }
+    std::map<int64_t, StoredEvent> mEvents;
+    std::set<EventKey> mTimeIndex;
+    ::SpatialIndex<int64_t> mSpatialIndex;
+    std::deque<LogEntry> mChangeLog;
+    uint64_t mVersion{0};
+    size_t mHash{0};
+    size_t mMaximumChangeLogSize{8192};
+};
+
+}
+#endif
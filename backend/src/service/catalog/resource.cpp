@@ -1,21 +1,36 @@
 #include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <array>
+#include <algorithm>
+#include <functional>
+#include <optional>
 #include <atomic>
 #include <mutex>
 #include <cmath>
+#include <limits>
 #include <chrono>
 #include <thread>
 #include <spdlog/spdlog.h>
 #include <nlohmann/json.hpp>
 #include <bsoncxx/json.hpp>
 #include <mongocxx/client.hpp>
+#include <mongocxx/uri.hpp>
+#include <mongocxx/pipeline.hpp>
+#include <mongocxx/change_stream.hpp>
 #include "mlReview/service/catalog/resource.hpp"
 #include "mlReview/service/catalog/response.hpp"
 #include "mlReview/service/catalog/event.hpp"
 #include "mlReview/service/catalog/origin.hpp"
 #include "mlReview/service/catalog/arrival.hpp"
+#include "mlReview/service/geofence.hpp"
 //#include "mlReview/database/connection/postgresql.hpp"
 #include "mlReview/database/connection/mongodb.hpp"
+#include "mlReview/messages/message.hpp"
 #include "mlReview/messages/error.hpp"
+#include "eventStore.hpp"
+#include "continuationToken.hpp"
 #ifdef WITH_SFF
 #include "sff/utilities/time.hpp"
 #include "sff/hypoinverse2000/eventSummary.hpp"
@@ -25,6 +40,9 @@
 
 #define RESOURCE_NAME "catalog"
 #define COLLECTION_NAME "events"
+#define ORIGIN_TIME_KEY "parametricData.preferredOrigin.time"
+#define DEFAULT_PAGE_SIZE 1024
+#define MAXIMUM_PAGE_SIZE 8192
 
 using namespace MLReview::Service::Catalog;
 
@@ -116,103 +134,41 @@ std::string eventToHypoInverse2000(const Event &event)
 }
 #endif
 
-nlohmann::json toObject(const std::vector<Event> &events)
+/// Unpacks an events document
+::StoredEvent toStoredEvent(const nlohmann::json &jsonObject)
 {
-    nlohmann::json result;
-    nlohmann::json jsonEvents;
-    for (const auto &event : events)
-    {
-        try
-        {
-            jsonEvents.push_back(toObject(event));
-        }
-        catch (const std::exception &e)
-        {
-            spdlog::warn(e.what());
-        }
-    }
-    result["events"] = jsonEvents;
-    size_t hash{0};
-    try
-    {
-        hash = std::hash<nlohmann::json> {}(result);
-        result["hash"] = hash;
-    }
-    catch (const std::exception &e)
-    {
-        spdlog::error("Failed to create hash: " + std::string {e.what()});
-        result["hash"] = hash;
-    }
-    return result;
-}
-
-/// Get the last update
-std::chrono::seconds
-    getLastUpdate(MLReview::Database::Connection::MongoDB &connection,
-                  const std::chrono::seconds &lastUpdate,
-                  const std::string &collectionName = COLLECTION_NAME)
-{
-    std::chrono::seconds result{0};
-    try
-    {
-        auto databaseName = connection.getDatabaseName();
-        using namespace bsoncxx::builder::basic;
-        auto client
-            = reinterpret_cast<mongocxx::client *> (connection.getSession());
-        auto database = client->database(databaseName);
-        if (database)
-        {   
-            auto collection = database.collection(collectionName);
-            if (collection)
-            {
-                mongocxx::options::find searchOptions{};
-                searchOptions.sort(make_document(kvp("lastUpdate", -1))); 
-                searchOptions.projection(
-                   make_document(kvp("lastUpdate", 1),
-                                 kvp("_id", 0))
-                );
-                auto filterKey
-                    = bsoncxx::document::view_or_value(
-                         make_document(kvp("lastUpdate",
-                                       make_document(kvp("$gt", lastUpdate.count())))
-                                      ));
-                auto foundDocument = collection.find_one(filterKey, searchOptions);
-                if (foundDocument)
-                {
-                    auto json
-                       = bsoncxx::to_json(*foundDocument,
-                                          bsoncxx::ExtendedJsonMode::k_relaxed);
-                    auto jsonObject = nlohmann::json::parse(json);
-                    result
-                       = std::chrono::seconds {
-                            jsonObject["lastUpdate"].template get<int64_t> ()
-                         }; 
-                }
-            }
-        }
-    }
-    catch (const std::exception &e)
-    {
-        spdlog::warn("Could not get update time because: "
-                   + std::string {e.what()});
-    }
-    return result;
+    ::StoredEvent storedEvent;
+    storedEvent.lastUpdate
+        = std::chrono::seconds {jsonObject.at("lastUpdate").template get<int64_t> ()};
+    storedEvent.loadDate
+        = std::chrono::seconds {jsonObject.at("loadDate").template get<int64_t> ()};
+    storedEvent.event = Event {jsonObject};
+    storedEvent.object = toObject(storedEvent.event);
+    auto preferredOrigin = storedEvent.event.getPreferredOrigin();
+    storedEvent.originTime = preferredOrigin.getTime();
+    storedEvent.latitude = preferredOrigin.getLatitude();
+    storedEvent.longitude = preferredOrigin.getLongitude();
+    return storedEvent;
 }
 
-/// Generates a catalog from the application database
-std::pair<std::chrono::seconds, std::vector<Event>>
+/// Generates a catalog from the application database.  If updatedSince is
+/// positive then only the events updated at or after that time are fetched.
+std::pair<std::chrono::seconds, std::vector<::StoredEvent>>
 getEventsFromMongoDB(MLReview::Database::Connection::MongoDB &connection,
                      const std::chrono::seconds &startTime
                         = now() - std::chrono::seconds {86400*14},
+                     const std::chrono::seconds &updatedSince
+                        = std::chrono::seconds {0},
                      const int maxEvents = 8192,
                      const std::string collectionName = COLLECTION_NAME)
 {
     std::chrono::seconds lastUpdate{0};
-    std::vector<Event> events;
+    std::vector<::StoredEvent> events;
     auto databaseName = connection.getDatabaseName();
     using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
     auto client
-        = reinterpret_cast<mongocxx::client *> (connection.getSession());
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
     auto database = client->database(databaseName);
     if (database)
     {   
@@ -225,8 +181,17 @@ getEventsFromMongoDB(MLReview::Database::Connection::MongoDB &connection,
                 make_document(kvp("waveformData", 0),
                               kvp("_id", 0))
             );
+            // Updates within the same second as the last poll may have
+            // been missed so the comparison is inclusive
             auto filterKey
-                = bsoncxx::document::view_or_value(
+                = updatedSince.count() > 0 ?
+                  bsoncxx::document::view_or_value(
+                     make_document(kvp("loadDate",
+                                   make_document(kvp("$gt", startTime.count()))),
+                                   kvp("lastUpdate",
+                                   make_document(kvp("$gte", updatedSince.count())))
+                                  )) :
+                  bsoncxx::document::view_or_value(
                      make_document(kvp("loadDate",
                                    make_document(kvp("$gt", startTime.count())))
                                   ));
@@ -240,12 +205,9 @@ getEventsFromMongoDB(MLReview::Database::Connection::MongoDB &connection,
                                           bsoncxx::ExtendedJsonMode::k_relaxed);
                     auto jsonObject = nlohmann::json::parse(json);
 
-                    lastUpdate 
-                        = std::max(lastUpdate,
-                                   std::chrono::seconds {jsonObject["lastUpdate"].template get<int64_t> ()});
-
-                    Event event{jsonObject};
-                    events.push_back(std::move(event));
+                    auto storedEvent = ::toStoredEvent(jsonObject);
+                    lastUpdate = std::max(lastUpdate, storedEvent.lastUpdate);
+                    events.push_back(std::move(storedEvent));
 /*
 
                     Event event;
@@ -342,72 +304,845 @@ getEventsFromMongoDB(MLReview::Database::Connection::MongoDB &connection,
     return std::pair {lastUpdate, events};
 }
 
+/// The filter for events whose origin times are in the window
+/// [startTime, endTime) and that come after the given key
+bsoncxx::document::value
+    toWindowFilter(const std::chrono::seconds &startTime,
+                   const std::chrono::seconds &endTime,
+                   const std::optional<::EventKey> &after)
+{
+    using namespace bsoncxx::builder::basic;
+    auto window
+        = make_document(kvp(ORIGIN_TIME_KEY,
+                            make_document(
+                               kvp("$gte", static_cast<double> (startTime.count())),
+                               kvp("$lt",  static_cast<double> (endTime.count())))));
+    if (!after){return window;}
+    // The database stores the origin time in seconds as a double so allow
+    // for the round trip through microseconds
+    constexpr double tolerance{0.5e-6};
+    auto originTime = after->first.count()*1.e-6;
+    return make_document(
+        kvp("$and",
+            make_array(
+               window.view(),
+               make_document(
+                  kvp("$or",
+                      make_array(
+                         make_document(
+                            kvp(ORIGIN_TIME_KEY,
+                                make_document(kvp("$gt", originTime + tolerance)))),
+                         make_document(
+                            kvp(ORIGIN_TIME_KEY,
+                                make_document(kvp("$gte", originTime - tolerance),
+                                              kvp("$lte", originTime + tolerance))),
+                            kvp("eventIdentifier",
+                                make_document(kvp("$gt", after->second))))))))));
+}
+
+/// Gets up to maxEvents serialized events whose origin times are in the
+/// window [startTime, endTime) from the application database sorted by
+/// origin time.  The cursor is read in batches so memory use is bounded by
+/// the page size.  If given, only the events that keep returns true for
+/// are returned.
+::EventPage
+getEventPageFromMongoDB(MLReview::Database::Connection::MongoDB &connection,
+                        const std::chrono::seconds &startTime,
+                        const std::chrono::seconds &endTime,
+                        const std::optional<::EventKey> &after = std::nullopt,
+                        const int maxEvents = 8192,
+                        const std::function<bool (const Event &)> &keep = nullptr,
+                        const std::string collectionName = COLLECTION_NAME)
+{
+    constexpr int32_t batchSize{512};
+    ::EventPage page;
+    auto databaseName = connection.getDatabaseName();
+    using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
+    auto client
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
+    auto database = client->database(databaseName);
+    if (!database)
+    {
+        spdlog::warn("No database named " + databaseName);
+        return page;
+    }
+    auto collection = database.collection(collectionName);
+    if (!collection)
+    {
+        spdlog::warn("No collection named " + collectionName);
+        return page;
+    }
+    mongocxx::options::find searchOptions{};
+    searchOptions.sort(make_document(kvp(ORIGIN_TIME_KEY, 1),
+                                     kvp("eventIdentifier", 1)));
+    searchOptions.projection(
+        make_document(kvp("waveformData", 0),
+                      kvp("_id", 0))
+    );
+    searchOptions.batch_size(std::min(batchSize, maxEvents + 1));
+    // One extra tells us if there is another page.  Filtered events are
+    // dropped as they are read so the cursor cannot be limited.
+    if (!keep){searchOptions.limit(maxEvents + 1);}
+    auto filterKey
+        = bsoncxx::document::view_or_value(
+             ::toWindowFilter(startTime, endTime, after));
+    auto cursorFiltered = collection.find(filterKey, searchOptions);
+    int nEvents{0};
+    for (const auto &document : cursorFiltered)
+    {
+        try
+        {
+            auto json
+               = bsoncxx::to_json(document,
+                                  bsoncxx::ExtendedJsonMode::k_relaxed);
+            auto jsonObject = nlohmann::json::parse(json);
+            Event event{jsonObject};
+            if (keep && !keep(event)){continue;}
+            if (nEvents >= maxEvents)
+            {
+                page.next = page.last;
+                break;
+            }
+            nEvents = nEvents + 1;
+            auto object = toObject(event);
+            page.hash = page.hash ^ ::hashEvent(object);
+            page.events.push_back(std::move(object));
+            page.last = ::EventKey {event.getPreferredOrigin().getTime(),
+                                    event.getIdentifier()};
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn(e.what());
+        }
+    }
+    return page;
+}
+
+/// @brief Holds one of the catalog's export slots until it is destroyed.
+class ExportSlot
+{
+public:
+    explicit ExportSlot(std::shared_ptr<std::atomic<int>> nExports) :
+        mExports(std::move(nExports))
+    {
+    }
+    ~ExportSlot()
+    {
+        mExports->fetch_sub(1);
+    }
+    ExportSlot(const ExportSlot &) = delete;
+    ExportSlot& operator=(const ExportSlot &) = delete;
+private:
+    std::shared_ptr<std::atomic<int>> mExports;
+};
+
+/// Streams the serialized events whose origin times are in the window
+/// [startTime, endTime) from the application database.  The returned
+/// function reads the next batch from the cursor each time it is called
+/// so the export never holds more than a batch in memory.
+std::function<std::optional<std::string> ()>
+streamEventsFromMongoDB(MLReview::Database::Connection::MongoDB &connection,
+                        const std::chrono::seconds &startTime,
+                        const std::chrono::seconds &endTime,
+                        const std::function<bool (const Event &)> &keep = nullptr,
+                        const std::string collectionName = COLLECTION_NAME)
+{
+    constexpr int32_t batchSize{256};
+    auto databaseName = connection.getDatabaseName();
+    using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
+    auto client
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
+    auto database = client->database(databaseName);
+    if (!database)
+    {
+        throw std::runtime_error("No database named " + databaseName);
+    }
+    auto collection = database.collection(collectionName);
+    if (!collection)
+    {
+        throw std::runtime_error("No collection named " + collectionName);
+    }
+    mongocxx::options::find searchOptions{};
+    searchOptions.sort(make_document(kvp(ORIGIN_TIME_KEY, 1),
+                                     kvp("eventIdentifier", 1)));
+    searchOptions.projection(
+        make_document(kvp("waveformData", 0),
+                      kvp("_id", 0))
+    );
+    searchOptions.batch_size(batchSize);
+    auto filterKey
+        = bsoncxx::document::view_or_value(
+             ::toWindowFilter(startTime, endTime, std::nullopt));
+    // The cursor needs its client until the export finishes
+    struct Export
+    {
+        Export(MLReview::Database::Connection::MongoDB::Lease &&leaseIn,
+               mongocxx::cursor &&cursorIn) :
+            lease(std::move(leaseIn)),
+            cursor(std::move(cursorIn))
+        {
+        }
+        MLReview::Database::Connection::MongoDB::Lease lease;
+        mongocxx::cursor cursor;
+        std::optional<mongocxx::cursor::iterator> iterator;
+        int nEvents{0};
+        bool finished{false};
+    };
+    auto cursor = collection.find(filterKey, searchOptions);
+    auto state = std::make_shared<Export> (std::move(lease), std::move(cursor));
+    return [state, keep]() -> std::optional<std::string>
+           {
+               if (state->finished){return std::nullopt;}
+               std::string piece;
+               if (!state->iterator)
+               {
+                   state->iterator = state->cursor.begin();
+                   piece = "{\"events\":[";
+               }
+               auto &it = *state->iterator;
+               for (int i = 0; i < batchSize && it != state->cursor.end(); ++i, ++it)
+               {
+                   try
+                   {
+                       auto json
+                          = bsoncxx::to_json(*it,
+                                             bsoncxx::ExtendedJsonMode::k_relaxed);
+                       auto jsonObject = nlohmann::json::parse(json);
+                       Event event{jsonObject};
+                       if (keep && !keep(event)){continue;}
+                       if (state->nEvents > 0){piece.push_back(',');}
+                       piece.append(toObject(event).dump());
+                       state->nEvents = state->nEvents + 1;
+                   }
+                   catch (const std::exception &e)
+                   {
+                       spdlog::warn(e.what());
+                   }
+               }
+               if (it == state->cursor.end())
+               {
+                   piece.append("]}");
+                   state->finished = true;
+                   spdlog::info("Exported " + std::to_string(state->nEvents)
+                              + " events");
+               }
+               return piece;
+           };
+}
+
+/// Ensures the origin time index that custom queries use exists
+void createOriginTimeIndex(MLReview::Database::Connection::MongoDB &connection,
+                           const std::string collectionName = COLLECTION_NAME)
+{
+    using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
+    auto client
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
+    auto database = client->database(connection.getDatabaseName());
+    if (!database){return;}
+    auto collection = database.collection(collectionName);
+    if (!collection){return;}
+    // This does nothing if the index exists
+    collection.create_index(make_document(kvp(ORIGIN_TIME_KEY, 1),
+                                          kvp("eventIdentifier", 1)));
+}
+
+/// A custom query's result
+struct CachedQuery
+{
+    nlohmann::json result;
+    std::chrono::seconds queryTime{::now()};
+};
+
 }
 
 class Resource::ResourceImpl
 {
 public:
+    using Subscriber
+        = std::function<void (const std::shared_ptr<const std::string> &)>;
     ResourceImpl(
         std::shared_ptr<MLReview::Database::Connection::MongoDB> &mongoConnection) :
         mMongoDBConnection(mongoConnection)
     {
-spdlog::warn("Need to make polling thread pop events over 2 weeks old");
-        /*
-        mEvents = getEvents(*mMongoDBConnection);
-        mEventsJSON = ::toObject(mEvents);
-        mHash = std::hash<nlohmann::json> {}(mEventsJSON);
-        */
-        updateStandardCatalog();
+        mHandle->resource = this;
+        try
+        {
+            ::createOriginTimeIndex(*mMongoDBConnection);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Could not create origin time index; custom queries will be slow.  Failed with: "
+                       + std::string {e.what()});
+        }
+        synchronizeCatalog();
     }
     [[nodiscard]] bool keepRunning() const noexcept
     {
         return mKeepRunning;
     }
-    void updateStandardCatalog()
+    /// Reserves an export slot or returns null if every slot is taken.
+    /// The slot is released when the export's stream is destroyed.
+    [[nodiscard]] std::shared_ptr<::ExportSlot> reserveExport()
+    {
+        if (mExports->fetch_add(1) >= mMaximumNumberOfConcurrentExports)
+        {
+            mExports->fetch_sub(1);
+            return nullptr;
+        }
+        return std::make_shared<::ExportSlot> (mExports);
+    }
+    /// The oldest load time of an event in the standard catalog
+    [[nodiscard]] std::chrono::seconds getWindowStart() const
+    {
+        return ::now() - mWindow;
+    }
+    /// Reloads every event in the window.  This also removes events that
+    /// were deleted from the database which an update cannot detect.
+    void synchronizeCatalog()
+    {
+        auto [lastUpdate, storedEvents]
+            = ::getEventsFromMongoDB(*mMongoDBConnection, getWindowStart());
+        std::set<int64_t> identifiers;
+        for (const auto &storedEvent : storedEvents)
+        {
+            identifiers.insert(storedEvent.event.getIdentifier());
+        }
+        applyChanges(lastUpdate, std::move(storedEvents), &identifiers);
+    }
+    /// Fetches only the events that changed since the last query
+    void updateCatalog()
     {
-        auto [lastUpdate, currentEvents] = ::getEventsFromMongoDB(*mMongoDBConnection);
-        auto currentEventsJSON = ::toObject(currentEvents);
-        auto hash = currentEventsJSON["hash"].template get<size_t> ();
+        std::chrono::seconds updatedSince;
+        {
         std::lock_guard<std::mutex> lockGuard(mMutex);
+        updatedSince = mLastUpdate;
+        }
+        if (updatedSince.count() <= 0)
         {
-        mLastUpdate = lastUpdate;
-        mEvents = std::move(currentEvents); 
-        mEventsJSON = std::move(currentEventsJSON);
-        mHash = hash;
+            synchronizeCatalog();
+            return;
         }
+        auto [lastUpdate, storedEvents]
+            = ::getEventsFromMongoDB(*mMongoDBConnection,
+                                     getWindowStart(),
+                                     updatedSince);
+        applyChanges(lastUpdate, std::move(storedEvents), nullptr);
     }
-    [[nodiscard]] nlohmann::json getStandardCatalogJSON() const noexcept
+    /// Patches the event store.  The catalog is only reassembled when
+    /// something changed.
+    void applyChanges(const std::chrono::seconds &lastUpdate,
+                      std::vector<::StoredEvent> &&storedEvents,
+                      const std::set<int64_t> *retainedEvents)
     {
+        std::vector<int64_t> newEvents;
+        std::function<void (const std::vector<int64_t> &)> newEventsCallback;
+        std::shared_ptr<const std::string> notification;
+        std::vector<Subscriber> subscribers;
+        {
         std::lock_guard<std::mutex> lockGuard(mMutex);
-        return mEventsJSON;
+        int nInserted{0};
+        int nUpdated{0};
+        for (auto &storedEvent : storedEvents)
+        {
+            auto identifier = storedEvent.event.getIdentifier();
+            auto change = mEventStore.upsert(std::move(storedEvent));
+            if (change == ::EventStore::Change::Inserted)
+            {
+                nInserted = nInserted + 1;
+                // The initial load is the backlog not news so only report
+                // events that appeared after that
+                if (mHaveCatalog){newEvents.push_back(identifier);}
+            }
+            else if (change == ::EventStore::Change::Updated)
+            {
+                nUpdated = nUpdated + 1;
+            }
+        }
+        std::vector<int64_t> removedEvents;
+        if (retainedEvents != nullptr)
+        {
+            removedEvents = mEventStore.retainOnly(*retainedEvents);
+        }
+        auto agedOutEvents = mEventStore.ageOut(getWindowStart());
+        removedEvents.insert(removedEvents.end(),
+                             agedOutEvents.begin(), agedOutEvents.end());
+        if (!mHaveCatalog || nInserted > 0 || nUpdated > 0 ||
+            !removedEvents.empty())
+        {
+            spdlog::info("Catalog update: "
+                       + std::to_string(nInserted) + " inserted, "
+                       + std::to_string(nUpdated) + " updated, "
+                       + std::to_string(removedEvents.size()) + " removed");
+            mSerializedCatalog
+                = std::make_shared<const std::string>
+                  (mEventStore.serialize());
+            mHash = mEventStore.getHash();
+            if (mHaveCatalog && !mSubscribers.empty())
+            {
+                notification = createNotification(mNotifiedVersion);
+                subscribers.reserve(mSubscribers.size());
+                for (const auto &subscriber : mSubscribers)
+                {
+                    subscribers.push_back(subscriber.second);
+                }
+            }
+        }
+        else
+        {
+            spdlog::debug("No catalog update; going back to sleep");
+        }
+        mLastUpdate = std::max(mLastUpdate, lastUpdate);
+        mNotifiedVersion = mEventStore.getVersion();
+        mHaveCatalog = true;
+        newEventsCallback = mNewEventsCallback;
+        }
+        if (notification)
+        {
+            for (const auto &subscriber : subscribers)
+            {
+                try
+                {
+                    subscriber(notification);
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Catalog subscriber failed with: "
+                               + std::string {e.what()});
+                }
+            }
+        }
+        if (!newEvents.empty() && newEventsCallback)
+        {
+            spdlog::debug(std::to_string(newEvents.size())
+                        + " new events in catalog");
+            try
+            {
+                newEventsCallback(newEvents);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("New events callback failed with: "
+                           + std::string {e.what()});
+            }
+        }
+    }
+    /// The serialized catalog.  This is shared by all requests and
+    /// replaced, not modified, when the catalog changes.
+    [[nodiscard]] std::shared_ptr<const std::string>
+        getSerializedCatalog() const noexcept
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        return mSerializedCatalog;
     }
     [[nodiscard]] size_t getHash() const noexcept
     {
         std::lock_guard<std::mutex> lockGuard(mMutex);
         return mHash;
     }
+    [[nodiscard]] std::shared_ptr<const MLReview::Service::Geofence>
+        getGeofence() const noexcept
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        return mGeofence;
+    }
+    /// The filter as a test on events read from the database
+    [[nodiscard]] std::function<bool (const Event &)>
+        toPredicate(const std::optional<::SpatialFilter> &filter) const
+    {
+        if (!filter){return nullptr;}
+        auto geofence = getGeofence();
+        return [filter = *filter, geofence](const Event &event)
+               {
+                   auto origin = event.getPreferredOrigin();
+                   return filter.contains(origin.getLatitude(),
+                                          origin.getLongitude(),
+                                          geofence.get());
+               };
+    }
+    /// Queries the in-memory catalog using the spatial index if there is
+    /// a spatial filter.
+    /// @note The caller must hold the lock.
+    [[nodiscard]] ::EventPage queryEventStore(
+        const std::chrono::microseconds &startTime,
+        const std::chrono::microseconds &endTime,
+        const std::optional<::EventKey> &after,
+        const size_t maxEvents,
+        const std::optional<::SpatialFilter> &filter) const
+    {
+        if (filter)
+        {
+            return mEventStore.query(startTime, endTime, after, maxEvents,
+                                     *filter, mGeofence.get());
+        }
+        return mEventStore.query(startTime, endTime, after, maxEvents);
+    }
+    /// The events in the standard catalog that satisfy the spatial filter
+    [[nodiscard]] nlohmann::json
+        queryStandardCatalog(const ::SpatialFilter &filter) const
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        auto page = queryEventStore(std::chrono::microseconds::min(),
+                                    std::chrono::microseconds::max(),
+                                    std::nullopt,
+                                    std::numeric_limits<size_t>::max(),
+                                    filter);
+        nlohmann::json result;
+        result["events"] = std::move(page.events);
+        result["hash"] = page.hash;
+        result["version"] = mEventStore.getVersion();
+        return result;
+    }
+    /// Answers a custom query.  Windows the in-memory catalog covers are
+    /// answered from its time index.  Older windows go to the database and
+    /// their results are cached unless they are spatially filtered.
+    [[nodiscard]] nlohmann::json queryCatalog(
+        const std::chrono::seconds &startTime,
+        const std::chrono::seconds &endTime,
+        const std::optional<::SpatialFilter> &filter = std::nullopt)
+    {
+        constexpr std::chrono::seconds cacheLifetime{300};
+        nlohmann::json result;
+        if (startTime >= getWindowStart())
+        {
+            std::lock_guard<std::mutex> lockGuard(mMutex);
+            auto page = queryEventStore(startTime, endTime, std::nullopt,
+                                        std::numeric_limits<size_t>::max(),
+                                        filter);
+            result["events"] = std::move(page.events);
+            result["hash"] = page.hash;
+            return result;
+        }
+        if (filter)
+        {
+            auto page = ::getEventPageFromMongoDB(*mMongoDBConnection,
+                                                  startTime, endTime,
+                                                  std::nullopt, 8192,
+                                                  toPredicate(filter));
+            if (page.next)
+            {
+                spdlog::warn("Custom query truncated; use pageSize to get all events");
+            }
+            result["events"] = std::move(page.events);
+            result["hash"] = page.hash;
+            return result;
+        }
+        auto key = std::pair {startTime.count(), endTime.count()};
+        {
+        std::lock_guard<std::mutex> lockGuard(mQueryCacheMutex);
+        auto it = mQueryCache.find(key);
+        if (it != mQueryCache.end() &&
+            ::now() < it->second.queryTime + cacheLifetime)
+        {
+            return it->second.result;
+        }
+        }
+        auto page = ::getEventPageFromMongoDB(*mMongoDBConnection,
+                                              startTime, endTime);
+        if (page.next)
+        {
+            spdlog::warn("Custom query truncated; use pageSize to get all events");
+        }
+        result["events"] = std::move(page.events);
+        result["hash"] = page.hash;
+        {
+        std::lock_guard<std::mutex> lockGuard(mQueryCacheMutex);
+        if (mQueryCache.size() >= mMaximumNumberOfCachedQueries &&
+            !mQueryCache.contains(key))
+        {
+            auto oldest = std::min_element(mQueryCache.begin(),
+                                           mQueryCache.end(),
+                                           [](const auto &lhs, const auto &rhs)
+                                           {
+                                               return lhs.second.queryTime
+                                                    < rhs.second.queryTime;
+                                           });
+            mQueryCache.erase(oldest);
+        }
+        mQueryCache.insert_or_assign(key, ::CachedQuery {result, ::now()});
+        }
+        return result;
+    }
+    /// Gets a page of events in the window sorted by origin time.  The
+    /// continuation token is set when there may be more events.
+    [[nodiscard]] nlohmann::json queryCatalogPage(
+        const std::chrono::seconds &startTime,
+        const std::chrono::seconds &endTime,
+        const std::optional<::EventKey> &after,
+        const int pageSize,
+        const std::optional<::SpatialFilter> &filter = std::nullopt)
+    {
+        ::EventPage page;
+        if (startTime >= getWindowStart())
+        {
+            std::lock_guard<std::mutex> lockGuard(mMutex);
+            page = queryEventStore(startTime, endTime, after,
+                                   static_cast<size_t> (pageSize), filter);
+        }
+        else
+        {
+            page = ::getEventPageFromMongoDB(*mMongoDBConnection,
+                                             startTime, endTime,
+                                             after, pageSize,
+                                             toPredicate(filter));
+        }
+        nlohmann::json result;
+        result["events"] = std::move(page.events);
+        if (page.next)
+        {
+            result["continuationToken"] = ::toContinuationToken(*page.next);
+        }
+        else
+        {
+            result["continuationToken"] = nullptr;
+        }
+        return result;
+    }
+    [[nodiscard]] uint64_t getVersion() const noexcept
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        return mEventStore.getVersion();
+    }
+    /// The changes since the given version or nothing if the change log
+    /// does not reach back that far and the full catalog is required
+    [[nodiscard]] std::optional<nlohmann::json>
+        getChangesSince(const uint64_t version) const
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        auto changes = mEventStore.getChangesSince(version);
+        if (changes)
+        {
+            (*changes)["full"] = false;
+            (*changes)["hash"] = mHash;
+        }
+        return changes;
+    }
+    /// Serializes the changes since the given version for subscribers.
+    /// Large deltas, or deltas the change log no longer covers, are sent as
+    /// just the new version and hash so that the subscriber can request
+    /// what it needs with sinceVersion.
+    /// @note The caller must hold the lock.
+    [[nodiscard]] std::shared_ptr<const std::string>
+        createNotification(const uint64_t version) const
+    {
+        nlohmann::json data;
+        auto changes = mEventStore.getChangesSince(version);
+        if (changes &&
+            (*changes)["upserted"].size() <= mMaximumNotificationSize)
+        {
+            data = std::move(*changes);
+            data["type"] = "delta";
+        }
+        else
+        {
+            data["type"] = "version";
+            data["fromVersion"] = version;
+            data["version"] = mEventStore.getVersion();
+        }
+        data["resource"] = RESOURCE_NAME;
+        data["full"] = false;
+        data["hash"] = mHash;
+        auto response = std::make_unique<Response> ();
+        response->setMessage("Catalog update notification");
+        response->setData(std::move(data));
+        std::unique_ptr<MLReview::Messages::IMessage> message
+            = std::move(response);
+        return std::make_shared<const std::string>
+               (MLReview::Messages::toJSON(message));
+    }
+    [[nodiscard]] int64_t subscribe(const Subscriber &subscriber)
+    {
+        if (!subscriber)
+        {
+            throw std::invalid_argument("Subscriber callback not set");
+        }
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        mNextSubscriberIdentifier = mNextSubscriberIdentifier + 1;
+        mSubscribers.insert(std::pair {mNextSubscriberIdentifier,
+                                       subscriber});
+        spdlog::debug("Catalog has " + std::to_string(mSubscribers.size())
+                    + " subscribers");
+        return mNextSubscriberIdentifier;
+    }
+    void unsubscribe(const int64_t identifier) noexcept
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        mSubscribers.erase(identifier);
+    }
+    /// Applies a single change from the change stream.  False indicates
+    /// the stream was invalidated and must be reopened.  A delete only
+    /// identifies the document by its _id so it sets needsSynchronization
+    /// and the caller rescans the catalog once the pending changes have
+    /// been applied.
+    [[nodiscard]] bool applyChange(const bsoncxx::document::view &change,
+                                   bool &needsSynchronization)
+    {
+        auto json = bsoncxx::to_json(change,
+                                     bsoncxx::ExtendedJsonMode::k_relaxed);
+        auto jsonObject = nlohmann::json::parse(json);
+        auto operationType
+            = jsonObject.at("operationType").template get<std::string> ();
+        if (operationType == "insert" ||
+            operationType == "update" ||
+            operationType == "replace")
+        {
+            // The document may have been deleted before it was looked up
+            if (!jsonObject.contains("fullDocument") ||
+                jsonObject["fullDocument"].is_null())
+            {
+                return true;
+            }
+            std::vector<::StoredEvent> storedEvents;
+            storedEvents.push_back(::toStoredEvent(jsonObject["fullDocument"]));
+            auto lastUpdate = storedEvents.back().lastUpdate;
+            applyChanges(lastUpdate, std::move(storedEvents), nullptr);
+        }
+        else if (operationType == "delete")
+        {
+            needsSynchronization = true;
+        }
+        else if (operationType == "invalidate" ||
+                 operationType == "drop" ||
+                 operationType == "rename" ||
+                 operationType == "dropDatabase")
+        {
+            spdlog::warn("Change stream invalidated by " + operationType);
+            mResumeToken.reset();
+            return false;
+        }
+        return true;
+    }
+    /// Applies the changes to the events collection as they happen.  This
+    /// returns when the resource is stopped and throws if the server does
+    /// not support change streams - e.g., it is not a replica set - or if
+    /// the stream could not be resumed from the resume token.
+    void watchCatalog()
+    {
+        constexpr std::chrono::seconds maintenanceInterval{30};
+        using namespace bsoncxx::builder::basic;
+        // The watcher blocks on the server so it uses its own client
+        mongocxx::client client{
+            mongocxx::uri {mMongoDBConnection->getConnectionString()}
+        };
+        auto database = client.database(mMongoDBConnection->getDatabaseName());
+        auto collection = database.collection(COLLECTION_NAME);
+        mongocxx::pipeline pipeline;
+        pipeline.project(make_document(kvp("fullDocument.waveformData", 0)));
+        mongocxx::options::change_stream options;
+        options.full_document("updateLookup");
+        options.max_await_time(std::chrono::milliseconds {1000});
+        bool resuming{false};
+        if (mResumeToken)
+        {
+            options.resume_after(mResumeToken->view());
+            resuming = true;
+        }
+        auto stream = collection.watch(pipeline, options);
+        // Without a resume token the changes made since the last query are
+        // unknown so catch up now that the stream is open
+        if (!resuming){synchronizeCatalog();}
+        spdlog::info("Watching catalog change stream...");
+        auto lastMaintenanceTime = ::now();
+        while (mKeepRunning && mUseChangeStream)
+        {
+            // Deletes are batched into one rescan per pass over the stream
+            bool needsSynchronization{false};
+            for (const auto &change : stream)
+            {
+                bool valid{true};
+                try
+                {
+                    valid = applyChange(change, needsSynchronization);
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to apply catalog change; failed with: "
+                               + std::string {e.what()});
+                }
+                if (!valid)
+                {
+                    throw std::runtime_error("Change stream was invalidated");
+                }
+                if (!mKeepRunning){break;}
+            }
+            if (needsSynchronization && mKeepRunning){synchronizeCatalog();}
+            auto resumeToken = stream.get_resume_token();
+            if (resumeToken)
+            {
+                mResumeToken = bsoncxx::document::value {*resumeToken};
+            }
+            // Events still have to leave the window
+            auto currentTime = ::now();
+            if (currentTime > lastMaintenanceTime + maintenanceInterval)
+            {
+                lastMaintenanceTime = currentTime;
+                applyChanges(std::chrono::seconds {0}, {}, nullptr);
+            }
+        }
+        spdlog::info("Ending catalog change stream");
+    }
     void pollCatalog()
     {
         constexpr std::chrono::seconds queryInterval{30};
+        // Deletions are only caught by a full synchronization
+        constexpr std::chrono::seconds synchronizationInterval{3600};
+        constexpr std::chrono::seconds watchRetryInterval{600};
         spdlog::info("Beginning catalog polling...");
         auto lastQueryTime = ::now();
+        auto lastSynchronizationTime = lastQueryTime;
+        std::chrono::seconds nextWatchTime{0};
         while (true)
         {
             if (!mKeepRunning){break;}
+            if (mUseChangeStream && ::now() >= nextWatchTime)
+            {
+                try
+                {
+                    watchCatalog();
+                }
+                catch (const std::exception &e)
+                {
+                    // The resume token may have fallen off the oplog.
+                    // Either way, the stream has to be reopened without it
+                    // which also resynchronizes the catalog.
+                    if (mResumeToken)
+                    {
+                        spdlog::warn("Catalog change stream could not be resumed; reopening.  Failed with: "
+                                   + std::string {e.what()});
+                        mResumeToken.reset();
+                        continue;
+                    }
+                    spdlog::warn("Catalog change stream unavailable; polling for "
+                               + std::to_string(watchRetryInterval.count())
+                               + " s.  Failed with: " + std::string {e.what()});
+                    nextWatchTime = ::now() + watchRetryInterval;
+                    lastQueryTime = ::now() - queryInterval;
+                }
+                continue;
+            }
             auto currentTime = ::now();
             if (currentTime > lastQueryTime + queryInterval)
             {
                 lastQueryTime = currentTime;
-                auto lastUpdate = ::getLastUpdate(*mMongoDBConnection, mLastUpdate);
-                if (lastUpdate > mLastUpdate)
+                try
                 {
-                    mLastUpdate = lastUpdate;
-                    spdlog::info("Catalog update!");
-                    updateStandardCatalog();
+                    if (currentTime >
+                        lastSynchronizationTime + synchronizationInterval)
+                    {
+                        lastSynchronizationTime = currentTime;
+                        synchronizeCatalog();
+                    }
+                    else
+                    {
+                        updateCatalog();
+                    }
                 }
-                else
+                catch (const std::exception &e)
                 {
-                    spdlog::debug("No catalog update; going back to sleep");
+                    spdlog::warn("Failed to update catalog; failed with: "
+                               + std::string {e.what()});
                 }
             }
             std::this_thread::sleep_for(std::chrono::seconds {1});
@@ -426,21 +1161,60 @@ spdlog::warn("Need to make polling thread pop events over 2 weeks old");
         mKeepRunning = false;
         if (mQueryThread.joinable()){mQueryThread.join();}
     }
+    /// The (latitude, longitude) of the event's preferred origin or nothing
+    /// if the event is not in the standard catalog
+    [[nodiscard]] std::optional<std::pair<double, double>>
+        getEpicenter(const int64_t identifier) const
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        const auto storedEvent = mEventStore.find(identifier);
+        if (storedEvent == nullptr){return std::nullopt;}
+        return std::optional<std::pair<double, double>>
+               (std::pair {storedEvent->latitude, storedEvent->longitude});
+    }
     ~ResourceImpl()
     {
         stop();
+        std::lock_guard<std::mutex> lockGuard(mHandle->mutex);
+        mHandle->resource = nullptr;
     }
+    /// Lets functions given to other resources reach this one for as long
+    /// as it exists
+    struct Handle
+    {
+        std::mutex mutex;
+        ResourceImpl *resource{nullptr};
+    };
+    std::shared_ptr<Handle> mHandle{std::make_shared<Handle> ()};
     mutable std::mutex mMutex;
     std::thread mQueryThread;
     std::atomic<bool> mKeepRunning{true};
+    std::atomic<bool> mUseChangeStream{false};
+    std::optional<bsoncxx::document::value> mResumeToken;
     std::shared_ptr<MLReview::Database::Connection::MongoDB>
         mMongoDBConnection{nullptr};
     //std::shared_ptr<MLReview::Database::Connection::PostgreSQL>
     //    mAQMSConnection{nullptr};
-    std::vector<Event> mEvents;
-    nlohmann::json mEventsJSON;
+    ::EventStore mEventStore;
+    std::mutex mQueryCacheMutex;
+    std::map<std::pair<int64_t, int64_t>, ::CachedQuery> mQueryCache;
+    size_t mMaximumNumberOfCachedQueries{16};
+    std::shared_ptr<const std::string> mSerializedCatalog{nullptr};
+    std::shared_ptr<const MLReview::Service::Geofence> mGeofence{nullptr};
+    std::function<void (const std::vector<int64_t> &)> mNewEventsCallback;
+    std::map<int64_t, Subscriber> mSubscribers;
+    int64_t mNextSubscriberIdentifier{0};
+    uint64_t mNotifiedVersion{0};
+    size_t mMaximumNotificationSize{512};
+    std::shared_ptr<std::atomic<int>> mExports
+    {
+        std::make_shared<std::atomic<int>> (0)
+    };
+    std::atomic<int> mMaximumNumberOfConcurrentExports{4};
+    std::chrono::seconds mWindow{86400*14};
     std::chrono::seconds mLastUpdate{0};
     size_t mHash{0};
+    bool mHaveCatalog{false};
 };
 
 /// Constructor
@@ -454,6 +1228,107 @@ Resource::Resource(
 /// Destructor
 Resource::~Resource() = default;
 
+/// New events callback
+void Resource::setNewEventsCallback(
+    const std::function<void (const std::vector<int64_t> &)> &callback)
+{
+    std::lock_guard<std::mutex> lockGuard(pImpl->mMutex);
+    pImpl->mNewEventsCallback = callback;
+}
+
+/// Epicenter callback
+std::function<std::optional<std::pair<double, double>> (int64_t)>
+    Resource::getEpicenterCallback() const
+{
+    auto handle = pImpl->mHandle;
+    return [handle](const int64_t identifier)
+           {
+               std::lock_guard<std::mutex> lockGuard(handle->mutex);
+               if (handle->resource == nullptr)
+               {
+                   return std::optional<std::pair<double, double>> {};
+               }
+               return handle->resource->getEpicenter(identifier);
+           };
+}
+
+/// ETag
+std::optional<std::string>
+    Resource::getETag(const nlohmann::json &request) const
+{
+    // Only the standard catalog and its deltas are versioned
+    for (const auto &key : {"startTime", "endTime", "pageSize",
+                            "continuationToken", "export",
+                            "bbox", "region", "radius"})
+    {
+        if (request.contains(key)){return std::nullopt;}
+    }
+    if (request.contains("hashOnly") &&
+        request["hashOnly"].template get<bool> ())
+    {
+        return std::nullopt;
+    }
+    auto version = std::to_string(pImpl->getVersion());
+    if (request.contains("sinceVersion"))
+    {
+        auto sinceVersion = request["sinceVersion"].template get<uint64_t> ();
+        return std::string {RESOURCE_NAME} + "-"
+             + std::to_string(sinceVersion) + "-" + version;
+    }
+    return std::string {RESOURCE_NAME} + "-" + version;
+}
+
+/// Geofence
+void Resource::setGeofence(
+    const std::shared_ptr<const MLReview::Service::Geofence> &geofence)
+{
+    std::lock_guard<std::mutex> lockGuard(pImpl->mMutex);
+    pImpl->mGeofence = geofence;
+}
+
+/// Subscriptions
+int64_t Resource::subscribe(
+    const std::function<void (const std::shared_ptr<const std::string> &)> &callback)
+{
+    return pImpl->subscribe(callback);
+}
+
+void Resource::unsubscribe(const int64_t identifier) noexcept
+{
+    pImpl->unsubscribe(identifier);
+}
+
+/// Change streams
+void Resource::enableChangeStream() noexcept
+{
+    pImpl->mUseChangeStream = true;
+}
+
+void Resource::disableChangeStream() noexcept
+{
+    pImpl->mUseChangeStream = false;
+}
+
+bool Resource::isChangeStreamEnabled() const noexcept
+{
+    return pImpl->mUseChangeStream;
+}
+
+/// Exports
+void Resource::setMaximumNumberOfConcurrentExports(const int nExports)
+{
+    if (nExports < 1)
+    {
+        throw std::invalid_argument("Number of exports must be positive");
+    }
+    pImpl->mMaximumNumberOfConcurrentExports = nExports;
+}
+
+int Resource::getMaximumNumberOfConcurrentExports() const noexcept
+{
+    return pImpl->mMaximumNumberOfConcurrentExports;
+}
+
 /// Resource name
 std::string Resource::getName() const noexcept
 {
@@ -516,31 +1391,118 @@ Resource::processRequest(const nlohmann::json &request)
             }
         }
     }
+    // Large or historical catalogs can be paged or streamed
+    int pageSize{0};
+    if (request.contains("pageSize"))
+    {
+        pageSize = request["pageSize"].template get<int> ();
+        if (pageSize < 1 || pageSize > MAXIMUM_PAGE_SIZE)
+        {
+            throw std::invalid_argument("pageSize must be in range [1,"
+                                      + std::to_string(MAXIMUM_PAGE_SIZE)
+                                      + "]");
+        }
+    }
+    std::optional<::EventKey> after;
+    if (request.contains("continuationToken") &&
+        !request["continuationToken"].is_null())
+    {
+        after = ::fromContinuationToken(
+            request["continuationToken"].template get<std::string> ());
+    }
+    bool exportCatalog{false};
+    if (request.contains("export"))
+    {
+        exportCatalog = request["export"].template get<bool> ();
+    }
+    auto spatialFilter
+        = ::parseSpatialFilter(request, pImpl->getGeofence().get());
     auto response = std::make_unique<Response> ();
-    if (!customQuery)
+    if (exportCatalog)
+    {
+        auto slot = pImpl->reserveExport();
+        if (!slot)
+        {
+            spdlog::warn("Refusing catalog export; "
+                       + std::to_string(pImpl->mMaximumNumberOfConcurrentExports)
+                       + " exports are in progress");
+            auto errorResponse
+                = std::make_unique<MLReview::Messages::Error> ();
+            errorResponse->setMessage(
+                "Too many catalog exports in progress; try again later");
+            errorResponse->setStatusCode(503);
+            return errorResponse;
+        }
+        auto stream
+            = ::streamEventsFromMongoDB(*pImpl->mMongoDBConnection,
+                                        startTime, endTime,
+                                        pImpl->toPredicate(spatialFilter));
+        response->setMessage("Successful response to catalog export request");
+        response->setDataStream(
+            [stream, slot]()
+            {
+                return stream();
+            });
+    }
+    else if (pageSize > 0 || after)
+    {
+        if (pageSize < 1){pageSize = DEFAULT_PAGE_SIZE;}
+        response->setMessage("Successful response to paged catalog request");
+        response->setData(pImpl->queryCatalogPage(startTime, endTime,
+                                                  after, pageSize,
+                                                  spatialFilter));
+    }
+    else if (!customQuery)
     {
         bool hashOnly{false};
         if (request.contains("hashOnly"))
         {
             hashOnly = request["hashOnly"].template get<bool> ();
         }
+        if (spatialFilter && (hashOnly || request.contains("sinceVersion")))
+        {
+            throw std::invalid_argument(
+               "Spatial filters cannot be combined with hashOnly or sinceVersion");
+        }
         if (hashOnly)
         {
             nlohmann::json result;
             result["hash"] = pImpl->getHash();
+            result["version"] = pImpl->getVersion();
             response->setMessage("Successful response to standard catalog hash request");
             response->setData(std::move(result));
         }
+        else if (request.contains("sinceVersion"))
+        {
+            auto sinceVersion
+                = request["sinceVersion"].template get<uint64_t> ();
+            response->setMessage("Successful response to standard catalog changes request");
+            auto changes = pImpl->getChangesSince(sinceVersion);
+            if (changes)
+            {
+                response->setData(std::move(*changes));
+            }
+            else
+            {
+                response->setSerializedData(pImpl->getSerializedCatalog());
+            }
+        }
+        else if (spatialFilter)
+        {
+            response->setMessage("Successful response to spatially filtered standard catalog request");
+            response->setData(pImpl->queryStandardCatalog(*spatialFilter));
+        }
         else
         {
             response->setMessage("Successful response to standard catalog request");
-            response->setData(std::move(pImpl->getStandardCatalogJSON()));
+            response->setSerializedData(pImpl->getSerializedCatalog());
         }
     }
     else
     {
         response->setMessage("Successful response to custom catalog request");
-        response->setData(pImpl->mEventsJSON); // TODO
+        response->setData(pImpl->queryCatalog(startTime, endTime,
+                                              spatialFilter));
     } 
     return response;
 }
@@ -1,4 +1,6 @@
 #include <string>
+#include <memory>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "mlReview/service/catalog/response.hpp"
 
@@ -8,6 +10,8 @@ class Response::ResponseImpl
 {
 public:
     nlohmann::json mData;
+    std::function<std::optional<std::string> ()> mDataStream{nullptr};
+    std::shared_ptr<const std::string> mSerializedData{nullptr};
     std::string mMessage;
 };
 
@@ -42,6 +46,14 @@ void Response::setData(const nlohmann::json &data) noexcept
 void Response::setData(nlohmann::json &&data) noexcept
 {
     pImpl->mData = std::move(data); 
+    pImpl->mSerializedData = nullptr;
+}
+
+void Response::setSerializedData(
+    const std::shared_ptr<const std::string> &data) noexcept
+{
+    pImpl->mSerializedData = data;
+    pImpl->mData = nlohmann::json {};
 }
 
 /// Get the data
@@ -53,3 +65,26 @@ std::optional<nlohmann::json> Response::getData() const noexcept
     }
     return std::nullopt;
 }
+
+/// Set the data stream
+void Response::setDataStream(
+    const std::function<std::optional<std::string> ()> &dataStream) noexcept
+{
+    pImpl->mDataStream = dataStream;
+}
+
+/// Get the data stream
+std::function<std::optional<std::string> ()>
+    Response::getDataStream() const noexcept
+{
+    if (pImpl->mDataStream){return pImpl->mDataStream;}
+    if (!pImpl->mSerializedData){return nullptr;}
+    auto data = pImpl->mSerializedData;
+    auto done = std::make_shared<bool> (false);
+    return [data, done]() -> std::optional<std::string>
+           {
+               if (*done){return std::nullopt;}
+               *done = true;
+               return *data;
+           };
+}
@@ -0,0 +1,253 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/polygon.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <spdlog/spdlog.h>
+#include "mlReview/service/geofence.hpp"
+#include "private/lonTo180.hpp"
+
+using namespace MLReview::Service;
+
+namespace
+{
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+// Points are (longitude, latitude)
+using Point = bg::model::point<double, 2, bg::cs::cartesian>;
+using Box = bg::model::box<Point>;
+using Polygon = bg::model::polygon<Point>;
+
+Point toPoint(const double latitude, const double longitude)
+{
+    if (latitude < -90 || latitude > 90)
+    {
+        throw std::invalid_argument("Latitude must in be in range [-90,90]");
+    }
+    return Point {::lonTo180(longitude), latitude};
+}
+
+struct Region
+{
+    std::string name;
+    Polygon polygon;
+    Box boundingBox;
+};
+
+/// Parses a list of latitude,longitude vertices
+std::vector<std::pair<double, double>> parseVertices(const std::string &list)
+{
+    std::vector<std::pair<double, double>> vertices;
+    std::istringstream stream{list};
+    std::string vertex;
+    while (stream >> vertex)
+    {
+        auto comma = vertex.find(',');
+        if (comma == std::string::npos)
+        {
+            throw std::invalid_argument("Vertex " + vertex
+                                      + " must be latitude,longitude");
+        }
+        vertices.push_back(std::pair {std::stod(vertex.substr(0, comma)),
+                                      std::stod(vertex.substr(comma + 1))});
+    }
+    return vertices;
+}
+
+}
+
+class Geofence::GeofenceImpl
+{
+public:
+    std::vector<::Region> mRegions;
+    // The regions' bounding boxes and indices
+    bgi::rtree<std::pair<::Box, size_t>, bgi::quadratic<16>> mIndex;
+};
+
+/// Constructor
+Geofence::Geofence() :
+    pImpl(std::make_unique<GeofenceImpl> ())
+{
+}
+
+/// Copy constructor
+Geofence::Geofence(const Geofence &geofence)
+{
+    *this = geofence;
+}
+
+/// Move constructor
+Geofence::Geofence(Geofence &&geofence) noexcept
+{
+    *this = std::move(geofence);
+}
+
+/// Copy assignment
+Geofence& Geofence::operator=(const Geofence &geofence)
+{
+    if (&geofence == this){return *this;}
+    pImpl = std::make_unique<GeofenceImpl> (*geofence.pImpl);
+    return *this;
+}
+
+/// Move assignment
+Geofence& Geofence::operator=(Geofence &&geofence) noexcept
+{
+    if (&geofence == this){return *this;}
+    pImpl = std::move(geofence.pImpl);
+    return *this;
+}
+
+/// Destructor
+Geofence::~Geofence() = default;
+
+/// Add a region
+void Geofence::addRegion(
+    const std::string &name,
+    const std::vector<std::pair<double, double>> &vertices)
+{
+    if (name.empty()){throw std::invalid_argument("Region name is empty");}
+    if (haveRegion(name))
+    {
+        throw std::invalid_argument("Region " + name + " already exists");
+    }
+    if (vertices.size() < 3)
+    {
+        throw std::invalid_argument("Region " + name
+                                  + " needs at least three vertices");
+    }
+    ::Region region;
+    region.name = name;
+    for (const auto &vertex : vertices)
+    {
+        bg::append(region.polygon.outer(),
+                   ::toPoint(vertex.first, vertex.second));
+    }
+    // Orients and closes the ring
+    bg::correct(region.polygon);
+    region.boundingBox = bg::return_envelope<::Box> (region.polygon);
+    pImpl->mIndex.insert(std::pair {region.boundingBox,
+                                    pImpl->mRegions.size()});
+    pImpl->mRegions.push_back(std::move(region));
+    spdlog::debug("Added region " + name);
+}
+
+/// Load regions from a file
+void Geofence::load(const std::filesystem::path &initializationFile)
+{
+    if (!std::filesystem::exists(initializationFile))
+    {
+        throw std::invalid_argument("Regions file "
+                                  + initializationFile.string()
+                                  + " does not exist");
+    }
+    boost::property_tree::ptree propertyTree;
+    boost::property_tree::ini_parser::read_ini(initializationFile.string(),
+                                               propertyTree);
+    for (const auto &section : propertyTree)
+    {
+        auto polygon = section.second.get<std::string> ("polygon", "");
+        if (polygon.empty())
+        {
+            throw std::invalid_argument("Region " + section.first
+                                      + " has no polygon");
+        }
+        addRegion(section.first, ::parseVertices(polygon));
+    }
+}
+
+/// Region names
+std::vector<std::string> Geofence::getRegions() const noexcept
+{
+    std::vector<std::string> result;
+    result.reserve(pImpl->mRegions.size());
+    for (const auto &region : pImpl->mRegions)
+    {
+        result.push_back(region.name);
+    }
+    return result;
+}
+
+/// Have region?
+bool Geofence::haveRegion(const std::string &name) const noexcept
+{
+    return std::any_of(pImpl->mRegions.begin(), pImpl->mRegions.end(),
+                       [&name](const ::Region &region)
+                       {
+                           return region.name == name;
+                       });
+}
+
+/// Bounding box
+std::array<double, 4> Geofence::getBoundingBox(const std::string &name) const
+{
+    for (const auto &region : pImpl->mRegions)
+    {
+        if (region.name == name)
+        {
+            const auto &minCorner = region.boundingBox.min_corner();
+            const auto &maxCorner = region.boundingBox.max_corner();
+            return std::array<double, 4> {bg::get<1> (minCorner),
+                                          bg::get<0> (minCorner),
+                                          bg::get<1> (maxCorner),
+                                          bg::get<0> (maxCorner)};
+        }
+    }
+    throw std::invalid_argument("Region " + name + " does not exist");
+}
+
+/// In region?
+bool Geofence::isInRegion(const std::string &name,
+                          const double latitude,
+                          const double longitude) const
+{
+    auto point = ::toPoint(latitude, longitude);
+    for (const auto &region : pImpl->mRegions)
+    {
+        if (region.name == name)
+        {
+            return bg::covered_by(point, region.polygon);
+        }
+    }
+    throw std::invalid_argument("Region " + name + " does not exist");
+}
+
+/// Classify a point
+std::string Geofence::classify(const double latitude,
+                               const double longitude) const
+{
+    auto point = ::toPoint(latitude, longitude);
+    std::vector<std::pair<::Box, size_t>> candidates;
+    pImpl->mIndex.query(bgi::covers(point), std::back_inserter(candidates));
+    // Earlier regions take precedence
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto &lhs, const auto &rhs)
+              {
+                  return lhs.second < rhs.second;
+              });
+    for (const auto &candidate : candidates)
+    {
+        const auto &region = pImpl->mRegions.at(candidate.second);
+        if (bg::covered_by(point, region.polygon)){return region.name;}
+    }
+    return "";
+}
+
+/// Classify many points
+std::vector<std::string> Geofence::classify(
+    const std::vector<std::pair<double, double>> &points) const
+{
+    std::vector<std::string> result;
+    result.reserve(points.size());
+    for (const auto &point : points)
+    {
+        result.push_back(classify(point.first, point.second));
+    }
+    return result;
+}
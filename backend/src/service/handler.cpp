@@ -2,6 +2,8 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <functional>
+#include <spdlog/spdlog.h>
 #include <nlohmann/json.hpp>
 #include "mlReview/service/handler.hpp"
 #include "mlReview/service/resource.hpp"
@@ -46,6 +48,69 @@ public:
     bool getSuccess() const noexcept override final {return true;}; 
     std::vector<std::string> mResources;
 };
+
+/// The client already has the current version of the data
+class NotModifiedMessage : public MLReview::Messages::IMessage
+{
+public:
+    explicit NotModifiedMessage(const std::string &eTag) :
+        mETag(eTag)
+    {
+    }
+    ~NotModifiedMessage() override = default;
+    std::optional<std::string> getMessage() const noexcept override final
+    {
+        return std::optional<std::string> ("not modified");
+    }
+    std::optional<std::string> getETag() const noexcept override final
+    {
+        return std::optional<std::string> (mETag);
+    }
+    int getStatusCode() const noexcept override final {return 304;};
+    bool getSuccess() const noexcept override final {return true;};
+    std::string mETag;
+};
+
+/// Attaches the resource's ETag to its response
+class TaggedMessage : public MLReview::Messages::IMessage
+{
+public:
+    TaggedMessage(std::unique_ptr<MLReview::Messages::IMessage> &&message,
+                  const std::string &eTag) :
+        mMessage(std::move(message)),
+        mETag(eTag)
+    {
+    }
+    ~TaggedMessage() override = default;
+    std::optional<nlohmann::json> getData() const noexcept override final
+    {
+        return mMessage->getData();
+    }
+    std::function<std::optional<std::string> ()>
+        getDataStream() const noexcept override final
+    {
+        return mMessage->getDataStream();
+    }
+    std::optional<std::string> getMessage() const noexcept override final
+    {
+        return mMessage->getMessage();
+    }
+    std::optional<std::string> getETag() const noexcept override final
+    {
+        return std::optional<std::string> (mETag);
+    }
+    int getStatusCode() const noexcept override final
+    {
+        return mMessage->getStatusCode();
+    }
+    bool getSuccess() const noexcept override final
+    {
+        return mMessage->getSuccess();
+    }
+    std::unique_ptr<MLReview::Messages::IMessage> mMessage;
+    std::string mETag;
+};
+
 }
 
 class Handler::HandlerImpl
@@ -100,6 +165,52 @@ std::vector<std::string> Handler::getResources() const noexcept
     return result;
 }
 
+/// Subscribes to a resource
+int64_t Handler::subscribe(
+    const std::string &resourceName,
+    const std::function<void (const std::shared_ptr<const std::string> &)> &callback) const
+{
+    auto resource = pImpl->mResources.find(resourceName);
+    if (resource == pImpl->mResources.end())
+    {
+        throw std::invalid_argument("resource: " + resourceName
+                                  + " does not exist");
+    }
+    return resource->second->subscribe(callback);
+}
+
+/// Unsubscribes from a resource
+void Handler::unsubscribe(const std::string &resourceName,
+                          const int64_t identifier) const noexcept
+{
+    auto resource = pImpl->mResources.find(resourceName);
+    if (resource != pImpl->mResources.end())
+    {
+        resource->second->unsubscribe(identifier);
+    }
+}
+
+/// ETag
+std::optional<std::string>
+    Handler::getETag(const std::string &request) const noexcept
+{
+    try
+    {
+        auto object = nlohmann::json::parse(request);
+        if (!object.contains("resource")){return std::nullopt;}
+        auto resourceName = object["resource"].template get<std::string> ();
+        auto resource = pImpl->mResources.find(resourceName);
+        if (resource == pImpl->mResources.end()){return std::nullopt;}
+        return resource->second->getETag(object);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::debug("Could not get ETag; failed with: "
+                    + std::string {e.what()});
+    }
+    return std::nullopt;
+}
+
 /// Processes a message
 std::unique_ptr<MLReview::Messages::IMessage> 
 Handler::process(const std::string &request) const
@@ -143,7 +254,24 @@ Handler::process(const std::string &request) const
         }
         else
         {
-            return resource->second->processRequest(object);
+            // The client can send the ETag of the data it holds so that
+            // unchanged data is not rebuilt or resent
+            auto eTag = resource->second->getETag(object);
+            if (eTag && object.contains("ifNoneMatch") &&
+                object["ifNoneMatch"].is_string() &&
+                object["ifNoneMatch"].template get<std::string> () == *eTag)
+            {
+                return std::make_unique<::NotModifiedMessage> (*eTag);
+            }
+            auto response = resource->second->processRequest(object);
+            // Some resources only know the version once the data is loaded
+            if (!eTag){eTag = resource->second->getETag(object);}
+            if (eTag && response && response->getSuccess())
+            {
+                return std::make_unique<::TaggedMessage>
+                       (std::move(response), *eTag);
+            }
+            return response;
         }
     }
     catch (const std::runtime_error &e)
@@ -35,3 +35,23 @@ std::string IResource::getDocumentation() const noexcept
 {
    return "";
 }
+
+/// ETag
+std::optional<std::string>
+    IResource::getETag(const nlohmann::json &) const
+{
+    return std::nullopt;
+}
+
+/// Subscribes to changes
+int64_t IResource::subscribe(
+    const std::function<void (const std::shared_ptr<const std::string> &)> &)
+{
+    throw std::invalid_argument("Resource " + getName()
+                              + " does not support subscriptions");
+}
+
+/// Unsubscribes
+void IResource::unsubscribe(const int64_t ) noexcept
+{
+}
@@ -1,15 +1,28 @@
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
 #include <cmath>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <array>
+#include <map>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include <nlohmann/json.hpp>
 #include <soci/soci.h>
+#include <GeographicLib/Geodesic.hpp>
 #include "mlReview/service/stations/resource.hpp"
 #include "mlReview/service/stations/response.hpp"
 #include "mlReview/service/stations/station.hpp"
+#include "mlReview/service/geofence.hpp"
+#include "mlReview/waveServer/channelEpochs.hpp"
 #include "mlReview/database/connection/postgresql.hpp"
 #include "mlReview/messages/error.hpp"
+#include "private/spatialIndex.hpp"
 
 #define RESOURCE_NAME "stations"
 
@@ -27,12 +40,16 @@ std::chrono::seconds now()
 
 nlohmann::json toObject(const std::vector<Station> &stations,
                         const bool getLocal = false,
-                        const bool getActive = false)
+                        const bool getActive = false,
+                        const std::vector<size_t> *indices = nullptr)
 {
     auto now = ::now();
     nlohmann::json result;
-    for (const auto &station : stations)
+    auto nStations = indices != nullptr ? indices->size() : stations.size();
+    for (size_t i = 0; i < nStations; ++i)
     {
+        const auto &station
+            = indices != nullptr ? stations.at(indices->at(i)) : stations[i];
         try
         {
             bool keep{true};
@@ -71,6 +88,135 @@ nlohmann::json toObject(const std::vector<Station> &stations,
     return result;
 }
 
+/// The nearest stations to an event
+struct NearestStations
+{
+    /// The stations ordered by distance from the epicenter
+    nlohmann::json stations;
+    double latitude{0};
+    double longitude{0};
+    /// The hash of the station list from which these were found
+    size_t stationsHash{0};
+    std::chrono::seconds accessTime{0};
+};
+
+/// @brief A station list and everything derived from it.  Snapshots are
+///        immutable once built so a request only holds the lock inside the
+///        atomic shared_ptr (it is not lock-free) long enough to take a
+///        reference; it never waits on the next snapshot being built.
+struct Snapshot
+{
+    std::vector<Station> stations;
+    ::SpatialIndex<size_t> spatialIndex;
+    /// The serialized station lists indexed by 2*getLocal + getActive
+    std::array<std::shared_ptr<const std::string>, 4> serializedStations;
+    std::shared_ptr<const MLReview::WaveServer::ChannelEpochs> channelEpochs
+    {
+        std::make_shared<const MLReview::WaveServer::ChannelEpochs> ()
+    };
+    /// The earliest off date after this was built.  At that time a station
+    /// leaves the active lists so they must be rebuilt.
+    std::optional<std::chrono::seconds> nextOffDate;
+    size_t hash{0};
+};
+
+/// Serializes a channel epoch
+nlohmann::json toObject(const MLReview::WaveServer::ChannelEpochs::Epoch &epoch)
+{
+    nlohmann::json result;
+    result["network"] = epoch.network;
+    result["station"] = epoch.station;
+    result["channel"] = epoch.channel;
+    result["locationCode"] = epoch.locationCode;
+    result["samplingRate"] = epoch.samplingRate;
+    result["onDate"]
+        = std::chrono::duration_cast<std::chrono::seconds>
+          (epoch.onDate).count();
+    result["offDate"]
+        = std::chrono::duration_cast<std::chrono::seconds>
+          (epoch.offDate).count();
+    return result;
+}
+
+/// Indexes and serializes the stations
+std::shared_ptr<const Snapshot>
+    createSnapshot(std::vector<Station> &&stations,
+                   std::vector<MLReview::WaveServer::ChannelEpochs::Epoch> &&epochs)
+{
+    auto snapshot = std::make_shared<Snapshot> ();
+    snapshot->stations = std::move(stations);
+    // Channel changes should also produce a new snapshot
+    std::string channelsKey;
+    for (const auto &epoch : epochs)
+    {
+        channelsKey += epoch.network + "." + epoch.station
+                     + "." + epoch.channel + "." + epoch.locationCode
+                     + ":" + std::to_string(epoch.samplingRate)
+                     + ":" + std::to_string(epoch.onDate.count())
+                     + ":" + std::to_string(epoch.offDate.count()) + "\n";
+    }
+    try
+    {
+        snapshot->channelEpochs
+            = std::make_shared<const MLReview::WaveServer::ChannelEpochs>
+              (std::move(epochs));
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::warn("Failed to create channel epochs; failed with: "
+                   + std::string {e.what()});
+    }
+    for (size_t i = 0; i < snapshot->stations.size(); ++i)
+    {
+        try
+        {
+            snapshot->spatialIndex.insert(i,
+                                          snapshot->stations[i].getLatitude(),
+                                          snapshot->stations[i].getLongitude());
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Station not indexed because "
+                       + std::string {e.what()});
+        }
+    }
+    for (const bool getLocal : {false, true})
+    {
+        for (const bool getActive : {false, true})
+        {
+            auto index = 2*static_cast<int> (getLocal)
+                       + static_cast<int> (getActive);
+            snapshot->serializedStations[index]
+                = std::make_shared<const std::string>
+                  (::toObject(snapshot->stations, getLocal, getActive).dump());
+        }
+    }
+    auto now = ::now();
+    for (const auto &station : snapshot->stations)
+    {
+        try
+        {
+            auto offDate = station.getOffDate();
+            if (offDate >= now &&
+                (!snapshot->nextOffDate || offDate < *snapshot->nextOffDate))
+            {
+                snapshot->nextOffDate = offDate;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            // Stations without on/off dates are never retired
+        }
+    }
+    // The active list changes as stations are retired even when the
+    // station list itself does not
+    snapshot->hash
+        = std::hash<std::string> {}(*snapshot->serializedStations[0])
+        ^ (std::hash<std::string> {}(*snapshot->serializedStations[1]) << 1)
+        ^ (std::hash<std::string> {}(channelsKey) << 2);
+    return snapshot;
+}
+
 /// Generates a catalog from the application database
 std::vector<Station>
 getStations(MLReview::Database::Connection::PostgreSQL &connection)
@@ -87,7 +233,7 @@ getStations(MLReview::Database::Connection::PostgreSQL &connection)
     }
     auto session
         = reinterpret_cast<soci::session *> (connection.getSession());
-    std::string query{"SELECT net, sta, staname, lat, lon, elev, EXTRACT(epoch FROM ondate) AS ondate, EXTRACT(epoch FROM offdate) AS offdate FROM station_data"};
+    std::string query{"SELECT net, sta, staname, lat, lon, elev, EXTRACT(epoch FROM ondate) AS ondate, EXTRACT(epoch FROM offdate) AS offdate FROM station_data ORDER BY net, sta, ondate"};
     soci::rowset<soci::row> stationRows = (session->prepare << query);
     for (soci::rowset<soci::row>::const_iterator it = stationRows.begin();
          it != stationRows.end(); ++it)
@@ -120,6 +266,63 @@ getStations(MLReview::Database::Connection::PostgreSQL &connection)
     return stations;
 }
 
+/// Loads the channel epochs from the AQMS database
+std::vector<MLReview::WaveServer::ChannelEpochs::Epoch>
+getChannelEpochs(MLReview::Database::Connection::PostgreSQL &connection)
+{
+    std::vector<MLReview::WaveServer::ChannelEpochs::Epoch> epochs;
+    if (!connection.isConnected())
+    {
+        connection.connect();
+        if (!connection.isConnected())
+        {
+            spdlog::critical("Could not connect to AQMS database");
+            return epochs;
+        }
+    }
+    auto session
+        = reinterpret_cast<soci::session *> (connection.getSession());
+    std::string query{"SELECT net, sta, seedchan, location, samprate, EXTRACT(epoch FROM ondate) AS ondate, EXTRACT(epoch FROM offdate) AS offdate FROM channel_data ORDER BY net, sta, seedchan, location, ondate"};
+    soci::rowset<soci::row> channelRows = (session->prepare << query);
+    for (soci::rowset<soci::row>::const_iterator it = channelRows.begin();
+         it != channelRows.end(); ++it)
+    {
+        MLReview::WaveServer::ChannelEpochs::Epoch epoch;
+        const auto &row = *it;
+        try
+        {
+            epoch.network = row.get<std::string> (0);
+            epoch.station = row.get<std::string> (1);
+            epoch.channel = row.get<std::string> (2);
+            epoch.locationCode = row.get<std::string> (3, "");
+            epoch.samplingRate = row.get<double> (4, 0);
+            auto onDate = row.get<double> (5);
+            auto offDate = row.get<double> (6);
+            epoch.onDate
+                = std::chrono::microseconds
+                  {static_cast<int64_t> (std::round(onDate*1.e6))};
+            epoch.offDate
+                = std::chrono::microseconds
+                  {static_cast<int64_t> (std::round(offDate*1.e6))};
+            if (epoch.network.empty() || epoch.station.empty() ||
+                epoch.channel.empty() || epoch.offDate < epoch.onDate)
+            {
+                spdlog::warn("Skipping invalid channel epoch for "
+                           + epoch.network + "." + epoch.station + "."
+                           + epoch.channel);
+                continue;
+            }
+            epochs.push_back(std::move(epoch));
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to create channel epoch because: "
+                       + std::string{e.what()});
+        }
+    }
+    return epochs;
+}
+
 }
 
 class Resource::ResourceImpl
@@ -129,16 +332,274 @@ public:
         std::shared_ptr<MLReview::Database::Connection::PostgreSQL> &aqmsConnection) :
         mAQMSConnection(aqmsConnection)
     {
-        mStations = getStations(*mAQMSConnection);
+        refreshStations();
+        start();
     }
-    ~ResourceImpl()
+    /// Reloads the stations and, if they changed, publishes a new snapshot.
+    /// On failure the previous snapshot is retained.
+    void refreshStations()
+    {
+        auto stations = getStations(*mAQMSConnection);
+        auto current = mSnapshot.load();
+        if (stations.empty() && !current->stations.empty())
+        {
+            spdlog::warn("No stations loaded; retaining previous station list");
+            return;
+        }
+        std::vector<MLReview::WaveServer::ChannelEpochs::Epoch> epochs;
+        try
+        {
+            epochs = ::getChannelEpochs(*mAQMSConnection);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to load channel epochs; failed with: "
+                       + std::string {e.what()});
+        }
+        if (epochs.empty() && current->channelEpochs->size() > 0)
+        {
+            spdlog::warn("No channel epochs loaded; retaining previous station list");
+            return;
+        }
+        auto snapshot = ::createSnapshot(std::move(stations),
+                                         std::move(epochs));
+        if (snapshot->hash == current->hash)
+        {
+            spdlog::debug("Station list unchanged");
+            return;
+        }
+        auto nStations = snapshot->stations.size();
+        auto nEpochs = snapshot->channelEpochs->size();
+        mSnapshot.store(std::move(snapshot));
+        spdlog::info("Loaded " + std::to_string(nStations) + " stations and "
+                   + std::to_string(nEpochs) + " channel epochs");
+    }
+    /// The time until the next refresh.  This is the refresh interval
+    /// unless a station retires sooner in which case the active lists are
+    /// rebuilt just after its off date.
+    [[nodiscard]] std::chrono::seconds getRefreshTimeout() const
+    {
+        auto timeout = mRefreshInterval;
+        auto nextOffDate = mSnapshot.load()->nextOffDate;
+        auto now = ::now();
+        if (nextOffDate && *nextOffDate >= now)
+        {
+            timeout = std::min(timeout,
+                               *nextOffDate - now + std::chrono::seconds {1});
+        }
+        return timeout;
+    }
+    /// Periodically refreshes the stations
+    void refreshStationsLoop()
+    {
+        spdlog::debug("Beginning station refresh...");
+        while (true)
+        {
+            auto timeout = getRefreshTimeout();
+            {
+            std::unique_lock<std::mutex> lock(mRefreshMutex);
+            mRefreshConditionVariable.wait_for(lock,
+                                               timeout,
+                                               [this]
+                                               {
+                                                   return !mKeepRunning;
+                                               });
+            if (!mKeepRunning){break;}
+            }
+            try
+            {
+                refreshStations();
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to refresh stations: "
+                           + std::string {e.what()});
+            }
+        }
+        spdlog::debug("Ending station refresh");
+    }
+    void start()
+    {
+        stop();
+        mKeepRunning = true;
+        mQueryThread = std::thread(&ResourceImpl::refreshStationsLoop, this);
+    }
+    void stop()
     {
+        {
+        std::lock_guard<std::mutex> lock(mRefreshMutex);
+        mKeepRunning = false;
+        }
+        mRefreshConditionVariable.notify_all();
         if (mQueryThread.joinable()){mQueryThread.join();}
     }
+    ~ResourceImpl()
+    {
+        stop();
+    }
+    /// The count active stations closest to the point ordered by distance.
+    /// Candidates are gathered from the spatial index in circles of
+    /// doubling radius until there are enough of them; only the candidates
+    /// are measured on the ellipsoid.
+    [[nodiscard]] static nlohmann::json
+        findNearest(const ::Snapshot &snapshot,
+                    const double latitude,
+                    const double longitude,
+                    const size_t count,
+                    const bool getLocal)
+    {
+        const auto &stations = snapshot.stations;
+        // Great-circle distances are within a fraction of a percent of the
+        // geodesic distances so only trust candidates well inside the circle
+        constexpr double tolerance{0.99};
+        constexpr double maximumRadius{20040};
+        auto now = ::now();
+        ::SpatialFilter filter;
+        filter.circle = ::Circle {latitude, longitude, 50};
+        std::vector<size_t> candidates;
+        while (true)
+        {
+            candidates.clear();
+            size_t nInside{0};
+            for (const auto &index : snapshot.spatialIndex.query(filter,
+                                                                 nullptr))
+            {
+                const auto &station = stations[index];
+                if (station.getOffDate() < now){continue;}
+                if (getLocal && !station.isLocal()){continue;}
+                candidates.push_back(index);
+                auto distance
+                    = ::greatCircleDistance(latitude, longitude,
+                                            station.getLatitude(),
+                                            station.getLongitude());
+                if (distance <= tolerance*filter.circle->radius)
+                {
+                    nInside = nInside + 1;
+                }
+            }
+            if (nInside >= count || filter.circle->radius >= maximumRadius)
+            {
+                break;
+            }
+            filter.circle->radius
+                = std::min(2*filter.circle->radius, maximumRadius);
+        }
+        struct Measured
+        {
+            double distance;
+            double azimuth;
+            double backAzimuth;
+            size_t index;
+        };
+        const auto &geodesic = GeographicLib::Geodesic::WGS84();
+        std::vector<Measured> measured;
+        measured.reserve(candidates.size());
+        for (const auto &index : candidates)
+        {
+            const auto &station = stations[index];
+            double distance, azimuth, stationAzimuth;
+            geodesic.Inverse(latitude, longitude,
+                             station.getLatitude(), station.getLongitude(),
+                             distance, azimuth, stationAzimuth);
+            // The back azimuth points from the station to the source
+            auto backAzimuth = stationAzimuth + 180;
+            if (backAzimuth >= 360){backAzimuth = backAzimuth - 360;}
+            if (azimuth < 0){azimuth = azimuth + 360;}
+            measured.push_back(Measured {distance/1000, azimuth,
+                                         backAzimuth, index});
+        }
+        auto nStations = std::min(count, measured.size());
+        std::partial_sort(measured.begin(), measured.begin() + nStations,
+                          measured.end(),
+                          [](const Measured &lhs, const Measured &rhs)
+                          {
+                              return lhs.distance < rhs.distance;
+                          });
+        nlohmann::json result = nlohmann::json::array();
+        for (size_t i = 0; i < nStations; ++i)
+        {
+            try
+            {
+                auto object = toObject(stations[measured[i].index]);
+                object["distance"] = measured[i].distance;
+                object["azimuth"] = measured[i].azimuth;
+                object["backAzimuth"] = measured[i].backAzimuth;
+                result.push_back(std::move(object));
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to pack station because "
+                           + std::string {e.what()});
+            }
+        }
+        return result;
+    }
+    /// The nearest stations to an event.  These are cached per event and
+    /// recomputed when the event is relocated or more stations are wanted.
+    [[nodiscard]] nlohmann::json findNearest(const ::Snapshot &snapshot,
+                                             const int64_t identifier,
+                                             const double latitude,
+                                             const double longitude,
+                                             const size_t count,
+                                             const bool getLocal)
+    {
+        std::pair key{identifier, getLocal};
+        {
+        std::lock_guard<std::mutex> lockGuard(mNearestCacheMutex);
+        auto it = mNearestCache.find(key);
+        if (it != mNearestCache.end() &&
+            it->second.stationsHash == snapshot.hash &&
+            it->second.latitude == latitude &&
+            it->second.longitude == longitude &&
+            it->second.stations.size() >= count)
+        {
+            it->second.accessTime = ::now();
+            nlohmann::json result = nlohmann::json::array();
+            for (size_t i = 0; i < count; ++i)
+            {
+                result.push_back(it->second.stations[i]);
+            }
+            return result;
+        }
+        }
+        auto stations = findNearest(snapshot, latitude, longitude,
+                                    count, getLocal);
+        std::lock_guard<std::mutex> lockGuard(mNearestCacheMutex);
+        if (!mNearestCache.contains(key) &&
+            mNearestCache.size() >= mMaximumNumberOfCachedEvents)
+        {
+            auto oldest
+                = std::min_element(mNearestCache.begin(),
+                                   mNearestCache.end(),
+                                   [](const auto &lhs, const auto &rhs)
+                                   {
+                                       return lhs.second.accessTime
+                                            < rhs.second.accessTime;
+                                   });
+            mNearestCache.erase(oldest);
+        }
+        mNearestCache[key]
+            = ::NearestStations {stations, latitude, longitude,
+                                 snapshot.hash, ::now()};
+        return stations;
+    }
     std::thread mQueryThread;
     std::shared_ptr<MLReview::Database::Connection::PostgreSQL>
         mAQMSConnection{nullptr};
-    std::vector<Station> mStations;
+    std::atomic<std::shared_ptr<const ::Snapshot>>
+        mSnapshot{std::make_shared<const ::Snapshot> ()};
+    mutable std::mutex mRefreshMutex;
+    std::condition_variable mRefreshConditionVariable;
+    std::chrono::seconds mRefreshInterval{3600};
+    bool mKeepRunning{true};
+    std::shared_ptr<const MLReview::Service::Geofence> mGeofence{nullptr};
+    std::function<std::optional<std::pair<double, double>> (int64_t)>
+        mEpicenterCallback;
+    std::mutex mNearestCacheMutex;
+    std::map<std::pair<int64_t, bool>, ::NearestStations> mNearestCache;
+    size_t mMaximumNumberOfCachedEvents{256};
+    size_t mMaximumNumberOfNearestStations{200};
+    size_t mDefaultNumberOfNearestStations{10};
 };
 
 /// Constructor
@@ -157,6 +618,67 @@ std::string Resource::getName() const noexcept
     return RESOURCE_NAME;
 }
 
+/// Geofence
+void Resource::setGeofence(
+    const std::shared_ptr<const MLReview::Service::Geofence> &geofence)
+{
+    pImpl->mGeofence = geofence;
+}
+
+/// Epicenter callback
+void Resource::setEpicenterCallback(
+    const std::function<std::optional<std::pair<double, double>> (int64_t)> &callback)
+{
+    pImpl->mEpicenterCallback = callback;
+}
+
+/// Channel epochs
+std::shared_ptr<const MLReview::WaveServer::ChannelEpochs>
+    Resource::getChannelEpochs() const noexcept
+{
+    return pImpl->mSnapshot.load()->channelEpochs;
+}
+
+/// ETag
+std::optional<std::string>
+    Resource::getETag(const nlohmann::json &request) const
+{
+    auto snapshot = pImpl->mSnapshot.load();
+    if (snapshot->hash == 0){return std::nullopt;}
+    // Events can be relocated
+    if (request.contains("nearest") &&
+        request["nearest"].contains("identifier"))
+    {
+        return std::nullopt;
+    }
+    bool getActive{false};
+    if (request.contains("getActive"))
+    {
+        getActive = request["getActive"].template get<bool> ();
+    }
+    bool getLocal{false};
+    if (request.contains("getLocal"))
+    {
+        getLocal = request["getLocal"].template get<bool> ();
+    }
+    std::string eTag = std::string {RESOURCE_NAME} + "-"
+                     + std::to_string(static_cast<int> (getLocal))
+                     + std::to_string(static_cast<int> (getActive)) + "-"
+                     + std::to_string(snapshot->hash);
+    // Spatially filtered requests are tagged by their filter too
+    nlohmann::json spatialKeys;
+    for (const auto &key : {"bbox", "region", "radius", "nearest", "channels"})
+    {
+        if (request.contains(key)){spatialKeys[key] = request[key];}
+    }
+    if (!spatialKeys.is_null())
+    {
+        eTag = eTag + "-"
+             + std::to_string(std::hash<std::string> {}(spatialKeys.dump()));
+    }
+    return eTag;
+}
+
 /// Process request
 std::unique_ptr<MLReview::Messages::IMessage> 
 Resource::processRequest(const nlohmann::json &request)
@@ -225,8 +747,118 @@ Resource::processRequest(const nlohmann::json &request)
         }
     }
 */
+    if (request.contains("channels"))
+    {
+        const auto &channels = request["channels"];
+        auto network = channels.at("network").template get<std::string> ();
+        auto station = channels.at("station").template get<std::string> ();
+        std::optional<std::chrono::microseconds> time;
+        if (channels.contains("time") && !channels["time"].is_null())
+        {
+            time = std::chrono::microseconds
+                   {static_cast<int64_t>
+                    (std::round(channels["time"].template get<double> ()*1.e6))};
+        }
+        auto snapshot = pImpl->mSnapshot.load();
+        nlohmann::json data = nlohmann::json::array();
+        for (const auto &epoch :
+             snapshot->channelEpochs->getEpochs(network, station, time))
+        {
+            data.push_back(::toObject(epoch));
+        }
+        auto response = std::make_unique<Response> ();
+        response->setMessage("Successful response to channels request");
+        response->setData(std::move(data));
+        return response;
+    }
+    if (request.contains("nearest"))
+    {
+        const auto &nearest = request["nearest"];
+        auto count = pImpl->mDefaultNumberOfNearestStations;
+        if (nearest.contains("count"))
+        {
+            auto requestCount = nearest["count"].template get<int> ();
+            if (requestCount < 1 ||
+                static_cast<size_t> (requestCount)
+                  > pImpl->mMaximumNumberOfNearestStations)
+            {
+                throw std::invalid_argument(
+                    "Number of nearest stations must be in range [1,"
+                  + std::to_string(pImpl->mMaximumNumberOfNearestStations)
+                  + "]");
+            }
+            count = static_cast<size_t> (requestCount);
+        }
+        std::optional<int64_t> identifier;
+        std::optional<std::pair<double, double>> epicenter;
+        if (nearest.contains("identifier"))
+        {
+            identifier = nearest["identifier"].template get<int64_t> ();
+            if (pImpl->mEpicenterCallback)
+            {
+                epicenter = pImpl->mEpicenterCallback(*identifier);
+            }
+        }
+        if (!epicenter &&
+            nearest.contains("latitude") && nearest.contains("longitude"))
+        {
+            epicenter
+                = std::pair {nearest["latitude"].template get<double> (),
+                             nearest["longitude"].template get<double> ()};
+        }
+        if (!epicenter)
+        {
+            if (identifier)
+            {
+                throw std::invalid_argument("Event "
+                                          + std::to_string(*identifier)
+                                          + " is not in the catalog");
+            }
+            throw std::invalid_argument(
+                "Nearest stations requires an identifier or a latitude and longitude");
+        }
+        auto [latitude, longitude] = *epicenter;
+        if (latitude < -90 || latitude > 90)
+        {
+            throw std::invalid_argument(
+                "Latitude must in be in range [-90,90]");
+        }
+        auto snapshot = pImpl->mSnapshot.load();
+        auto response = std::make_unique<Response> ();
+        response->setMessage("Successful response to nearest stations request");
+        if (identifier)
+        {
+            response->setData(pImpl->findNearest(*snapshot, *identifier,
+                                                 latitude, longitude,
+                                                 count, getLocal));
+        }
+        else
+        {
+            response->setData(pImpl->findNearest(*snapshot,
+                                                 latitude, longitude,
+                                                 count, getLocal));
+        }
+        return response;
+    }
+    auto spatialFilter
+        = ::parseSpatialFilter(request, pImpl->mGeofence.get());
+    auto snapshot = pImpl->mSnapshot.load();
     auto response = std::make_unique<Response> ();
     response->setMessage("Successful response to station list request");
-    response->setData(::toObject(pImpl->mStations, getLocal, getActive));
+    if (spatialFilter)
+    {
+        auto indices = snapshot->spatialIndex.query(*spatialFilter,
+                                                    pImpl->mGeofence.get());
+        std::sort(indices.begin(), indices.end());
+        response->setData(::toObject(snapshot->stations, getLocal, getActive,
+                                     &indices));
+    }
+    else
+    {
+        // The unfiltered lists are serialized once per station refresh
+        auto index = 2*static_cast<int> (getLocal)
+                   + static_cast<int> (getActive);
+        response->setSerializedData(snapshot->serializedStations[index]);
+    }
     return response;
 }
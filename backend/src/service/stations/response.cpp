@@ -1,4 +1,6 @@
 #include <string>
+#include <memory>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "mlReview/service/stations/response.hpp"
 
@@ -8,6 +10,7 @@ class Response::ResponseImpl
 {
 public:
     nlohmann::json mData;
+    std::shared_ptr<const std::string> mSerializedData{nullptr};
     std::string mMessage;
 };
 
@@ -42,6 +45,29 @@ void Response::setData(const nlohmann::json &data) noexcept
 void Response::setData(nlohmann::json &&data) noexcept
 {
     pImpl->mData = std::move(data); 
+    pImpl->mSerializedData = nullptr;
+}
+
+void Response::setSerializedData(
+    const std::shared_ptr<const std::string> &data) noexcept
+{
+    pImpl->mSerializedData = data;
+    pImpl->mData = nlohmann::json {};
+}
+
+/// Get the serialized data
+std::function<std::optional<std::string> ()>
+    Response::getDataStream() const noexcept
+{
+    if (!pImpl->mSerializedData){return nullptr;}
+    auto data = pImpl->mSerializedData;
+    auto done = std::make_shared<bool> (false);
+    return [data, done]() -> std::optional<std::string>
+           {
+               if (*done){return std::nullopt;}
+               *done = true;
+               return *data;
+           };
 }
 
 /// Get the data
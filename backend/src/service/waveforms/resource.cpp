@@ -1,5 +1,12 @@
 #include <string>
+#include <vector>
+#include <deque>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <cmath>
 #include <chrono>
 #include <thread>
@@ -34,6 +41,11 @@ struct SavedWaveforms
     //std::vector<MLReview::WaveServer::Waveform> waveforms;
     nlohmann::json jsonWaveforms;
     std::chrono::seconds lastUpdate{::now()};
+    /// Identifies the content for conditional requests
+    size_t hash{0};
+    /// True indicates the waveforms were loaded by a prefetcher and have
+    /// not yet been confirmed by a reviewer's request
+    bool prefetched{false};
 };
 
 std::optional<int64_t> getOldestEvent(
@@ -65,6 +77,97 @@ void purgeOldestEventFromMap(std::map<int64_t, ::SavedWaveforms> &map)
     }
 }
 
+/// @brief A bounded queue of events whose waveforms should be loaded before
+///        anyone asks for them.  When full, the oldest events are dropped
+///        since the newest events are the most likely to be reviewed next.
+class PrefetchQueue
+{
+public:
+    explicit PrefetchQueue(const size_t capacity) :
+        mCapacity(capacity)
+    {
+    }
+    void push(const std::vector<int64_t> &identifiers)
+    {
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mClosed){return;}
+        for (const auto &identifier : identifiers)
+        {
+            if (std::find(mIdentifiers.begin(), mIdentifiers.end(),
+                          identifier) != mIdentifiers.end())
+            {
+                continue;
+            }
+            mIdentifiers.push_back(identifier);
+            if (mIdentifiers.size() > mCapacity){mIdentifiers.pop_front();}
+        }
+        }
+        mConditionVariable.notify_all();
+    }
+    /// Blocks until an event is available.  If the queue is closed then
+    /// nothing is returned.
+    [[nodiscard]] std::optional<int64_t> pop()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConditionVariable.wait(lock,
+                                [this]
+                                {
+                                    return mClosed || !mIdentifiers.empty();
+                                });
+        if (mClosed){return std::nullopt;}
+        auto identifier = mIdentifiers.front();
+        mIdentifiers.pop_front();
+        return std::optional<int64_t> (identifier);
+    }
+    /// Waits for the given time.  False indicates the queue was closed.
+    [[nodiscard]] bool wait(const std::chrono::milliseconds &duration)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConditionVariable.wait_for(lock, duration,
+                                    [this]
+                                    {
+                                        return mClosed;
+                                    });
+        return !mClosed;
+    }
+    void close()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mClosed = true;
+        mIdentifiers.clear();
+        }
+        mConditionVariable.notify_all();
+    }
+private:
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::deque<int64_t> mIdentifiers;
+    size_t mCapacity{16};
+    bool mClosed{false};
+};
+
+/// @brief Counts a reviewer's request for as long as it is in scope so that
+///        the prefetchers know to stay out of the way.
+class ForegroundRequest
+{
+public:
+    explicit ForegroundRequest(std::atomic<int> &counter) :
+        mCounter(counter)
+    {
+        mCounter.fetch_add(1);
+    }
+    ~ForegroundRequest()
+    {
+        mCounter.fetch_sub(1);
+    }
+    ForegroundRequest(const ForegroundRequest &) = delete;
+    ForegroundRequest& operator=(const ForegroundRequest &) = delete;
+private:
+    std::atomic<int> &mCounter;
+};
+
 nlohmann::json toObject(const std::vector<MLReview::WaveServer::Waveform> &waveforms)
 {
     nlohmann::json result;
@@ -91,8 +194,9 @@ getWaveforms(MLReview::Database::Connection::MongoDB &connection,
     std::vector<MLReview::WaveServer::Waveform> waveforms;
     auto databaseName = connection.getDatabaseName();
     using namespace bsoncxx::builder::basic;
+    auto lease = connection.acquire();
     auto client
-        = reinterpret_cast<mongocxx::client *> (connection.getSession());
+        = reinterpret_cast<mongocxx::client *> (lease.getSession());
     auto database = client->database(databaseName);
     if (database)
     {   
@@ -233,13 +337,62 @@ public:
         //getWaveforms(*mMongoDBConnection, 11861);
         //mEvents = getEvents(*mMongoDBConnection);
         //mEventsJSON = ::toObject(mEvents);
+        start();
     }
     ~ResourceImpl()
     {
         stop();
     }
+    /// Loads queued events' waveforms into the cache.  Prefetching is
+    /// opportunistic so it backs off while reviewers' requests are running.
+    void prefetch()
+    {
+        constexpr std::chrono::milliseconds minimumBackOff{250};
+        constexpr std::chrono::milliseconds maximumBackOff{8000};
+        while (true)
+        {
+            auto identifier = mPrefetchQueue->pop();
+            if (!identifier){break;}
+            if (contains(*identifier)){continue;}
+            auto backOff = minimumBackOff;
+            while (mForegroundRequests > 0)
+            {
+                if (!mPrefetchQueue->wait(backOff)){return;}
+                backOff = std::min(2*backOff, maximumBackOff);
+            }
+            try
+            {
+                static_cast<void> (queryAndUpdateWaveforms(*identifier, true));
+                spdlog::debug("Prefetched waveforms for event "
+                            + std::to_string(*identifier));
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to prefetch waveforms for event "
+                           + std::to_string(*identifier) + "; failed with: "
+                           + std::string {e.what()});
+            }
+        }
+    }
+    void start()
+    {
+        stop();
+        // Prefetching must never push out more than half the cache
+        mPrefetchQueue
+            = std::make_shared<::PrefetchQueue> (mMaxNumberOfEvents/2);
+        for (int i = 0; i < mMaximumNumberOfPrefetches; ++i)
+        {
+            mPrefetchThreads.emplace_back(&ResourceImpl::prefetch, this);
+        }
+    }
     void stop()
     {
+        if (mPrefetchQueue){mPrefetchQueue->close();}
+        for (auto &thread : mPrefetchThreads)
+        {
+            if (thread.joinable()){thread.join();}
+        }
+        mPrefetchThreads.clear();
         if (mQueryThread.joinable()){mQueryThread.join();}
     }
     void cleanMap( )
@@ -251,19 +404,44 @@ public:
         std::lock_guard<std::mutex> lockGuard(mMutex);
         return mSavedWaveformsMap.contains(identifier);
     }
+    /// Prefetched waveforms may have been loaded before the event's
+    /// waveforms were completely written so they expire quickly
+    [[nodiscard]] bool isExpired(const ::SavedWaveforms &savedWaveforms) const
+    {
+        return savedWaveforms.prefetched &&
+               ::now() > savedWaveforms.lastUpdate + mPrefetchTimeToLive;
+    }
+    /// The content hash of the saved waveforms or nothing if the event's
+    /// waveforms have not been loaded
+    [[nodiscard]] std::optional<size_t> getHash(const int64_t identifier) const
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        auto it = mSavedWaveformsMap.find(identifier);
+        if (it == mSavedWaveformsMap.end() || it->second.hash == 0 ||
+            isExpired(it->second))
+        {
+            return std::nullopt;
+        }
+        return std::optional<size_t> (it->second.hash);
+    }
+    /// Returns the saved waveforms or queries and saves them.  Events
+    /// without waveforms are not saved since their waveforms may not have
+    /// been written yet.  Prefetched waveforms are served until they
+    /// expire after which the next request refetches and keeps them.
     [[nodiscard]] nlohmann::json //std::vector<MLReview::WaveServer::Waveform>
-        queryAndUpdateWaveforms(const int64_t identifier)
+        queryAndUpdateWaveforms(const int64_t identifier,
+                                const bool isPrefetch = false)
     {
         std::vector<MLReview::WaveServer::Waveform> waveforms;
         nlohmann::json jsonWaveforms;
-        if (contains(identifier))
         {
-            {
-            std::lock_guard<std::mutex> lockGuard(mMutex);
-            jsonWaveforms = mSavedWaveformsMap[identifier].jsonWaveforms;
-            }
-            return jsonWaveforms;
-        } 
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        auto it = mSavedWaveformsMap.find(identifier);
+        if (it != mSavedWaveformsMap.end() && !isExpired(it->second))
+        {
+            return it->second.jsonWaveforms;
+        }
+        }
         // Update
         try
         {
@@ -286,7 +464,24 @@ public:
                                    + std::to_string (identifier));
         }
 
-        ::SavedWaveforms savedWaveforms{jsonWaveforms, now()};
+        if (waveforms.empty())
+        {
+            spdlog::debug("Not saving empty waveforms for event "
+                        + std::to_string(identifier));
+            return jsonWaveforms;
+        }
+        size_t hash{0};
+        try
+        {
+            hash = std::hash<nlohmann::json> {}(jsonWaveforms);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to hash waveforms; failed with: "
+                       + std::string {e.what()});
+        }
+        ::SavedWaveforms savedWaveforms{jsonWaveforms, now(), hash,
+                                        isPrefetch};
         {
         std::lock_guard<std::mutex> lockGuard(mMutex);
         auto insertLocation = mSavedWaveformsMap.find(identifier);
@@ -318,11 +513,16 @@ public:
 //private:
     mutable std::mutex mMutex;
     std::thread mQueryThread;
+    std::vector<std::thread> mPrefetchThreads;
+    std::shared_ptr<::PrefetchQueue> mPrefetchQueue{nullptr};
     std::map<int64_t, ::SavedWaveforms> mSavedWaveformsMap;
     std::shared_ptr<MLReview::Database::Connection::MongoDB>
         mMongoDBConnection{nullptr};
     std::string mCollectionName{COLLECTION_NAME};
     size_t mMaxNumberOfEvents{32};
+    std::chrono::seconds mPrefetchTimeToLive{60};
+    std::atomic<int> mForegroundRequests{0};
+    int mMaximumNumberOfPrefetches{2};
 };
 
 /// Constructor
@@ -341,6 +541,36 @@ std::string Resource::getName() const noexcept
     return RESOURCE_NAME;
 }
 
+/// Prefetch
+void Resource::prefetch(const std::vector<int64_t> &identifiers)
+{
+    pImpl->mPrefetchQueue->push(identifiers);
+}
+
+/// Prefetch callback
+std::function<void (const std::vector<int64_t> &)>
+Resource::getPrefetchCallback() const
+{
+    std::weak_ptr<::PrefetchQueue> prefetchQueue = pImpl->mPrefetchQueue;
+    return [prefetchQueue](const std::vector<int64_t> &identifiers)
+           {
+               auto queue = prefetchQueue.lock();
+               if (queue){queue->push(identifiers);}
+           };
+}
+
+/// ETag
+std::optional<std::string>
+    Resource::getETag(const nlohmann::json &request) const
+{
+    if (!request.contains("identifier")){return std::nullopt;}
+    auto identifier = request["identifier"].template get<int64_t> ();
+    auto hash = pImpl->getHash(identifier);
+    if (!hash){return std::nullopt;}
+    return std::string {RESOURCE_NAME} + "-" + std::to_string(identifier)
+         + "-" + std::to_string(*hash);
+}
+
 /// Process request
 std::unique_ptr<MLReview::Messages::IMessage> 
 Resource::processRequest(const nlohmann::json &request)
@@ -354,6 +584,7 @@ Resource::processRequest(const nlohmann::json &request)
         throw std::invalid_argument("Event identifier not set");
     }
     identifier = request["identifier"].template get<int64_t> ();
+    ::ForegroundRequest foregroundRequest{pImpl->mForegroundRequests};
     //auto waveforms = pImpl->queryAndUpdateWaveforms(identifier); // Throws //::getWaveforms(*pImpl->mMongoDBConnection, identifier);
     auto jsonWaveforms = pImpl->queryAndUpdateWaveforms(identifier); 
     auto response = std::make_unique<Response> ();
@@ -0,0 +1,765 @@
+#include <string>
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <type_traits>
+#include <fstream>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libmseed.h>
+#include <spdlog/spdlog.h>
+#include "mlReview/waveServer/archive.hpp"
+#include "mlReview/waveServer/request.hpp"
+#include "mlReview/waveServer/waveform.hpp"
+#include "mlReview/waveServer/segment.hpp"
+#include "unpackMiniSEED3.hpp"
+#include "completeness.hpp"
+
+#define TYPE "Archive"
+
+using namespace MLReview::WaveServer;
+
+namespace
+{
+
+/// Identifies a version 3 sidecar index
+constexpr std::array<char, 8> INDEX_MAGIC{'M', 'L', 'R', 'I', 'D', 'X', '0', '3'};
+/// The number of bytes at the end of the indexed prefix that are hashed
+/// to detect a day-file that was rewritten in place
+constexpr uint64_t FINGERPRINT_LENGTH{4096};
+
+/// The location of a record in a day-file.  Times are in microseconds.
+struct IndexEntry
+{
+    int64_t startTime{0};
+    int64_t endTime{0};
+    uint64_t offset{0};
+    uint32_t length{0};
+    uint32_t reserved{0};
+};
+
+/// The sidecar's header.  This is followed by nEntries IndexEntry's.
+/// The indexed size ends at the last complete record whereas the scanned
+/// size also covers a trailing record that was still being written.
+/// The device, inode, and modification time identify the indexed
+/// day-file and the fingerprint is a hash of the end of the indexed prefix.
+struct IndexHeader
+{
+    std::array<char, 8> magic{INDEX_MAGIC};
+    uint64_t indexedSize{0};
+    uint64_t scannedSize{0};
+    uint64_t nEntries{0};
+    uint64_t device{0};
+    uint64_t inode{0};
+    int64_t modificationTime{0};
+    uint64_t fingerprint{0};
+};
+
+/// FNV-1a hash
+uint64_t hash(const char *data, const uint64_t length) noexcept
+{
+    uint64_t result{14695981039346656037ULL};
+    for (uint64_t i = 0; i < length; ++i)
+    {
+        result = result^static_cast<unsigned char> (data[i]);
+        result = result*1099511628211ULL;
+    }
+    return result;
+}
+
+/// @brief A read-only memory map of a file.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path &path)
+    {
+        mDescriptor = ::open(path.c_str(), O_RDONLY);
+        if (mDescriptor < 0)
+        {
+            throw std::runtime_error("Could not open " + path.string());
+        }
+        struct stat status;
+        if (::fstat(mDescriptor, &status) != 0)
+        {
+            ::close(mDescriptor);
+            throw std::runtime_error("Could not stat " + path.string());
+        }
+        mSize = static_cast<size_t> (status.st_size);
+        mDevice = static_cast<uint64_t> (status.st_dev);
+        mInode = static_cast<uint64_t> (status.st_ino);
+        mModificationTime
+            = static_cast<int64_t> (status.st_mtim.tv_sec)*1000000000
+            + static_cast<int64_t> (status.st_mtim.tv_nsec);
+        if (mSize > 0)
+        {
+            auto data = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE,
+                               mDescriptor, 0);
+            if (data == MAP_FAILED)
+            {
+                ::close(mDescriptor);
+                throw std::runtime_error("Could not map " + path.string());
+            }
+            mData = static_cast<const char *> (data);
+        }
+    }
+    ~MappedFile()
+    {
+        if (mData){::munmap(const_cast<char *> (mData), mSize);}
+        if (mDescriptor >= 0){::close(mDescriptor);}
+    }
+    [[nodiscard]] const char *data() const noexcept{return mData;}
+    [[nodiscard]] size_t size() const noexcept{return mSize;}
+    [[nodiscard]] uint64_t device() const noexcept{return mDevice;}
+    [[nodiscard]] uint64_t inode() const noexcept{return mInode;}
+    /// @result The modification time in nanoseconds since the epoch.
+    [[nodiscard]] int64_t modificationTime() const noexcept
+    {
+        return mModificationTime;
+    }
+    /// @result True indicates both maps are of the same file though its
+    ///         contents may since have been appended to or rewritten.
+    [[nodiscard]] bool isSameFile(const MappedFile &file) const noexcept
+    {
+        return mDevice == file.mDevice && mInode == file.mInode;
+    }
+    /// @result A hash of the bytes preceding the given offset.
+    [[nodiscard]] uint64_t fingerprint(const uint64_t offset) const noexcept
+    {
+        if (offset > mSize){return 0;}
+        auto length = std::min(offset, FINGERPRINT_LENGTH);
+        return ::hash(mData + (offset - length), length);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+private:
+    const char *mData{nullptr};
+    size_t mSize{0};
+    uint64_t mDevice{0};
+    uint64_t mInode{0};
+    int64_t mModificationTime{0};
+    int mDescriptor{-1};
+};
+
+/// @brief A mapped day-file and its record index sorted by start time.
+class DayFile
+{
+public:
+    /// Maps the file and obtains its index.  If the previous version of
+    /// this file or the sidecar already indexes a prefix of the file then
+    /// only the appended records are scanned.  A file that was replaced or
+    /// rewritten is reindexed from the start.
+    DayFile(const std::filesystem::path &path,
+            const std::shared_ptr<const DayFile> &previous) :
+        mFile(std::make_shared<MappedFile> (path)),
+        mPath(path)
+    {
+        if (previous && previous->mFile->isSameFile(*mFile) &&
+            previous->mIndexedSize <= mFile->size() &&
+            previous->mFile->fingerprint(previous->mIndexedSize)
+            == mFile->fingerprint(previous->mIndexedSize))
+        {
+            mIndex = previous->mIndex;
+            mIndexedSize = previous->mIndexedSize;
+            mScannedSize = std::min(previous->mScannedSize,
+                                    static_cast<uint64_t> (mFile->size()));
+        }
+        else
+        {
+            loadSidecar();
+        }
+        // Only rescan once the file has grown past what was last looked at
+        if (mScannedSize < mFile->size())
+        {
+            scan();
+            saveSidecar();
+        }
+        for (const auto &entry : mIndex)
+        {
+            mMaximumRecordDuration
+                = std::max(mMaximumRecordDuration,
+                           entry.endTime - entry.startTime);
+        }
+    }
+    /// @result The number of bytes of the file that are indexed.
+    [[nodiscard]] uint64_t getIndexedSize() const noexcept
+    {
+        return mIndexedSize;
+    }
+    /// @result The number of bytes of the file that were scanned.  This
+    ///         includes a trailing record that is not yet complete.
+    [[nodiscard]] uint64_t getScannedSize() const noexcept
+    {
+        return mScannedSize;
+    }
+    /// @result The index entries sorted by start time.
+    [[nodiscard]] const std::vector<IndexEntry> &getIndex() const noexcept
+    {
+        return mIndex;
+    }
+    /// @brief Decodes the records overlapping the window directly from the
+    ///        mapped file into the waveform.
+    void read(const int64_t startTime, const int64_t endTime,
+              Waveform &waveform, bool &isFirst) const
+    {
+        // A record can begin at most the longest record duration before
+        // the window
+        auto first = std::lower_bound(mIndex.begin(), mIndex.end(),
+                                      startTime - mMaximumRecordDuration,
+                                      [](const IndexEntry &entry,
+                                         const int64_t time)
+                                      {
+                                          return entry.startTime < time;
+                                      });
+        for (auto it = first; it != mIndex.end(); ++it)
+        {
+            if (it->startTime > endTime){break;}
+            if (it->endTime < startTime){continue;}
+            MS3Record *msr{nullptr};
+            auto returnCode = msr3_parse(mFile->data() + it->offset,
+                                         it->length,
+                                         &msr, MSF_UNPACKDATA, 0);
+            if (returnCode == MS_NOERROR && msr)
+            {
+                try
+                {
+                    ::unpackRecord(msr, waveform, isFirst);
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to unpack record in "
+                               + mPath.string() + "; failed with: "
+                               + std::string {e.what()});
+                }
+            }
+            if (msr){msr3_free(&msr);}
+        }
+    }
+private:
+    /// Indexes the records after the indexed prefix
+    void scan()
+    {
+        auto offset = mIndexedSize;
+        auto fileSize = static_cast<uint64_t> (mFile->size());
+        while (fileSize - offset > MINRECLEN)
+        {
+            MS3Record *msr{nullptr};
+            auto returnCode = msr3_parse(mFile->data() + offset,
+                                         fileSize - offset,
+                                         &msr, 0, 0);
+            if (returnCode == MS_NOERROR && msr)
+            {
+                IndexEntry entry;
+                entry.startTime = msr->starttime/1000;
+                entry.endTime = msr3_endtime(msr)/1000;
+                entry.offset = offset;
+                entry.length = static_cast<uint32_t> (msr->reclen);
+                offset = offset + static_cast<uint64_t> (msr->reclen);
+                msr3_free(&msr);
+                mIndex.push_back(entry);
+                continue;
+            }
+            if (msr){msr3_free(&msr);}
+            // Positive values indicate the last record is still being
+            // written; it will be picked up on the next scan
+            if (returnCode < 0)
+            {
+                spdlog::warn("Failed to parse " + mPath.string()
+                           + " at byte " + std::to_string(offset)
+                           + "; remainder will not be indexed");
+                offset = fileSize;
+            }
+            break;
+        }
+        mIndexedSize = offset;
+        mScannedSize = fileSize;
+        std::stable_sort(mIndex.begin(), mIndex.end(),
+                         [](const IndexEntry &lhs, const IndexEntry &rhs)
+                         {
+                             return lhs.startTime < rhs.startTime;
+                         });
+    }
+    [[nodiscard]] std::filesystem::path getSidecarPath() const
+    {
+        auto path = mPath;
+        path += ".idx";
+        return path;
+    }
+    void loadSidecar()
+    {
+        mIndex.clear();
+        mIndexedSize = 0;
+        mScannedSize = 0;
+        auto sidecarPath = getSidecarPath();
+        if (!std::filesystem::exists(sidecarPath)){return;}
+        std::ifstream sidecar(sidecarPath, std::ios::binary);
+        IndexHeader header;
+        sidecar.read(reinterpret_cast<char *> (&header), sizeof(IndexHeader));
+        if (!sidecar || header.magic != INDEX_MAGIC ||
+            header.indexedSize > header.scannedSize ||
+            header.scannedSize > mFile->size() ||
+            header.device != mFile->device() ||
+            header.inode != mFile->inode())
+        {
+            spdlog::debug("Ignoring stale index " + sidecarPath.string());
+            return;
+        }
+        // An unmodified file is trusted outright.  Otherwise, the file must
+        // only have been appended to since it was indexed.
+        if (header.modificationTime != mFile->modificationTime() &&
+            header.fingerprint != mFile->fingerprint(header.indexedSize))
+        {
+            spdlog::debug("Ignoring index of rewritten file "
+                        + sidecarPath.string());
+            return;
+        }
+        std::vector<IndexEntry> index(header.nEntries);
+        sidecar.read(reinterpret_cast<char *> (index.data()),
+                     static_cast<std::streamsize>
+                        (index.size()*sizeof(IndexEntry)));
+        if (!sidecar)
+        {
+            spdlog::debug("Ignoring truncated index " + sidecarPath.string());
+            return;
+        }
+        mIndex = std::move(index);
+        mIndexedSize = header.indexedSize;
+        mScannedSize = header.scannedSize;
+    }
+    /// Writes to a temporary file then renames it so that readers never
+    /// see a partial index.  The temporary file is unique to this process
+    /// and thread so concurrent opens of the day-file do not collide.
+    void saveSidecar() const
+    {
+        auto sidecarPath = getSidecarPath();
+        auto temporaryPath = sidecarPath;
+        temporaryPath += "." + std::to_string(::getpid()) + "."
+                       + std::to_string(std::hash<std::thread::id> {}
+                                           (std::this_thread::get_id()))
+                       + ".tmp";
+        try
+        {
+            {
+            std::ofstream sidecar(temporaryPath,
+                                  std::ios::binary | std::ios::trunc);
+            IndexHeader header;
+            header.indexedSize = mIndexedSize;
+            header.scannedSize = mScannedSize;
+            header.nEntries = mIndex.size();
+            header.device = mFile->device();
+            header.inode = mFile->inode();
+            header.modificationTime = mFile->modificationTime();
+            header.fingerprint = mFile->fingerprint(mIndexedSize);
+            sidecar.write(reinterpret_cast<const char *> (&header),
+                          sizeof(IndexHeader));
+            sidecar.write(reinterpret_cast<const char *> (mIndex.data()),
+                          static_cast<std::streamsize>
+                             (mIndex.size()*sizeof(IndexEntry)));
+            if (!sidecar)
+            {
+                throw std::runtime_error("Write failed");
+            }
+            }
+            std::filesystem::rename(temporaryPath, sidecarPath);
+        }
+        catch (const std::exception &e)
+        {
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            spdlog::warn("Failed to save index " + sidecarPath.string()
+                       + "; failed with: " + std::string {e.what()});
+        }
+    }
+    std::shared_ptr<MappedFile> mFile{nullptr};
+    std::filesystem::path mPath;
+    std::vector<IndexEntry> mIndex;
+    uint64_t mIndexedSize{0};
+    uint64_t mScannedSize{0};
+    int64_t mMaximumRecordDuration{0};
+};
+
+/// Converts a location code to its form in file names and source
+/// identifiers
+std::string toLocationCode(const std::string &locationCode)
+{
+    if (locationCode == "--"){return "";}
+    return locationCode;
+}
+
+/// The day containing the time (microseconds)
+std::chrono::sys_days toDay(const int64_t time)
+{
+    return std::chrono::floor<std::chrono::days>
+           (std::chrono::sys_time<std::chrono::microseconds>
+               {std::chrono::microseconds {time}});
+}
+
+/// The start of the day in microseconds
+int64_t toMicroSeconds(const std::chrono::sys_days &day)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>
+           (day.time_since_epoch()).count();
+}
+
+/// Packed records are appended to the stream
+void writeRecord(char *record, int recordLength, void *handlerData)
+{
+    auto stream = static_cast<std::ofstream *> (handlerData);
+    stream->write(record, recordLength);
+}
+
+/// Packs the samples and appends the records to the file
+template<typename T>
+void pack(const std::filesystem::path &path,
+          const std::string &network,
+          const std::string &station,
+          const std::string &locationCode,
+          const std::string &channel,
+          const int64_t startTime,
+          const double samplingRate,
+          std::vector<T> &&data)
+{
+    if (data.empty()){return;}
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    if (!file)
+    {
+        throw std::runtime_error("Could not open " + path.string());
+    }
+    auto msr = msr3_init(nullptr);
+    if (msr == nullptr){throw std::runtime_error("Could not allocate record");}
+    if (ms_nslc2sid(msr->sid, LM_SIDLEN, 0,
+                    network.c_str(), station.c_str(),
+                    locationCode.c_str(), channel.c_str()) < 0)
+    {
+        msr3_free(&msr);
+        throw std::runtime_error("Could not create source identifier");
+    }
+    msr->formatversion = 2;
+    msr->reclen = 4096;
+    msr->pubversion = 1;
+    msr->starttime = static_cast<nstime_t> (startTime)*1000;
+    msr->samprate = samplingRate;
+    msr->numsamples = static_cast<int64_t> (data.size());
+    msr->samplecnt = msr->numsamples;
+    msr->datasamples = data.data();
+    if constexpr (std::is_same<T, int>::value)
+    {
+        msr->sampletype = 'i';
+        msr->encoding = DE_STEIM2;
+    }
+    else if constexpr (std::is_same<T, float>::value)
+    {
+        msr->sampletype = 'f';
+        msr->encoding = DE_FLOAT32;
+    }
+    else
+    {
+        msr->sampletype = 'd';
+        msr->encoding = DE_FLOAT64;
+    }
+    int64_t nPacked{0};
+    auto nRecords = msr3_pack(msr, &::writeRecord, &file, &nPacked,
+                              MSF_FLUSHDATA, 0);
+    // The samples belong to the caller
+    msr->datasamples = nullptr;
+    msr3_free(&msr);
+    if (nRecords < 0 || nPacked != static_cast<int64_t> (data.size()))
+    {
+        throw std::runtime_error("Failed to pack data for " + path.string());
+    }
+}
+
+}
+
+class Archive::ArchiveImpl
+{
+public:
+    explicit ArchiveImpl(const std::filesystem::path &directory) :
+        mDirectory(directory)
+    {
+    }
+    /// The SDS path of the day-file
+    [[nodiscard]] std::filesystem::path
+        getPath(const std::string &network,
+                const std::string &station,
+                const std::string &locationCode,
+                const std::string &channel,
+                const std::chrono::sys_days &day) const
+    {
+        std::chrono::year_month_day date{day};
+        auto year = static_cast<int> (date.year());
+        auto dayOfYear
+            = (day - std::chrono::sys_days {date.year()/1/1}).count() + 1;
+        std::array<char, 8> dayString;
+        std::snprintf(dayString.data(), dayString.size(), "%03d",
+                      static_cast<int> (dayOfYear));
+        auto yearString = std::to_string(year);
+        auto fileName = network + "." + station + "." + locationCode
+                      + "." + channel + ".D." + yearString
+                      + "." + std::string {dayString.data()};
+        return mDirectory / yearString / network / station
+             / (channel + ".D") / fileName;
+    }
+    /// Gets the mapped and indexed day-file.  Files that have grown since
+    /// they were last opened are re-mapped and their new records indexed.
+    [[nodiscard]] std::shared_ptr<const ::DayFile>
+        getDayFile(const std::filesystem::path &path)
+    {
+        std::error_code error;
+        auto fileSize = std::filesystem::file_size(path, error);
+        if (error){return nullptr;}
+        std::shared_ptr<const ::DayFile> previous{nullptr};
+        {
+        std::lock_guard<std::mutex> lock(mFilesMutex);
+        auto it = mFiles.find(path.string());
+        if (it != mFiles.end())
+        {
+            if (it->second->getScannedSize() == fileSize){return it->second;}
+            previous = it->second;
+        }
+        }
+        auto dayFile = std::make_shared<const ::DayFile> (path, previous);
+        std::lock_guard<std::mutex> lock(mFilesMutex);
+        // Readers hold their own references so dropping the cache is safe
+        if (mFiles.size() >= mMaximumNumberOfOpenFiles){mFiles.clear();}
+        mFiles.insert_or_assign(path.string(), dayFile);
+        return dayFile;
+    }
+    /// Reads the request from the archive
+    [[nodiscard]] Waveform read(const Request &request)
+    {
+        Waveform result;
+        auto network = request.getNetwork();
+        auto station = request.getStation();
+        auto channel = request.getChannel();
+        auto locationCode = request.haveLocationCode() ?
+                            ::toLocationCode(request.getLocationCode()) : "";
+        auto startTime = request.getStartTime().count();
+        auto endTime = request.getEndTime().count();
+        bool isFirst{true};
+        for (auto day = ::toDay(startTime);
+             day <= ::toDay(endTime);
+             day = day + std::chrono::days {1})
+        {
+            auto path = getPath(network, station, locationCode, channel, day);
+            try
+            {
+                auto dayFile = getDayFile(path);
+                if (dayFile){dayFile->read(startTime, endTime, result, isFirst);}
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to read " + path.string()
+                           + "; failed with: " + std::string {e.what()});
+            }
+        }
+        if (result.getNumberOfSegments() > 1){result.mergeSegments();}
+        return result;
+    }
+    /// Appends the samples of the segment that are not already archived.
+    /// The segment is split at day boundaries so that each record lands in
+    /// the right day-file.
+    template<typename T>
+    void write(const std::string &network,
+               const std::string &station,
+               const std::string &locationCode,
+               const std::string &channel,
+               const Segment &segment)
+    {
+        auto data = segment.getData<T> ();
+        auto samplingRate = segment.getSamplingRate();
+        auto samplingPeriod = 1.e6/samplingRate;
+        auto segmentStartTime = segment.getStartTime().count();
+        auto toTime = [&](const size_t i)
+        {
+            return segmentStartTime
+                 + static_cast<int64_t> (std::round(i*samplingPeriod));
+        };
+        size_t i0{0};
+        while (i0 < data.size())
+        {
+            // Samples in this day
+            auto day = ::toDay(toTime(i0));
+            auto nextDay = ::toMicroSeconds(day + std::chrono::days {1});
+            auto i1 = i0;
+            while (i1 < data.size() && toTime(i1) < nextDay){i1 = i1 + 1;}
+            auto path = getPath(network, station, locationCode, channel, day);
+            auto dayFile = getDayFile(path);
+            // Find the runs of samples not covered by an archived record
+            std::vector<IndexEntry> covered;
+            if (dayFile){covered = dayFile->getIndex();}
+            size_t iCovered{0};
+            size_t runStart{i0};
+            auto flush = [&](const size_t runEnd)
+            {
+                if (runEnd <= runStart){return;}
+                std::vector<T> run(data.begin() + runStart,
+                                   data.begin() + runEnd);
+                ::pack(path, network, station, locationCode, channel,
+                       toTime(runStart), samplingRate, std::move(run));
+            };
+            for (auto i = i0; i < i1; ++i)
+            {
+                auto time = toTime(i);
+                while (iCovered < covered.size() &&
+                       covered[iCovered].endTime < time)
+                {
+                    iCovered = iCovered + 1;
+                }
+                bool isCovered = iCovered < covered.size() &&
+                                 covered[iCovered].startTime <= time;
+                if (isCovered)
+                {
+                    flush(i);
+                    runStart = i + 1;
+                }
+            }
+            flush(i1);
+            i0 = i1;
+        }
+    }
+    /// Appends the waveform's segments
+    void write(const Waveform &waveform)
+    {
+        auto network = waveform.getNetwork();
+        auto station = waveform.getStation();
+        auto channel = waveform.getChannel();
+        auto locationCode = waveform.haveLocationCode() ?
+                            ::toLocationCode(waveform.getLocationCode()) : "";
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        for (const auto &segment : waveform)
+        {
+            auto dataType = segment.getDataType();
+            if (dataType == Segment::DataType::Integer32)
+            {
+                write<int> (network, station, locationCode, channel,
+                            segment);
+            }
+            else if (dataType == Segment::DataType::Float)
+            {
+                write<float> (network, station, locationCode, channel,
+                              segment);
+            }
+            else if (dataType == Segment::DataType::Double)
+            {
+                write<double> (network, station, locationCode, channel,
+                               segment);
+            }
+            else
+            {
+                // miniSEED has no 64-bit integer encoding
+                spdlog::warn("Unhandled data type; not archiving segment");
+            }
+        }
+    }
+    std::filesystem::path mDirectory;
+    std::unique_ptr<IClient> mWriteThroughClient{nullptr};
+    std::mutex mFilesMutex;
+    std::mutex mWriteMutex;
+    std::unordered_map<std::string, std::shared_ptr<const ::DayFile>> mFiles;
+    size_t mMaximumNumberOfOpenFiles{512};
+    double mCompleteTolerance{99};
+};
+
+/// Constructor
+Archive::Archive(const std::filesystem::path &directory) :
+    pImpl(std::make_unique<ArchiveImpl> (directory))
+{
+    if (std::filesystem::exists(directory))
+    {
+        if (!std::filesystem::is_directory(directory))
+        {
+            throw std::invalid_argument(directory.string()
+                                      + " is not a directory");
+        }
+    }
+    else
+    {
+        std::filesystem::create_directories(directory);
+    }
+}
+
+/// Write-through client
+void Archive::setWriteThroughClient(std::unique_ptr<IClient> &&client)
+{
+    if (client == nullptr){throw std::invalid_argument("Client is null");}
+    pImpl->mWriteThroughClient = std::move(client);
+}
+
+bool Archive::haveWriteThroughClient() const noexcept
+{
+    return pImpl->mWriteThroughClient != nullptr;
+}
+
+/// Write
+void Archive::write(const Waveform &waveform)
+{
+    pImpl->write(waveform);
+}
+
+/// Get data
+Waveform Archive::getData(const Request &request) const
+{
+    auto result = pImpl->read(request);
+    if (!pImpl->mWriteThroughClient){return result;}
+    auto localCompleteness = ::percentComplete(result, request);
+    if (localCompleteness >= pImpl->mCompleteTolerance){return result;}
+    try
+    {
+        auto waveform = pImpl->mWriteThroughClient->getData(request);
+        if (::percentComplete(waveform, request) <= localCompleteness)
+        {
+            return result;
+        }
+        if (!waveform.haveNetwork()){waveform.setNetwork(request.getNetwork());}
+        if (!waveform.haveStation()){waveform.setStation(request.getStation());}
+        if (!waveform.haveChannel()){waveform.setChannel(request.getChannel());}
+        if (!waveform.haveLocationCode() && request.haveLocationCode())
+        {
+            waveform.setLocationCode(request.getLocationCode());
+        }
+        try
+        {
+            pImpl->write(waveform);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to archive waveform; failed with: "
+                       + std::string {e.what()});
+        }
+        result = std::move(waveform);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::warn("Write-through client "
+                   + pImpl->mWriteThroughClient->getType()
+                   + " failed with: " + std::string {e.what()});
+    }
+    return result;
+}
+
+/// Directory
+std::filesystem::path Archive::getDirectory() const noexcept
+{
+    return pImpl->mDirectory;
+}
+
+/// Type
+std::string Archive::getType() const noexcept
+{
+    return TYPE;
+}
+
+/// Destructor
+Archive::~Archive() = default;
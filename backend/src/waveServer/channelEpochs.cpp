@@ -0,0 +1,260 @@
+#include <string>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <cctype>
+#include "mlReview/waveServer/channelEpochs.hpp"
+#include "mlReview/waveServer/request.hpp"
+
+using namespace MLReview::WaveServer;
+
+namespace
+{
+
+/// Removes whitespace and converts to upper case
+std::string normalize(const std::string &input)
+{
+    std::string result;
+    result.reserve(input.size());
+    for (const auto &c : input)
+    {
+        if (std::isspace(static_cast<unsigned char> (c))){continue;}
+        result.push_back(static_cast<char>
+                         (std::toupper(static_cast<unsigned char> (c))));
+    }
+    return result;
+}
+
+/// Blank location codes are variously written as nothing, spaces, or --
+std::string normalizeLocationCode(const std::string &input)
+{
+    auto result = ::normalize(input);
+    if (result == "--"){result.clear();}
+    return result;
+}
+
+/// Orders epochs by network, station, channel, location code, on date
+auto toKey(const ChannelEpochs::Epoch &epoch)
+{
+    return std::tie(epoch.network, epoch.station,
+                    epoch.channel, epoch.locationCode, epoch.onDate);
+}
+
+/// Orders epochs by channel
+auto toChannelKey(const ChannelEpochs::Epoch &epoch)
+{
+    return std::tie(epoch.network, epoch.station,
+                    epoch.channel, epoch.locationCode);
+}
+
+/// Orders epochs by station
+auto toStationKey(const ChannelEpochs::Epoch &epoch)
+{
+    return std::tie(epoch.network, epoch.station);
+}
+
+}
+
+class ChannelEpochs::ChannelEpochsImpl
+{
+public:
+    using Iterator = std::vector<Epoch>::const_iterator;
+    /// The epochs of the station
+    [[nodiscard]] std::pair<Iterator, Iterator>
+        getStationRange(const std::string &network,
+                        const std::string &station) const
+    {
+        Epoch key;
+        key.network = network;
+        key.station = station;
+        return std::equal_range(mEpochs.begin(), mEpochs.end(), key,
+                                [](const Epoch &lhs, const Epoch &rhs)
+                                {
+                                    return ::toStationKey(lhs)
+                                         < ::toStationKey(rhs);
+                                });
+    }
+    /// The epochs of the channel
+    [[nodiscard]] std::pair<Iterator, Iterator>
+        getChannelRange(const std::string &network,
+                        const std::string &station,
+                        const std::string &channel,
+                        const std::string &locationCode) const
+    {
+        Epoch key;
+        key.network = network;
+        key.station = station;
+        key.channel = channel;
+        key.locationCode = locationCode;
+        return std::equal_range(mEpochs.begin(), mEpochs.end(), key,
+                                [](const Epoch &lhs, const Epoch &rhs)
+                                {
+                                    return ::toChannelKey(lhs)
+                                         < ::toChannelKey(rhs);
+                                });
+    }
+    std::vector<Epoch> mEpochs;
+};
+
+/// Constructor
+ChannelEpochs::ChannelEpochs() :
+    pImpl(std::make_unique<ChannelEpochsImpl> ())
+{
+}
+
+/// Constructor
+ChannelEpochs::ChannelEpochs(std::vector<Epoch> &&epochs) :
+    pImpl(std::make_unique<ChannelEpochsImpl> ())
+{
+    for (auto &epoch : epochs)
+    {
+        epoch.network = ::normalize(epoch.network);
+        epoch.station = ::normalize(epoch.station);
+        epoch.channel = ::normalize(epoch.channel);
+        epoch.locationCode = ::normalizeLocationCode(epoch.locationCode);
+        if (epoch.network.empty())
+        {
+            throw std::invalid_argument("Network is empty");
+        }
+        if (epoch.station.empty())
+        {
+            throw std::invalid_argument("Station is empty");
+        }
+        if (epoch.channel.empty())
+        {
+            throw std::invalid_argument("Channel is empty");
+        }
+        if (epoch.offDate < epoch.onDate)
+        {
+            throw std::invalid_argument("Off date of "
+                                      + epoch.network + "."
+                                      + epoch.station + "."
+                                      + epoch.channel
+                                      + " precedes on date");
+        }
+    }
+    std::sort(epochs.begin(), epochs.end(),
+              [](const Epoch &lhs, const Epoch &rhs)
+              {
+                  return ::toKey(lhs) < ::toKey(rhs);
+              });
+    pImpl->mEpochs = std::move(epochs);
+    pImpl->mEpochs.shrink_to_fit();
+}
+
+/// Copy constructor
+ChannelEpochs::ChannelEpochs(const ChannelEpochs &epochs)
+{
+    *this = epochs;
+}
+
+/// Move constructor
+ChannelEpochs::ChannelEpochs(ChannelEpochs &&epochs) noexcept
+{
+    *this = std::move(epochs);
+}
+
+/// Copy assignment
+ChannelEpochs& ChannelEpochs::operator=(const ChannelEpochs &epochs)
+{
+    if (&epochs == this){return *this;}
+    pImpl = std::make_unique<ChannelEpochsImpl> (*epochs.pImpl);
+    return *this;
+}
+
+/// Move assignment
+ChannelEpochs& ChannelEpochs::operator=(ChannelEpochs &&epochs) noexcept
+{
+    if (&epochs == this){return *this;}
+    pImpl = std::move(epochs.pImpl);
+    return *this;
+}
+
+/// Destructor
+ChannelEpochs::~ChannelEpochs() = default;
+
+/// Size
+size_t ChannelEpochs::size() const noexcept
+{
+    return pImpl->mEpochs.size();
+}
+
+/// Have station?
+bool ChannelEpochs::haveStation(const std::string &network,
+                                const std::string &station) const noexcept
+{
+    auto [first, last]
+        = pImpl->getStationRange(::normalize(network), ::normalize(station));
+    return first != last;
+}
+
+/// Find the epoch containing the time
+std::optional<ChannelEpochs::Epoch>
+    ChannelEpochs::find(const std::string &network,
+                        const std::string &station,
+                        const std::string &channel,
+                        const std::string &locationCode,
+                        const std::chrono::microseconds &time) const
+{
+    auto [first, last]
+        = pImpl->getChannelRange(::normalize(network),
+                                 ::normalize(station),
+                                 ::normalize(channel),
+                                 ::normalizeLocationCode(locationCode));
+    // The epochs are sorted by on date so search back from the last epoch
+    // that started at or before the time
+    auto it = std::upper_bound(first, last, time,
+                               [](const std::chrono::microseconds &lhs,
+                                  const Epoch &rhs)
+                               {
+                                   return lhs < rhs.onDate;
+                               });
+    while (it != first)
+    {
+        --it;
+        if (time < it->offDate){return std::optional<Epoch> (*it);}
+    }
+    return std::nullopt;
+}
+
+/// Station epochs
+std::vector<ChannelEpochs::Epoch>
+    ChannelEpochs::getEpochs(const std::string &network,
+                             const std::string &station,
+                             const std::optional<std::chrono::microseconds> &time) const
+{
+    std::vector<Epoch> result;
+    auto [first, last]
+        = pImpl->getStationRange(::normalize(network), ::normalize(station));
+    for (auto it = first; it != last; ++it)
+    {
+        if (time && (*time < it->onDate || *time >= it->offDate)){continue;}
+        result.push_back(*it);
+    }
+    return result;
+}
+
+/// May have data?
+bool ChannelEpochs::mayHaveData(const Request &request) const
+{
+    auto network = ::normalize(request.getNetwork());
+    auto station = ::normalize(request.getStation());
+    if (!haveStation(network, station)){return true;}
+    std::string locationCode;
+    if (request.haveLocationCode())
+    {
+        locationCode = ::normalizeLocationCode(request.getLocationCode());
+    }
+    auto [first, last]
+        = pImpl->getChannelRange(network, station,
+                                 ::normalize(request.getChannel()),
+                                 locationCode);
+    auto startTime = request.getStartTime();
+    auto endTime = request.getEndTime();
+    for (auto it = first; it != last; ++it)
+    {
+        if (it->onDate >= endTime){break;}
+        if (it->offDate > startTime){return true;}
+    }
+    return false;
+}
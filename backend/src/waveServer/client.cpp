@@ -1,3 +1,5 @@
+#include <unordered_map>
+#include <stdexcept>
 #include <spdlog/spdlog.h>
 #include "mlReview/waveServer/client.hpp"
 #include "mlReview/waveServer/waveform.hpp"
@@ -8,41 +10,49 @@ using namespace MLReview::WaveServer;
 /// Destructor
 IClient::~IClient() = default;
 
+/// Batching
+bool IClient::batchesRequests() const noexcept
+{
+    return false;
+}
+
 /// Request data
 std::vector<Waveform>
 IClient::getData(const std::vector<Request> &requests) const
 {
     std::vector<Waveform> result;
-    // Create a unique set of requests
-    std::vector<std::pair<Request, Waveform>> filledRequests;
-    for (const auto &request: requests)
+    result.reserve(requests.size());
+    // Maps a unique request to the index of its waveform in result
+    std::unordered_map<Request, size_t> filledRequests;
+    filledRequests.reserve(requests.size());
+    size_t nFailures{0};
+    for (const auto &request : requests)
     {
-        bool found{false};
-        for (const auto &filledRequest : filledRequests)
+        auto it = filledRequests.find(request);
+        if (it != filledRequests.end())
         {
-            if (request == filledRequest.first)
-            {
-                result.push_back(filledRequest.second);
-                found = true;
-                break;
-            }
+            result.push_back(result[it->second]);
+            continue;
         }
-        if (!found)
+        try
         {
-            try
-            {
-                auto waveform = getData(request);
-                result.push_back(waveform);
-                filledRequests.push_back(
-                    std::move(std::pair {request, std::move(waveform)}));
-            }
-            catch (const std::exception &e)
-            {
-                spdlog::warn("Failed to get data for");
-                filledRequests.push_back(std::pair {request, Waveform {}});
-                result.push_back(Waveform {});
-            }
+            result.push_back(getData(request));
         }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to get data; failed with: "
+                       + std::string {e.what()});
+            result.push_back(Waveform {});
+            nFailures = nFailures + 1;
+        }
+        filledRequests.insert(std::pair {request, result.size() - 1});
+    }
+    // Finding no data is normal but a batch that could not be read at all
+    // is an error
+    if (nFailures > 0 && nFailures == filledRequests.size())
+    {
+        throw std::runtime_error("All " + std::to_string(nFailures)
+                               + " requests failed");
     }
     return result;
 }
@@ -0,0 +1,135 @@
+#ifndef COMPLETENESS_HPP
+#define COMPLETENESS_HPP
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "mlReview/waveServer/waveform.hpp"
+#include "mlReview/waveServer/segment.hpp"
+#include "mlReview/waveServer/request.hpp"
+namespace
+{
+
+/// Computes the percentage of the requested window that the waveform covers
+double percentComplete(const MLReview::WaveServer::Waveform &waveform,
+                       const MLReview::WaveServer::Request &request)
+{
+    if (waveform.getNumberOfSegments() < 1){return 0;}
+    auto startTime = request.getStartTime();
+    auto endTime = request.getEndTime();
+    auto desiredDuration = endTime - startTime;
+    if (desiredDuration == std::chrono::microseconds {0}){return 100;}
+    // This is fairly easy
+    std::chrono::microseconds missingDuration{0};
+    if (waveform.getNumberOfSegments() == 1)
+    {
+        const auto &segment = waveform.at(0);
+        if (segment.getStartTime() > startTime)
+        {
+            missingDuration = missingDuration
+                            + (segment.getStartTime() - startTime);
+        } 
+        if (segment.getEndTime() < endTime)
+        {
+            missingDuration = missingDuration
+                            + (endTime - segment.getEndTime());
+        }
+    }
+    else
+    {
+        // This is a bit harder because we have gappy data.  Figure out
+        // the start gap.
+        auto nSegments = waveform.getNumberOfSegments();
+        int startSegment =-1;
+        for (int iSegment = 0; iSegment < nSegments; ++iSegment)
+        {
+            const auto &segment = waveform.at(iSegment);
+            if (segment.getEndTime() >= startTime)
+            {
+                if (segment.getStartTime() >= startTime)
+                {
+                    missingDuration = missingDuration
+                                    + (segment.getStartTime() - startTime);
+                }
+                startSegment = iSegment;
+                break;
+            }
+        }
+        // Never made it to the start - quit early
+        if (startSegment < 0){return 0;}
+        // Figure out the end gap.
+        int endSegment = nSegments;
+        for (int iSegment = nSegments - 1; iSegment >= startSegment; --iSegment)
+        {
+            const auto &segment = waveform.at(iSegment);
+            if (segment.getStartTime() <= endTime)
+            {
+                if (segment.getEndTime() <= endTime)
+                { 
+                    missingDuration = missingDuration
+                                    + (endTime - segment.getEndTime());
+                }
+                endSegment = iSegment;
+                break;
+            }
+        }
+        // Never made it to the end which should be impossible at this point.
+        if (endSegment == nSegments)
+        {
+            return 0; 
+        }
+        // Tally gaps for every segment between (assuming segments are ordered
+        // in time and there's no weird overlaps)
+        for (int iSegment = startSegment; iSegment < endSegment; ++iSegment)
+        {
+             auto segment0 = waveform.at(iSegment);
+             auto segment1 = waveform.at(iSegment + 1);            
+             auto gap = segment1.getStartTime() - segment0.getEndTime();
+             auto samplingPeriod = 1./segment0.getSamplingRate();
+             if (gap.count()*1.e-6 > samplingPeriod + 0.5*samplingPeriod)
+             {
+                 missingDuration = missingDuration + gap;
+             }
+        }
+    } 
+    auto fraction = static_cast<double> (missingDuration.count())
+                   /static_cast<double> (desiredDuration.count());
+    return 100*(1 - fraction);
+}
+
+/// An interval of missing data
+using Gap = std::pair<std::chrono::microseconds, std::chrono::microseconds>;
+
+/// Finds the intervals of the requested window that the waveform does not
+/// cover.  As in percentComplete, breaks shorter than 1.5 sampling periods
+/// are not gaps.
+std::vector<Gap> getGaps(const MLReview::WaveServer::Waveform &waveform,
+                         const MLReview::WaveServer::Request &request)
+{
+    std::vector<Gap> result;
+    auto startTime = request.getStartTime();
+    auto endTime = request.getEndTime();
+    auto coveredUntil = startTime;
+    std::chrono::microseconds tolerance{0};
+    for (const auto &segment : waveform)
+    {
+        if (segment.getEndTime() < startTime){continue;}
+        if (segment.getStartTime() > endTime){break;}
+        tolerance = std::chrono::microseconds
+                    {static_cast<int64_t>
+                     (std::round(1.5e6/segment.getSamplingRate()))};
+        if (segment.getStartTime() > coveredUntil + tolerance)
+        {
+            result.push_back(Gap {coveredUntil, segment.getStartTime()});
+        }
+        coveredUntil = std::max(coveredUntil, segment.getEndTime());
+    }
+    if (coveredUntil + tolerance < endTime)
+    {
+        result.push_back(Gap {coveredUntil, endTime});
+    }
+    return result;
+}
+
+}
+#endif
@@ -2,6 +2,10 @@
 #define CURL_IMPL_HPP
 #include <string>
 #include <sstream>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
 #include <curl/curl.h>
 namespace
 {
@@ -19,6 +23,39 @@ namespace
     return 0;
 }
 
+/// Called with each chunk of the response body as it arrives.  Returning
+/// false aborts the transfer.
+using CURLDataCallback = std::function<bool (const char *, size_t)>;
+
+/// The state handed to writeCURLDataToCallback
+struct CURLStreamTarget
+{
+    CURL *curl{nullptr};
+    const CURLDataCallback *callback{nullptr};
+};
+
+/// Callback function that hands the data to a CURLDataCallback.  Bodies of
+/// unsuccessful responses (e.g., a 404 for no data) are consumed but not
+/// forwarded.
+[[nodiscard]] size_t writeCURLDataToCallback(void *buf, const size_t size,
+                                             const size_t nmemb, void *userp)
+{
+    auto len = size*nmemb;
+    if (userp)
+    {
+        auto target = static_cast<CURLStreamTarget *> (userp);
+        long responseCode{0};
+        curl_easy_getinfo(target->curl, CURLINFO_RESPONSE_CODE, &responseCode);
+        if (responseCode != 200){return len;}
+        if (target->callback &&
+            (*target->callback)(static_cast<const char *> (buf), len))
+        {
+            return len;
+        }
+    }
+    return 0;
+}
+
 class CURLImpl
 {
 public:
@@ -80,6 +117,40 @@ public:
         }
         return outputStream.str();
     }
+    /// Gets data from a URL and hands the body to the callback as it arrives.
+    void get(const std::string &url, const CURLDataCallback &callback)
+    {
+        if (url.empty())
+        {
+            throw std::invalid_argument("URL is empty");
+        }
+        CURLStreamTarget target{mCurl, &callback};
+        auto code = curl_easy_setopt(mCurl, CURLOPT_WRITEFUNCTION,
+                                     &writeCURLDataToCallback);
+        if (code == CURLE_OK)
+        {
+            code = curl_easy_setopt(mCurl, CURLOPT_WRITEDATA, &target);
+        }
+        if (code != CURLE_OK)
+        {
+            clear();
+            throw std::runtime_error("Failed to set write callback");
+        }
+        code = curl_easy_setopt(mCurl, CURLOPT_URL, url.c_str());
+        if (code != CURLE_OK)
+        {
+            clear();
+            throw std::runtime_error("Failed to set URL");
+        }
+        code = curl_easy_perform(mCurl);
+        // Restore the default writer
+        curl_easy_setopt(mCurl, CURLOPT_WRITEFUNCTION, &writeCURLData);
+        if (code != CURLE_OK)
+        {
+            clear();
+            throw std::runtime_error("Failed to get data from: " + url);
+        }
+    }
     /// Destructor
     ~CURLImpl()
     {
@@ -104,5 +175,224 @@ private:
     long mTimeOut{120L};
 };
 
+/// Performs many GET requests concurrently with the curl multi interface.
+/// At most mMaximumNumberOfTransfers transfers are in flight at once and
+/// at most mMaximumConnectionsPerHost of those may target the same host.
+class CURLMultiImpl
+{
+public:
+    /// Called with the index of the URL and the next chunk of its body.
+    /// Returning false aborts that transfer.
+    using DataCallback = std::function<bool (size_t, const char *, size_t)>;
+    /// Called with the index of the URL once its transfer succeeds.
+    using SuccessCallback = std::function<void (size_t)>;
+    /// Called with the index of the URL and an error message on failure.
+    using FailureCallback = std::function<void (size_t, const std::string &)>;
+
+    CURLMultiImpl(const int maximumNumberOfTransfers,
+                  const int maximumConnectionsPerHost) :
+        mMaximumNumberOfTransfers(maximumNumberOfTransfers),
+        mMaximumConnectionsPerHost(maximumConnectionsPerHost)
+    {
+        if (mMaximumNumberOfTransfers < 1)
+        {
+            throw std::invalid_argument("Number of transfers must be positive");
+        }
+        if (mMaximumConnectionsPerHost < 1)
+        {
+            throw std::invalid_argument(
+                "Number of connections per host must be positive");
+        }
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        mMulti = curl_multi_init();
+        if (!mMulti)
+        {
+            curl_global_cleanup();
+            throw std::runtime_error("Failed to initialize curl multi");
+        }
+        curl_multi_setopt(mMulti, CURLMOPT_MAX_HOST_CONNECTIONS,
+                          static_cast<long> (mMaximumConnectionsPerHost));
+        curl_multi_setopt(mMulti, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                          static_cast<long> (mMaximumNumberOfTransfers));
+    }
+    /// Gets the data from each URL.  The callbacks are invoked from the
+    /// calling thread as data arrives and as each transfer completes so
+    /// results arrive in completion order, not in the order of the URLs.
+    void get(const std::vector<std::string> &urls,
+             const DataCallback &onData,
+             const SuccessCallback &onSuccess,
+             const FailureCallback &onFailure)
+    {
+        if (urls.empty()){return;}
+        std::vector<Transfer> transfers(urls.size());
+        size_t nextTransfer{0};
+        int nRunning{0};
+        // Tops up the in-flight transfers
+        auto launch = [&]()
+        {
+            while (nextTransfer < urls.size() &&
+                   nRunning < mMaximumNumberOfTransfers)
+            {
+                auto index = nextTransfer;
+                nextTransfer = nextTransfer + 1;
+                try
+                {
+                    transfers[index].start(index, urls[index], mTimeOut,
+                                           onData);
+                    curl_multi_add_handle(mMulti, transfers[index].mCurl);
+                    nRunning = nRunning + 1;
+                }
+                catch (const std::exception &e)
+                {
+                    onFailure(index, std::string {e.what()});
+                }
+            }
+        };
+        // Gives up on everything that has not yet finished
+        auto abort = [&](const std::string &reason)
+        {
+            for (size_t index = 0; index < nextTransfer; ++index)
+            {
+                if (transfers[index].mCurl)
+                {
+                    curl_multi_remove_handle(mMulti, transfers[index].mCurl);
+                    transfers[index].clear();
+                    onFailure(index, reason);
+                }
+            }
+            for (size_t index = nextTransfer; index < urls.size(); ++index)
+            {
+                onFailure(index, reason);
+            }
+        };
+        launch();
+        int stillRunning{0};
+        while (nRunning > 0)
+        {
+            auto code = curl_multi_perform(mMulti, &stillRunning);
+            if (code != CURLM_OK)
+            {
+                abort("curl_multi_perform failed with: "
+                    + std::string {curl_multi_strerror(code)});
+                return;
+            }
+            int nMessages{0};
+            CURLMsg *message{nullptr};
+            while ((message = curl_multi_info_read(mMulti, &nMessages)))
+            {
+                if (message->msg != CURLMSG_DONE){continue;}
+                auto curl = message->easy_handle;
+                auto result = message->data.result;
+                char *privatePointer{nullptr};
+                curl_easy_getinfo(curl, CURLINFO_PRIVATE, &privatePointer);
+                auto index = reinterpret_cast<uintptr_t> (privatePointer);
+                long responseCode{0};
+                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+                curl_multi_remove_handle(mMulti, curl);
+                auto &transfer = transfers.at(index);
+                nRunning = nRunning - 1;
+                if (result != CURLE_OK)
+                {
+                    onFailure(index,
+                              "Failed to get data from: " + urls[index]
+                            + "; failed with: "
+                            + std::string {curl_easy_strerror(result)});
+                }
+                else if (responseCode >= 400 &&
+                         responseCode != 404)
+                {
+                    onFailure(index,
+                              "Request to: " + urls[index]
+                            + " returned HTTP status "
+                            + std::to_string(responseCode));
+                }
+                else
+                {
+                    // Note, 204 and 404 indicate no data
+                    onSuccess(index);
+                }
+                transfer.clear();
+            }
+            launch();
+            if (nRunning > 0)
+            {
+                code = curl_multi_poll(mMulti, nullptr, 0, 1000, nullptr);
+                if (code != CURLM_OK)
+                {
+                    abort("curl_multi_poll failed with: "
+                        + std::string {curl_multi_strerror(code)});
+                    return;
+                }
+            }
+        }
+    }
+    /// Destructor
+    ~CURLMultiImpl()
+    {
+        if (mMulti){curl_multi_cleanup(mMulti);}
+        mMulti = nullptr;
+        curl_global_cleanup();
+    }
+private:
+    /// An individual transfer
+    struct Transfer
+    {
+        void start(const size_t index, const std::string &url,
+                   const long timeOut, const DataCallback &onData)
+        {
+            clear();
+            mCurl = curl_easy_init();
+            if (!mCurl){throw std::runtime_error("Failed to initialize curl");}
+            mCallback = [index, &onData](const char *data, const size_t length)
+            {
+                return onData(index, data, length);
+            };
+            mTarget.curl = mCurl;
+            mTarget.callback = &mCallback;
+            curl_easy_setopt(mCurl, CURLOPT_NOPROGRESS, 1L);
+            curl_easy_setopt(mCurl, CURLOPT_WRITEFUNCTION,
+                             &writeCURLDataToCallback);
+            curl_easy_setopt(mCurl, CURLOPT_WRITEDATA, &mTarget);
+            curl_easy_setopt(mCurl, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(mCurl, CURLOPT_TIMEOUT, timeOut);
+            curl_easy_setopt(mCurl, CURLOPT_PRIVATE,
+                             reinterpret_cast<char *> (index));
+            if (curl_easy_setopt(mCurl, CURLOPT_URL, url.c_str()) != CURLE_OK)
+            {
+                clear();
+                throw std::runtime_error("Failed to set URL");
+            }
+        }
+        void clear() noexcept
+        {
+            if (mCurl){curl_easy_cleanup(mCurl);}
+            mCurl = nullptr;
+            mTarget = CURLStreamTarget {};
+            mCallback = nullptr;
+        }
+        ~Transfer()
+        {
+            clear();
+        }
+        CURLDataCallback mCallback;
+        CURLStreamTarget mTarget;
+        CURL *mCurl{nullptr};
+    };
+
+    CURLMultiImpl(const CURLMultiImpl &curl) = delete;
+    CURLMultiImpl(CURLMultiImpl &&curl) noexcept = delete;
+    CURLMultiImpl& operator=(const CURLMultiImpl &curl) = delete;
+    CURLMultiImpl& operator=(CURLMultiImpl &&curl) noexcept = delete;
+
+    /// CURL multi handle
+    CURLM *mMulti{nullptr};
+    /// The maximum number of in-flight transfers
+    int mMaximumNumberOfTransfers{8};
+    /// The maximum number of connections to a single host
+    int mMaximumConnectionsPerHost{8};
+    /// Each transfer times out after mTimeOut seconds
+    long mTimeOut{120L};
+};
+
 }
 #endif
@@ -1,39 +1,129 @@
 #include <iostream>
 #include <string>
 #include <array>
-#include <set>
+#include <unordered_map>
+#include <optional>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cctype>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <vector>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
 #include <libdali.h>
 #include <libxml/parser.h>
 #include "mlReview/waveServer/dataLink.hpp"
 #include "mlReview/waveServer/request.hpp"
+#include "mlReview/waveServer/waveform.hpp"
 #include "unpackMiniSEED3.hpp"
+#include "streamIdentifier.hpp"
 
 #define TYPE "DataLink"
 
-xmlNode *findNode(xmlNode *node, const char *nodeName)
+using namespace MLReview::WaveServer;
+
+namespace
+{
+
+/// The times of the oldest and newest data in the ring for a stream
+struct StreamTimes
+{
+    dltime_t earliestDataTime{std::numeric_limits<dltime_t>::lowest()};
+    dltime_t latestDataTime{std::numeric_limits<dltime_t>::max()};
+};
+
+/// Maps a stream identifier to its data times.  Once published the index
+/// is immutable.
+using StreamIndex = std::unordered_map<std::string, StreamTimes>;
+
+/// Converts a ringserver time string - e.g., 2024-01-01 00:00:00.123456 or
+/// 2024-01-01T00:00:00.123456Z - to microseconds since the epoch.
+std::optional<dltime_t> parseTime(const char *timeString)
+{
+    if (timeString == nullptr){return std::nullopt;}
+    int year{0}, month{0}, day{0}, hour{0}, minute{0}, second{0};
+    int nCharacters{0};
+    auto nRead = std::sscanf(timeString, "%4d-%2d-%2d%*1c%2d:%2d:%2d%n",
+                             &year, &month, &day,
+                             &hour, &minute, &second, &nCharacters);
+    if (nRead != 6){return std::nullopt;}
+    const std::chrono::year_month_day date{std::chrono::year {year},
+                                           std::chrono::month {static_cast<unsigned int> (month)},
+                                           std::chrono::day {static_cast<unsigned int> (day)}};
+    if (!date.ok()){return std::nullopt;}
+    // Fractional seconds
+    int64_t microSeconds{0};
+    auto fraction = timeString + nCharacters;
+    if (*fraction == '.')
+    {
+        int64_t scale{100000};
+        for (++fraction; std::isdigit(*fraction) && scale > 0; ++fraction)
+        {
+            microSeconds = microSeconds + (*fraction - '0')*scale;
+            scale = scale/10;
+        }
+    }
+    auto seconds = std::chrono::sys_days {date}.time_since_epoch()
+                 + std::chrono::hours {hour}
+                 + std::chrono::minutes {minute}
+                 + std::chrono::seconds {second};
+    return static_cast<dltime_t>
+           (std::chrono::duration_cast<std::chrono::microseconds>
+               (seconds).count() + microSeconds);
+}
+
+/// Finds the first element with the given name.  The tree is walked
+/// depth-first without recursion.
+xmlNode *findNode(xmlNode *root, const char *nodeName)
 {
-    xmlNode *result{nullptr};
-    if (node == nullptr){return result;}
+    auto node = root;
     while (node)
     {
         if (node->type == XML_ELEMENT_NODE &&
             xmlStrcmp(node->name,
                       reinterpret_cast<const xmlChar *> (nodeName)) == 0)
         {
-            return node; 
+            return node;
         }
-        if (result == findNode(node->children, nodeName)){return result;}
-        node = node->next; 
+        // Descend, otherwise move to the next sibling of this node or of
+        // the nearest ancestor that has one
+        if (node->children)
+        {
+            node = node->children;
+            continue;
+        }
+        while (node && node != root && node->next == nullptr)
+        {
+            node = node->parent;
+        }
+        if (node == nullptr || node == root){break;}
+        node = node->next;
     }
     return nullptr;
 }
 
-std::set<std::string> parser(const char *content, size_t length)
+/// Reads an attribute's time
+std::optional<dltime_t> getTimeProperty(xmlNode *node, const char *name)
 {
-    std::set<std::string> result;
+    auto property
+        = xmlGetProp(node, reinterpret_cast<const xmlChar *> (name));
+    if (property == nullptr){return std::nullopt;}
+    auto result = ::parseTime(reinterpret_cast<const char *> (property));
+    xmlFree(property);
+    return result;
+}
+
+/// Parses the STREAMS information returned by the server
+StreamIndex parser(const char *content, size_t length)
+{
+    StreamIndex result;
     xmlDocPtr document;
-    document = xmlReadMemory(content, length, "noname.xml", NULL, 0);
+    document = xmlReadMemory(content, static_cast<int> (length),
+                             "noname.xml", NULL, 0);
     if (document == nullptr)
     {
         throw std::runtime_error("Failed to parse XML");
@@ -59,49 +149,47 @@ std::set<std::string> parser(const char *content, size_t length)
                 auto stringLength = static_cast<size_t> (xmlStrlen(nodeName));
                 auto stringContent = reinterpret_cast<const char *> (nodeName);
                 std::string streamName{stringContent, stringLength};
-                if (!result.contains(streamName))
-                {
-                    //std::cout << streamName << std::endl;
-                    result.insert(streamName);
-                }
                 xmlFree(nodeName);
+                StreamTimes times;
+                auto earliest
+                    = ::getTimeProperty(childNode,
+                                        "EarliestPacketDataStartTime");
+                if (earliest){times.earliestDataTime = *earliest;}
+                auto latest
+                    = ::getTimeProperty(childNode, "LatestPacketDataEndTime");
+                if (latest){times.latestDataTime = *latest;}
+                result.insert_or_assign(std::move(streamName), times);
             }
-/*
-            for (xmlAttrPtr attribute = childNode->properties;
-                 attribute != nullptr;
-                 attribute = attribute->next)
-            {
-            }
-            xmlChar *streamName;
-            streamName = xmlGetProp(childNode, reinterpret_cast<const xmlChar *> ("Stream"));
-std::cout << streamName << std::endl;
-            if (streamName){xmlFree(streamName);}
-*/
             // Update
             childNode = childNode->next;
         } 
-        
     }
     xmlFreeDoc(document);
     return result;
 }
 
-/*
 std::chrono::seconds now()
 {
     auto now = std::chrono::high_resolution_clock::now();
-    return std::chrono::duration_cast<std::chrono::seconds> (now.time_since_epoch());
+    return std::chrono::duration_cast<std::chrono::seconds>
+           (now.time_since_epoch());
 }
-*/
-
-using namespace MLReview::WaveServer;
 
-class DataLink::DataLinkImpl
+/// @brief A single, persistent connection to the DataLink server.
+class Connection
 {
 public:
-    ~DataLinkImpl()
+    Connection(const std::string &url,
+               const std::string &clientName,
+               const std::chrono::seconds &timeOut) :
+        mURL(url),
+        mClientName(clientName),
+        mTimeOut(timeOut)
     {
-        destroyDataLinkClient();
+    }
+    ~Connection()
+    {
+        destroy();
     }
     void createClient()
     {
@@ -109,23 +197,31 @@ public:
         auto clientNameCopy = mClientName;
         mDataLinkClient = dl_newdlcp(urlCopy.data(),
                                      clientNameCopy.data());
+        if (mDataLinkClient == nullptr)
+        {
+            throw std::runtime_error("Failed to create DataLink client");
+        }
         //mDataLinkClient->iotimeout = mTimeOut.count();
         mDataLinkClient->keepalive = mTimeOut.count();
     }
+    /// @brief (Re)connects to the server.
     void connect()
     {
-        if (!mDataLinkClient){createClient();}
-        disconnect();
+        // A fresh handle is the only reliable way to clear the state
+        // from a prior stream
+        destroy();
+        createClient();
         spdlog::debug("Connecting to DataLink server at " + mURL);
         if (dl_connect(mDataLinkClient) < 0)
         {
-            if (mDataLinkClient){dl_freedlcp(mDataLinkClient);}
+            destroy();
             throw std::runtime_error("Failed to connect to DataLink client at "
                                    + mClientName + " at " + mURL);
         }
+        mLastUsed = ::now();
         spdlog::debug("Connected to DataLink server!");
     }
-    void destroyDataLinkClient()
+    void destroy()
     {
         disconnect();
         if (mDataLinkClient){dl_freedlcp(mDataLinkClient);}
@@ -148,22 +244,311 @@ public:
             dl_disconnect(mDataLinkClient);
         }
     }
-    void createStreamList()
+    /// @brief Ends any active stream and clears the match pattern so that
+    ///        the next user starts from a clean slate.
+    /// @result True indicates the connection can be reused.
+    [[nodiscard]] bool reset()
+    {
+        if (!isConnected()){return false;}
+        if (mDataLinkClient->streaming)
+        {
+            // Ask the server to stop streaming and drain what is in flight
+            DLPacket dataLinkPacket;
+            while (true)
+            {
+                auto returnCode = dl_collect(mDataLinkClient,
+                                             &dataLinkPacket,
+                                             mBuffer.data(),
+                                             mBuffer.size(),
+                                             1);
+                if (returnCode == DLENDED){break;}
+                if (returnCode != DLPACKET)
+                {
+                    spdlog::debug("Failed to end DataLink stream");
+                    return false;
+                }
+            }
+        }
+        if (dl_match(mDataLinkClient, nullptr) < 0)
+        {
+            spdlog::debug("Failed to clear DataLink match pattern");
+            return false;
+        }
+        mLastUsed = ::now();
+        return true;
+    }
+    /// @brief Reads the next packet from the stream without blocking past
+    ///        the deadline.
+    /// @result DLPACKET, DLENDED, or DLERROR as from dl_collect, or
+    ///         DLNOPACKET if no packet arrived before the deadline.
+    [[nodiscard]] int collect(
+        DLPacket &packet,
+        const std::chrono::steady_clock::time_point &deadline)
+    {
+        constexpr std::chrono::milliseconds noPacketWait{10};
+        while (true)
+        {
+            auto returnCode = dl_collect_nb(mDataLinkClient,
+                                            &packet,
+                                            mBuffer.data(),
+                                            mBuffer.size(),
+                                            0);
+            if (returnCode != DLNOPACKET){return returnCode;}
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return DLNOPACKET;
+            }
+            std::this_thread::sleep_for(noPacketWait);
+        }
+    }
+    /// @result True indicates the server still answers on this connection.
+    [[nodiscard]] bool isHealthy()
     {
-        mStreamList.clear();
-        connect();
+        if (!isConnected()){return false;}
         char *infoBuffer{nullptr};
         auto informationSize
-            = dl_getinfo(mDataLinkClient, "STREAMS",
+            = dl_getinfo(mDataLinkClient, "STATUS", nullptr, &infoBuffer, 0);
+        if (infoBuffer){free(infoBuffer);}
+        return informationSize > 0;
+    }
+    [[nodiscard]] DLCP *get() noexcept
+    {
+        return mDataLinkClient;
+    }
+    [[nodiscard]] std::array<char, MAXPACKETSIZE> &getBuffer() noexcept
+    {
+        return mBuffer;
+    }
+    [[nodiscard]] std::chrono::seconds getLastUsed() const noexcept
+    {
+        return mLastUsed;
+    }
+
+    Connection(const Connection &) = delete;
+    Connection& operator=(const Connection &) = delete;
+private:
+    DLCP *mDataLinkClient{nullptr};
+    std::string mURL;
+    std::string mClientName;
+    std::array<char, MAXPACKETSIZE> mBuffer;
+    std::chrono::seconds mTimeOut{1};
+    std::chrono::seconds mLastUsed{0};
+};
+
+/// The packets destined for a request in a multi-stream collection
+struct StreamCollection
+{
+    std::vector<char> packetData;
+    dltime_t startTime{0};
+    dltime_t endTime{0};
+    bool done{false};
+};
+
+class ConnectionPool;
+
+/// @brief Gives a thread exclusive use of a pooled connection and returns
+///        it to the pool on destruction.
+class ConnectionLease
+{
+public:
+    ConnectionLease(ConnectionPool *pool,
+                    std::unique_ptr<::Connection> &&connection) :
+        mPool(pool),
+        mConnection(std::move(connection))
+    {
+    }
+    ConnectionLease(ConnectionLease &&lease) noexcept :
+        mPool(lease.mPool),
+        mConnection(std::move(lease.mConnection)),
+        mHealthy(lease.mHealthy)
+    {
+        lease.mPool = nullptr;
+    }
+    ~ConnectionLease();
+    [[nodiscard]] ::Connection &operator*() noexcept
+    {
+        return *mConnection;
+    }
+    [[nodiscard]] ::Connection *operator->() noexcept
+    {
+        return mConnection.get();
+    }
+    /// @brief Flags the connection as bad so it is reconnected before reuse.
+    void invalidate() noexcept
+    {
+        mHealthy = false;
+    }
+
+    ConnectionLease(const ConnectionLease &) = delete;
+    ConnectionLease& operator=(const ConnectionLease &) = delete;
+    ConnectionLease& operator=(ConnectionLease &&) = delete;
+private:
+    ConnectionPool *mPool{nullptr};
+    std::unique_ptr<::Connection> mConnection{nullptr};
+    bool mHealthy{true};
+};
+
+/// @brief A bounded pool of persistent DataLink connections.  Connections
+///        are created lazily, reset when returned, health checked when they
+///        have been idle, and reconnected after an error.
+class ConnectionPool
+{
+public:
+    ConnectionPool(const std::string &url,
+                   const std::string &clientName,
+                   const int maximumNumberOfConnections,
+                   const std::chrono::seconds &timeOut) :
+        mURL(url),
+        mClientName(clientName),
+        mTimeOut(timeOut),
+        mMaximumNumberOfConnections(maximumNumberOfConnections)
+    {
+        if (mMaximumNumberOfConnections < 1)
+        {
+            throw std::invalid_argument(
+                "Maximum number of connections must be positive");
+        }
+    }
+    /// @result A connected connection.  This blocks until one is available.
+    /// @throws std::runtime_error if a connection cannot be established.
+    [[nodiscard]] ::ConnectionLease acquire()
+    {
+        std::unique_ptr<::Connection> connection{nullptr};
+        {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock,
+                        [this]()
+                        {
+                            return !mIdleConnections.empty() ||
+                                   mNumberOfConnections
+                                 < mMaximumNumberOfConnections;
+                        });
+        if (!mIdleConnections.empty())
+        {
+            connection = std::move(mIdleConnections.back());
+            mIdleConnections.pop_back();
+        }
+        else
+        {
+            mNumberOfConnections = mNumberOfConnections + 1;
+        }
+        }
+        try
+        {
+            if (connection == nullptr)
+            {
+                connection
+                    = std::make_unique<::Connection> (mURL, mClientName,
+                                                      mTimeOut);
+            }
+            if (!connection->isConnected())
+            {
+                connection->connect();
+            }
+            else if (::now() - connection->getLastUsed() > mHealthCheckInterval)
+            {
+                if (!connection->isHealthy())
+                {
+                    spdlog::info("Stale DataLink connection; reconnecting");
+                    connection->connect();
+                }
+            }
+        }
+        catch (...)
+        {
+            {
+            std::lock_guard<std::mutex> lockGuard(mMutex);
+            mNumberOfConnections = mNumberOfConnections - 1;
+            }
+            mCondition.notify_one();
+            throw;
+        }
+        return ::ConnectionLease {this, std::move(connection)};
+    }
+    /// @brief Returns a connection to the pool.
+    void release(std::unique_ptr<::Connection> &&connection,
+                 const bool healthy) noexcept
+    {
+        if (connection == nullptr){return;}
+        try
+        {
+            if (!healthy || !connection->reset())
+            {
+                // Will reconnect on next use
+                connection->destroy();
+            }
+        }
+        catch (...)
+        {
+            connection->destroy();
+        }
+        {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        mIdleConnections.push_back(std::move(connection));
+        }
+        mCondition.notify_one();
+    }
+    /// @result True indicates at least one idle connection is connected.
+    [[nodiscard]] bool isConnected() const noexcept
+    {
+        std::lock_guard<std::mutex> lockGuard(mMutex);
+        for (const auto &connection : mIdleConnections)
+        {
+            if (connection->isConnected()){return true;}
+        }
+        return false;
+    }
+private:
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<std::unique_ptr<::Connection>> mIdleConnections;
+    std::string mURL;
+    std::string mClientName;
+    std::chrono::seconds mTimeOut{1};
+    std::chrono::seconds mHealthCheckInterval{60};
+    int mMaximumNumberOfConnections{4};
+    int mNumberOfConnections{0};
+};
+
+ConnectionLease::~ConnectionLease()
+{
+    if (mPool){mPool->release(std::move(mConnection), mHealthy);}
+}
+
+}
+
+class DataLink::DataLinkImpl
+{
+public:
+    DataLinkImpl(const std::string &url,
+                 const std::string &clientName,
+                 const int maximumNumberOfConnections) :
+        mPool(url, clientName, maximumNumberOfConnections, mTimeOut),
+        mClientName(clientName),
+        mURL(url)
+    {
+    }
+    /// Fetches and parses the server's stream list then publishes it.
+    /// On failure the previous index is retained.
+    void refreshStreamIndex()
+    {
+        auto connection = mPool.acquire();
+        char *infoBuffer{nullptr};
+        auto informationSize
+            = dl_getinfo(connection->get(), "STREAMS",
                          nullptr,
                          &infoBuffer, 0);
         if (informationSize > 0)
         {
             try
             {
-                mStreamList = ::parser(infoBuffer, informationSize);
-                spdlog::info("Found " + std::to_string(mStreamList.size())
-                           + " streams");
+                auto streamIndex
+                    = std::make_shared<const ::StreamIndex>
+                      (::parser(infoBuffer, informationSize));
+                auto nStreams = streamIndex->size();
+                mStreamIndex.store(std::move(streamIndex));
+                spdlog::debug("Found " + std::to_string(nStreams)
+                            + " streams");
             }
             catch (const std::exception &e)
             {
@@ -174,16 +559,293 @@ public:
         else
         {
             if (infoBuffer){free(infoBuffer);}
+            connection.invalidate();
         }
-        disconnect();
+    }
+    /// Periodically refreshes the stream index
+    void refreshStreamIndexLoop()
+    {
+        spdlog::debug("Beginning DataLink stream index refresh...");
+        while (true)
+        {
+            {
+            std::unique_lock<std::mutex> lock(mRefreshMutex);
+            mRefreshConditionVariable.wait_for(lock,
+                                               mStreamIndexRefreshInterval,
+                                               [this]
+                                               {
+                                                   return !mKeepRunning;
+                                               });
+            if (!mKeepRunning){break;}
+            }
+            try
+            {
+                refreshStreamIndex();
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to refresh DataLink stream index: "
+                           + std::string {e.what()});
+            }
+        }
+        spdlog::debug("Ending DataLink stream index refresh");
+    }
+    void start()
+    {
+        stop();
+        mKeepRunning = true;
+        mRefreshThread
+            = std::thread(&DataLinkImpl::refreshStreamIndexLoop, this);
+    }
+    void stop()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mRefreshMutex);
+        mKeepRunning = false;
+        }
+        mRefreshConditionVariable.notify_all();
+        if (mRefreshThread.joinable()){mRefreshThread.join();}
+    }
+    ~DataLinkImpl()
+    {
+        stop();
+    }
+    /// @result True indicates the server may have data for the stream in
+    ///         the given window.  Streams that are unknown, whose window
+    ///         ends before the oldest data in the ring, or whose window
+    ///         starts after the newest data in the ring, allowing for data
+    ///         that arrived since the index was refreshed, are not worth
+    ///         querying.
+    [[nodiscard]] bool mayHaveData(const std::string &streamIdentifier,
+                                   const dltime_t startTime,
+                                   const dltime_t endTime) const
+    {
+        auto streamIndex = mStreamIndex.load();
+        auto it = streamIndex->find(streamIdentifier);
+        if (it == streamIndex->end())
+        {
+            spdlog::warn("Stream: " + streamIdentifier
+                       + " not in dataLink server");
+            return false;
+        }
+        // The earliest time only moves forward so a stale index is safe
+        if (endTime < it->second.earliestDataTime)
+        {
+            spdlog::debug("Request for " + streamIdentifier
+                        + " precedes data in ring");
+            return false;
+        }
+        // The latest time moves forward between refreshes so allow for a
+        // refresh interval of new data
+        auto tolerance
+            = std::chrono::duration_cast<std::chrono::microseconds>
+              (mStreamIndexRefreshInterval).count();
+        if (startTime - tolerance > it->second.latestDataTime)
+        {
+            spdlog::debug("Request for " + streamIdentifier
+                        + " follows data in ring");
+            return false;
+        }
+        return true;
+    }
+    /// Collects the packets for the stream on the leased connection
+    [[nodiscard]] std::vector<char> collect(::ConnectionLease &connection,
+                                            std::string &queryString,
+                                            const dltime_t startTime,
+                                            const dltime_t endTime)
+    {
+        auto returnCode = dl_match(connection->get(), queryString.data());
+        if (returnCode < 0)
+        {
+            connection.invalidate();
+            throw std::runtime_error("Failed to set match pattern: "
+                                   + queryString);
+        }
+        returnCode = dl_position_after(connection->get(), startTime);
+        if (returnCode < 0)
+        {
+            connection.invalidate();
+            throw std::runtime_error("Failed to position client");
+        }
+        DLPacket dataLinkPacket;
+        auto &buffer = connection->getBuffer();
+        std::vector<char> packetData;
+        int nPacketsFromDataLink{0};
+        auto deadline = std::chrono::steady_clock::now() + mCollectTimeOut;
+        while (true)
+        {
+            returnCode = connection->collect(dataLinkPacket, deadline);
+            if (returnCode == DLPACKET)
+            {
+                spdlog::debug("Packet received!");
+                if (dataLinkPacket.datasize > 0)
+                {
+                    if (dataLinkPacket.datastart <= endTime &&
+                        dataLinkPacket.dataend >= startTime)
+                    {
+                        nPacketsFromDataLink = nPacketsFromDataLink + 1;
+                        packetData.insert(packetData.end(),
+                                          buffer.begin(),
+                                          buffer.begin()
+                                        + dataLinkPacket.datasize);
+                    }
+                }
+                if (dataLinkPacket.dataend >= endTime){break;}
+            }
+            else if (returnCode == DLENDED)
+            {
+                spdlog::warn("Connection terminated for " + queryString); 
+                connection.invalidate();
+                break;
+            }
+            else if (returnCode == DLNOPACKET)
+            {
+                spdlog::debug("Timed out waiting for packets");
+                break;
+            }
+            else
+            {
+                spdlog::debug("Error in dl_collect: "
+                            + std::to_string(returnCode));
+                connection.invalidate();
+                break;
+            }
+        }
+        spdlog::debug("Read " + std::to_string(nPacketsFromDataLink)
+                    + " packets from data link");
+        return packetData;
+    }
+    /// Collects the packets for several streams in a single pass over the
+    /// ring.  The packets are demultiplexed by stream identifier into each
+    /// request's collection.
+    void collect(::ConnectionLease &connection,
+                 const std::vector<std::pair<std::string,
+                                             std::vector<size_t>>> &streams,
+                 std::vector<::StreamCollection> &collections)
+    {
+        if (streams.empty()){return;}
+        // Build the pattern and find the earliest start and latest end time
+        std::string pattern{"^("};
+        dltime_t startTime{std::numeric_limits<dltime_t>::max()};
+        dltime_t endTime{std::numeric_limits<dltime_t>::lowest()};
+        std::map<std::string, std::vector<size_t>> streamToCollections;
+        for (const auto &stream : streams)
+        {
+            if (pattern.size() > 2){pattern = pattern + "|";}
+            pattern = pattern + ::escapeRegex(stream.first);
+            for (const auto &index : stream.second)
+            {
+                startTime = std::min(startTime, collections[index].startTime);
+                endTime = std::max(endTime, collections[index].endTime);
+            }
+            streamToCollections.insert(stream);
+        }
+        pattern = pattern + ")$";
+        auto returnCode = dl_match(connection->get(), pattern.data());
+        if (returnCode < 0)
+        {
+            connection.invalidate();
+            throw std::runtime_error("Failed to set match pattern: " + pattern);
+        }
+        returnCode = dl_position_after(connection->get(), startTime);
+        if (returnCode < 0)
+        {
+            connection.invalidate();
+            throw std::runtime_error("Failed to position client");
+        }
+        auto nRemaining = static_cast<int> (collections.size());
+        for (const auto &collection : collections)
+        {
+            if (collection.done){nRemaining = nRemaining - 1;}
+        }
+        DLPacket dataLinkPacket;
+        auto &buffer = connection->getBuffer();
+        int nPacketsFromDataLink{0};
+        auto deadline = std::chrono::steady_clock::now() + mCollectTimeOut;
+        while (nRemaining > 0)
+        {
+            returnCode = connection->collect(dataLinkPacket, deadline);
+            if (returnCode == DLPACKET)
+            {
+                // Streams that have gone quiet are abandoned once the
+                // rest of the ring is well past the end of the window
+                if (dataLinkPacket.datastart > endTime + mQuietStreamTolerance)
+                {
+                    spdlog::debug("Remaining streams are quiet; stopping");
+                    break;
+                }
+                auto it = streamToCollections.find(
+                    std::string {dataLinkPacket.streamid});
+                if (it == streamToCollections.end()){continue;}
+                for (const auto &index : it->second)
+                {
+                    auto &collection = collections[index];
+                    if (collection.done){continue;}
+                    if (dataLinkPacket.datasize > 0 &&
+                        dataLinkPacket.datastart <= collection.endTime &&
+                        dataLinkPacket.dataend >= collection.startTime)
+                    {
+                        nPacketsFromDataLink = nPacketsFromDataLink + 1;
+                        collection.packetData.insert(
+                            collection.packetData.end(),
+                            buffer.begin(),
+                            buffer.begin() + dataLinkPacket.datasize);
+                    }
+                    if (dataLinkPacket.dataend >= collection.endTime)
+                    {
+                        collection.done = true;
+                        nRemaining = nRemaining - 1;
+                    }
+                }
+            }
+            else if (returnCode == DLENDED)
+            {
+                spdlog::warn("Connection terminated for multi-stream request");
+                connection.invalidate();
+                break;
+            }
+            else if (returnCode == DLNOPACKET)
+            {
+                spdlog::debug("Timed out waiting for packets for "
+                            + std::to_string(nRemaining) + " requests");
+                break;
+            }
+            else
+            {
+                spdlog::debug("Error in dl_collect: "
+                            + std::to_string(returnCode));
+                connection.invalidate();
+                break;
+            }
+        }
+        spdlog::debug("Read " + std::to_string(nPacketsFromDataLink)
+                    + " packets for " + std::to_string(streams.size())
+                    + " streams from data link");
     }
 //private:
-    DLCP *mDataLinkClient{nullptr};
-    std::set<std::string> mStreamList;
+    std::chrono::seconds mTimeOut{1};
+    ::ConnectionPool mPool;
+    // Readers never wait on a refresh.  Note, libstdc++ guards the atomic
+    // shared_ptr with a short internal lock so this is not lock-free.
+    std::atomic<std::shared_ptr<const ::StreamIndex>>
+        mStreamIndex{std::make_shared<const ::StreamIndex> ()};
+    std::thread mRefreshThread;
+    mutable std::mutex mRefreshMutex;
+    std::condition_variable mRefreshConditionVariable;
+    std::chrono::seconds mStreamIndexRefreshInterval{60};
+    bool mKeepRunning{true};
     std::string mClientName{"daliClient"};
     std::string mURL;
-    std::array<char, MAXPACKETSIZE> mBuffer;
-    std::chrono::seconds mTimeOut{1};
+    /// Bounds the size of the match pattern sent to the server
+    size_t mMaximumStreamsPerBatch{64};
+    size_t mMaximumPatternLength{8192};
+    /// Streams with no data this long (microseconds) after the
+    /// window's end are given up on
+    dltime_t mQuietStreamTolerance{60000000};
+    /// Bounds the time spent reading a request's packets.  Windows that
+    /// end after the newest data in the ring would otherwise wait on
+    /// packets that have not arrived yet.
+    std::chrono::seconds mCollectTimeOut{10};
 };
 
 /*
@@ -196,137 +858,55 @@ DataLink::DataLink() :
 
 /// Constructor
 DataLink::DataLink(const std::string &url,
-                   const std::string &clientName) :
-    pImpl(std::make_unique<DataLinkImpl> ())
+                   const std::string &clientName,
+                   const int maximumNumberOfConnections)
 {
     if (url.empty()){throw std::invalid_argument("URL is empty");}
     if (clientName.empty()){throw std::invalid_argument("clientName is empty");}
-    pImpl->mClientName = clientName;
-    pImpl->mURL = url;
-    pImpl->createStreamList();
+    pImpl = std::make_unique<DataLinkImpl> (url, clientName,
+                                            maximumNumberOfConnections);
+    pImpl->refreshStreamIndex();
+    pImpl->start();
 }
 
 Waveform DataLink::getData(const Request &request) const
 {
     Waveform result;
-    if (!request.haveNetwork())
-    {
-        throw std::invalid_argument("Network not set");
-    }
-    if (!request.haveStation())
-    {
-        throw std::invalid_argument("Station not set");
-    }
-    if (!request.haveChannel())
-    {
-        throw std::invalid_argument("Channel not set");
-    }
-    if (!request.haveStartAndEndTime())
-    {
-        throw std::invalid_argument("Start and end time not set");
-    }
-    std::string locationCode;
-    if (request.haveLocationCode())
-    {
-        locationCode = request.getLocationCode();
-        if (locationCode == "--"){locationCode = "";}
-    }
-    auto queryString = request.getNetwork()
-                     + "_"
-                     + request.getStation()
-                     + "_"
-                     + locationCode
-                     + "_"
-                     + request.getChannel()
-                     + "/MSEED";
-    if (!pImpl->mStreamList.contains(queryString))
-    {
-        spdlog::warn("Stream: " + queryString
-                   + " not in dataLink server");
-        return result;
-    }
-    pImpl->destroyDataLinkClient();
-    pImpl->connect();
-    if (!isConnected())
-    {
-        throw std::runtime_error("No connection");
-    }
+    auto queryString = ::toStreamIdentifier(request);
     // Start the largest expected packet time before
-    spdlog::debug("Querying data for " + queryString);
     dltime_t startTime
         = static_cast<dltime_t> (request.getStartTime().count() - 10000000);
     dltime_t endTime = static_cast<dltime_t> (request.getEndTime().count());
-    auto returnCode = dl_match(pImpl->mDataLinkClient, queryString.data());  // TODO to reset set to null
-    if (returnCode < 0)
-    {
-        throw std::runtime_error("Failed to set match pattern: " + queryString);
-    }
-    returnCode = dl_position_after(pImpl->mDataLinkClient, startTime);
-    if (returnCode < 0)
-    {   
-        throw std::runtime_error("Failed to position client");
-    }   
-    DLPacket dataLinkPacket;
-    int8_t endFlag{0};
-    std::fill(pImpl->mBuffer.begin(), pImpl->mBuffer.end(), '\0');
+    if (!pImpl->mayHaveData(queryString, startTime, endTime)){return result;}
+    spdlog::debug("Querying data for " + queryString);
     std::vector<char> packetData;
-    int nPacketsFromDataLink{0};
-    while (true)
-    {
-        returnCode = dl_collect(pImpl->mDataLinkClient,
-                                &dataLinkPacket,
-                                pImpl->mBuffer.data(),
-                                pImpl->mBuffer.size(),
-                                endFlag);
-        if (returnCode == DLPACKET)
-        {
-            spdlog::debug("Packet received!");
-            if (dataLinkPacket.datasize > 0)
-            {
-                if (dataLinkPacket.datastart <= endTime &&
-                    dataLinkPacket.dataend >= startTime)
-                {
-                    nPacketsFromDataLink = nPacketsFromDataLink + 1;
-                    packetData.insert(packetData.end(),
-                                      pImpl->mBuffer.begin(),
-                                      pImpl->mBuffer.begin()
-                                    + dataLinkPacket.datasize);
-                }
-            }
-            if (dataLinkPacket.dataend >= endTime){break;}
-        }
-        else if (returnCode == DLENDED)
-        {
-            spdlog::warn("Connection terminated for " + queryString); 
-            break;
-        }
-        else if (returnCode == DLNOPACKET)
+    // A pooled connection may have gone stale so retry once on a new one
+    constexpr int nAttempts{2};
+    for (int attempt = 0; attempt < nAttempts; ++attempt)
+    {
+        auto connection = pImpl->mPool.acquire();
+        try
         {
-            spdlog::debug("No packet received for non-blocking request");
+            packetData = pImpl->collect(connection, queryString,
+                                        startTime, endTime);
             break;
         }
-        else
+        catch (const std::exception &e)
         {
-            spdlog::debug("Error in dl_collect: "
-                        + std::to_string(returnCode));
-            break;
+            if (attempt == nAttempts - 1){throw;}
+            spdlog::info("DataLink request failed with: "
+                       + std::string {e.what()} + "; retrying");
         }
     }
-    // Immediately terminate.  This does not appear to be happy when re-entrant.
-    pImpl->destroyDataLinkClient();
-    spdlog::debug("Read " + std::to_string(nPacketsFromDataLink)
-                + " packets from data link");
     try
     {
         auto waveform = ::unpack(packetData.data(), packetData.size()); 
-        //std::cout << waveform.getStartAndEndTime().first << " " << waveform.getStartAndEndTime().second << std::endl;
         waveform.mergeSegments();
         result = std::move(waveform);
         if (result.getNumberOfSegments() > 0)
         {
              spdlog::debug("Found data for " + queryString);
         } 
-        //std::cout << waveform.getStartAndEndTime().first << " " << waveform.getStartAndEndTime().second << std::endl;
     }
     catch (const std::exception &e)
     {
@@ -336,10 +916,161 @@ Waveform DataLink::getData(const Request &request) const
     return result;
 }
 
+/// Fetches many streams in as few passes over the ring as possible
+std::vector<Waveform>
+DataLink::getData(const std::vector<Request> &requests) const
+{
+    std::vector<Waveform> result(requests.size());
+    if (requests.empty()){return result;}
+    // Group the requests by stream.  Note, the same stream can be requested
+    // for several windows.
+    std::vector<::StreamCollection> collections(requests.size());
+    std::vector<std::pair<std::string, std::vector<size_t>>> streams;
+    std::map<std::string, size_t> streamIndex;
+    size_t nFailures{0};
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        collections[i].done = true;
+        try
+        {
+            auto streamIdentifier = ::toStreamIdentifier(requests[i]);
+            // Start the largest expected packet time before
+            collections[i].startTime
+                = static_cast<dltime_t> (requests[i].getStartTime().count()
+                                       - 10000000);
+            collections[i].endTime
+                = static_cast<dltime_t> (requests[i].getEndTime().count());
+            if (!pImpl->mayHaveData(streamIdentifier,
+                                    collections[i].startTime,
+                                    collections[i].endTime))
+            {
+                continue;
+            }
+            collections[i].done = false;
+            auto it = streamIndex.find(streamIdentifier);
+            if (it == streamIndex.end())
+            {
+                streamIndex.insert(std::pair {streamIdentifier,
+                                              streams.size()});
+                streams.push_back(
+                    std::pair {streamIdentifier, std::vector<size_t> {i}});
+            }
+            else
+            {
+                streams[it->second].second.push_back(i);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Invalid DataLink request: "
+                       + std::string {e.what()});
+            nFailures = nFailures + 1;
+        }
+    }
+    // Process the streams in bounded batches - each batch is one pass
+    size_t iStream{0};
+    while (iStream < streams.size())
+    {
+        std::vector<std::pair<std::string, std::vector<size_t>>> batch;
+        size_t patternLength{0};
+        while (iStream < streams.size() &&
+               batch.size() < pImpl->mMaximumStreamsPerBatch)
+        {
+            auto length = 2*streams[iStream].first.size() + 1;
+            if (!batch.empty() &&
+                patternLength + length > pImpl->mMaximumPatternLength)
+            {
+                break;
+            }
+            patternLength = patternLength + length;
+            batch.push_back(streams[iStream]);
+            iStream = iStream + 1;
+        }
+        // Only this batch's requests are outstanding
+        std::vector<::StreamCollection> batchCollections;
+        std::vector<std::pair<std::string, std::vector<size_t>>> batchStreams;
+        std::vector<size_t> batchToRequest;
+        for (const auto &stream : batch)
+        {
+            std::vector<size_t> localIndices;
+            for (const auto &index : stream.second)
+            {
+                localIndices.push_back(batchCollections.size());
+                batchCollections.push_back(collections[index]);
+                batchToRequest.push_back(index);
+            }
+            batchStreams.push_back(std::pair {stream.first, localIndices});
+        }
+        // A pooled connection may have gone stale so retry once
+        constexpr int nAttempts{2};
+        for (int attempt = 0; attempt < nAttempts; ++attempt)
+        {
+            auto connection = pImpl->mPool.acquire();
+            try
+            {
+                pImpl->collect(connection, batchStreams, batchCollections);
+                break;
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("DataLink multi-stream request failed with: "
+                           + std::string {e.what()});
+                for (auto &collection : batchCollections)
+                {
+                    collection.packetData.clear();
+                    collection.done = false;
+                }
+                if (attempt == nAttempts - 1)
+                {
+                    nFailures = nFailures + batchCollections.size();
+                }
+            }
+        }
+        for (size_t k = 0; k < batchCollections.size(); ++k)
+        {
+            collections[batchToRequest[k]].packetData
+                = std::move(batchCollections[k].packetData);
+        }
+    }
+    // Unpack
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        if (collections[i].packetData.empty()){continue;}
+        try
+        {
+            auto waveform = ::unpack(collections[i].packetData.data(),
+                                     collections[i].packetData.size());
+            collections[i].packetData.clear();
+            waveform.mergeSegments();
+            result[i] = std::move(waveform);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to create waveform; failed with: "
+                       + std::string {e.what()});
+            nFailures = nFailures + 1;
+        }
+    }
+    // Finding no data is normal but a batch that could not be read at all
+    // is an error
+    if (nFailures == requests.size())
+    {
+        throw std::runtime_error("All " + std::to_string(nFailures)
+                               + " DataLink requests failed");
+    }
+    return result;
+}
+
 /// Connected?
 bool DataLink::isConnected() const noexcept
 {
-    return pImpl->isConnected();
+    return pImpl->mPool.isConnected();
+}
+
+/// Batching
+bool DataLink::batchesRequests() const noexcept
+{
+    return true;
 }
 
 /// Client type
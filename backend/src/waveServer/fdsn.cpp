@@ -6,6 +6,7 @@
 #include <spdlog/spdlog.h>
 #include "mlReview/waveServer/fdsn.hpp"
 #include "mlReview/waveServer/request.hpp"
+#include "mlReview/waveServer/waveform.hpp"
 #include "curl.hpp"
 #include "unpackMiniSEED3.hpp"
 
@@ -56,14 +57,76 @@ std::string toDateTime(const std::chrono::microseconds &utcTimeMuS)
     return std::string {buffer.data()};
 }
 
+/// Creates the dataselect query corresponding to the request
+std::string createQuery(const std::string &url,
+                        const std::string &service,
+                        const int version,
+                        const Request &request)
+{
+    if (!request.haveNetwork())
+    {
+        throw std::invalid_argument("Network not set");
+    }
+    if (!request.haveStation())
+    {
+        throw std::invalid_argument("Station not set");
+    }
+    if (!request.haveChannel())
+    {
+        throw std::invalid_argument("Channel not set");
+    }
+    if (!request.haveStartAndEndTime())
+    {
+        throw std::invalid_argument("Start and end time not set");
+    }
+    std::string locationCode{"--"};
+    if (request.haveLocationCode())
+    {
+        locationCode = request.getLocationCode();
+    }
+    return url + service
+         + "/dataselect/" + std::to_string(version)
+         + "/query?network=" + request.getNetwork()
+         + "&station=" + request.getStation()
+         + "&channel=" + request.getChannel()
+         + "&location=" + locationCode
+         + "&starttime=" + ::toDateTime(request.getStartTime())
+         + "&endtime=" + ::toDateTime(request.getEndTime())
+         + "&nodata=404";
+}
+
+/// Creates an empty waveform with the request's identifiers
+Waveform createEmptyWaveform(const Request &request)
+{
+    Waveform result;
+    try
+    {
+        if (request.haveNetwork()){result.setNetwork(request.getNetwork());}
+        if (request.haveStation()){result.setStation(request.getStation());}
+        if (request.haveChannel()){result.setChannel(request.getChannel());}
+        if (request.haveLocationCode())
+        {
+            result.setLocationCode(request.getLocationCode());
+        }
+    }
+    catch (...)
+    {
+    }
+    return result;
+}
+
 }
 
 class FDSN::FDSNImpl
 {
 public:
+    size_t getData(
+        const std::vector<Request> &requests,
+        const std::function<void (size_t, Waveform &&)> &callback) const;
     std::string mURL{"https://service.iris.edu/"};
     std::string mService{"fdsnws"};
     int mVersion{VERSION};
+    int mMaximumNumberOfConcurrentRequests{8};
 };
 
 /// Default constructor
@@ -84,61 +147,24 @@ FDSN::FDSN(const std::string &url) :
 Waveform FDSN::getData(const Request &request) const
 {
     Waveform result;
-    if (!request.haveNetwork())
-    {
-        throw std::invalid_argument("Network not set");
-    }
-    if (!request.haveStation())
-    {
-        throw std::invalid_argument("Station not set");
-    }
-    if (!request.haveChannel())
-    {
-        throw std::invalid_argument("Channel not set");
-    }
-    if (!request.haveStartAndEndTime())
-    {
-        throw std::invalid_argument("Start and end time not set");
-    }
-    std::string locationCode{"--"};
-    if (request.haveLocationCode())
-    {
-        locationCode = request.getLocationCode();
-    }
-    auto query = pImpl->mURL + pImpl->mService
-               + "/dataselect/" + std::to_string(pImpl->mVersion)
-               + "/query?network=" + request.getNetwork()
-               + "&station=" + request.getStation()
-               + "&channel=" + request.getChannel()
-               + "&location=" + locationCode
-               + "&starttime=" + ::toDateTime(request.getStartTime())
-               + "&endtime=" + ::toDateTime(request.getEndTime())
-               + "&nodata=404";
+    auto query = ::createQuery(pImpl->mURL, pImpl->mService,
+                               pImpl->mVersion, request);
     //std::cout << query << std::endl;
     spdlog::debug("Performing FDSN query: " + query);
-    std::string payload;
     try
     {
+        // Records are decoded as they arrive so the response body is never
+        // buffered in full
+        ::MiniSEEDAssembler assembler;
         ::CURLImpl curl;
-        payload = curl.get(query);
-        auto waveform = ::unpack(payload);
-        waveform.mergeSegments();
-        result = std::move(waveform);
+        curl.get(query,
+                 [&assembler](const char *data, const size_t length)
+                 {
+                     assembler.append(data, length);
+                     return true;
+                 });
+        result = assembler.finish();
         if (result.getNumberOfSegments() > 0){spdlog::info("success: " + query);}
-//std::cout << payload << std::endl;
-//std::cout << payload.size() << std::endl;
-/*
-std::ofstream outfile("yhh.mseed", std::ofstream::binary | std::ios::out);
-size_t size = payload.size();
-outfile.write(&payload[0], payload.size());
-outfile.close();
-payload.resize(2560);
-std::ifstream infile("yhh.mseed", std::ofstream::binary | std::ios::in);
-infile.read(payload.data(), payload.size());
-auto waveform = ::unpack(payload);
-auto obj = toObject(waveform);
-std::cout<< obj << std::endl;
-*/
     }
     catch (const std::exception &e)
     {
@@ -148,6 +174,134 @@ std::cout<< obj << std::endl;
     return result;
 }
 
+/// Concurrent requests
+void FDSN::setMaximumNumberOfConcurrentRequests(const int nRequests)
+{
+    if (nRequests < 1)
+    {
+        throw std::invalid_argument(
+            "Maximum number of concurrent requests must be positive");
+    }
+    pImpl->mMaximumNumberOfConcurrentRequests = nRequests;
+}
+
+int FDSN::getMaximumNumberOfConcurrentRequests() const noexcept
+{
+    return pImpl->mMaximumNumberOfConcurrentRequests;
+}
+
+/// Gets many waveforms concurrently.  The number of requests that failed,
+/// as opposed to finding no data, is returned.
+size_t FDSN::FDSNImpl::getData(
+    const std::vector<Request> &requests,
+    const std::function<void (size_t, Waveform &&)> &callback) const
+{
+    if (requests.empty()){return 0;}
+    // Build the queries.  Bad requests are reported immediately.
+    std::vector<std::string> queries;
+    std::vector<size_t> requestIndices;
+    size_t nFailures{0};
+    queries.reserve(requests.size());
+    requestIndices.reserve(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        try
+        {
+            queries.push_back(::createQuery(mURL, mService,
+                                            mVersion, requests[i]));
+            requestIndices.push_back(i);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Could not create FDSN query because: "
+                       + std::string {e.what()});
+            nFailures = nFailures + 1;
+            callback(i, ::createEmptyWaveform(requests[i]));
+        }
+    }
+    if (queries.empty()){return nFailures;}
+    spdlog::debug("Performing " + std::to_string(queries.size())
+                + " FDSN queries");
+    // Each transfer decodes its records as they arrive
+    std::vector<::MiniSEEDAssembler> assemblers(queries.size());
+    auto onData = [&](const size_t queryIndex,
+                      const char *data, const size_t length)
+    {
+        assemblers.at(queryIndex).append(data, length);
+        return true;
+    };
+    auto onSuccess = [&](const size_t queryIndex)
+    {
+        auto index = requestIndices.at(queryIndex);
+        try
+        {
+            auto waveform = assemblers.at(queryIndex).finish();
+            if (waveform.getNumberOfSegments() > 0)
+            {
+                spdlog::info("success: " + queries[queryIndex]);
+            }
+            else
+            {
+                waveform = ::createEmptyWaveform(requests[index]);
+            }
+            callback(index, std::move(waveform));
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to unpack FDSN response; failed with: "
+                       + std::string {e.what()});
+            nFailures = nFailures + 1;
+            callback(index, ::createEmptyWaveform(requests[index]));
+        }
+    };
+    auto onFailure = [&](const size_t queryIndex, const std::string &reason)
+    {
+        auto index = requestIndices.at(queryIndex);
+        assemblers.at(queryIndex).clear();
+        spdlog::warn("CURL request failed with: " + reason);
+        nFailures = nFailures + 1;
+        callback(index, ::createEmptyWaveform(requests[index]));
+    };
+    // Only one host is ever queried so the per-host limit is the same as the
+    // total concurrency limit 
+    ::CURLMultiImpl curl(mMaximumNumberOfConcurrentRequests,
+                         mMaximumNumberOfConcurrentRequests);
+    curl.get(queries, onData, onSuccess, onFailure);
+    return nFailures;
+}
+
+/// Gets many waveforms concurrently 
+void FDSN::getData(
+    const std::vector<Request> &requests,
+    const std::function<void (size_t, Waveform &&)> &callback) const
+{
+    pImpl->getData(requests, callback);
+}
+
+std::vector<Waveform>
+FDSN::getData(const std::vector<Request> &requests) const
+{
+    std::vector<Waveform> result(requests.size());
+    auto nFailures
+        = pImpl->getData(requests,
+                         [&result](const size_t index, Waveform &&waveform)
+                         {
+                             result.at(index) = std::move(waveform);
+                         });
+    if (!requests.empty() && nFailures == requests.size())
+    {
+        throw std::runtime_error("All " + std::to_string(nFailures)
+                               + " FDSN requests failed");
+    }
+    return result;
+}
+
+/// Batching
+bool FDSN::batchesRequests() const noexcept
+{
+    return true;
+}
+
 std::string FDSN::getType() const noexcept
 {
     return TYPE;
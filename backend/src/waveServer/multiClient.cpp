@@ -2,11 +2,23 @@
 #include <vector>
 #include <chrono>
 #include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <functional>
+#include <unordered_map>
 #include <spdlog/spdlog.h>
 #include "mlReview/waveServer/multiClient.hpp"
 #include "mlReview/waveServer/waveform.hpp"
 #include "mlReview/waveServer/segment.hpp"
 #include "mlReview/waveServer/request.hpp"
+#include "mlReview/waveServer/channelEpochs.hpp"
+#include "completeness.hpp"
 
 #define TYPE "MultiClient"
 
@@ -14,98 +26,830 @@ using namespace MLReview::WaveServer;
 
 namespace
 {
-double percentComplete(const Waveform &waveform,
-                       const Request &request)
+/// Fills in any waveform identifiers the client did not provide
+void setIdentifiers(Waveform &waveform, const Request &request)
 {
-    if (waveform.getNumberOfSegments() < 1){return 0;}
-    auto startTime = request.getStartTime();
-    auto endTime = request.getEndTime();
-    auto desiredDuration = endTime - startTime;
-    if (desiredDuration == std::chrono::microseconds {0}){return 100;}
-    // This is fairly easy
-    std::chrono::microseconds missingDuration{0};
-    if (waveform.getNumberOfSegments() == 1)
+    if (!waveform.haveNetwork())
     {
-        const auto &segment = waveform.at(0);
-        if (segment.getStartTime() > startTime)
+        waveform.setNetwork(request.getNetwork());
+    }
+    if (!waveform.haveStation())
+    {
+        waveform.setStation(request.getStation());
+    }
+    if (!waveform.haveChannel())
+    {
+        waveform.setChannel(request.getChannel());
+    }
+    if (!waveform.haveLocationCode())
+    {
+        if (request.haveLocationCode())
         {
-            missingDuration = missingDuration
-                            + (segment.getStartTime() - startTime);
-        } 
-        if (segment.getEndTime() < endTime)
+            waveform.setLocationCode(request.getLocationCode());
+        }
+    }
+}
+
+/// Appends the samples of the segment inside the gap to the waveform.
+/// The gap's end points are covered by existing data unless they are the
+/// request's end points.
+template<typename T>
+void addTrimmedSegment(const Segment &segment,
+                       const ::Gap &gap,
+                       const bool includeStart,
+                       const bool includeEnd,
+                       Waveform &waveform)
+{
+    auto data = segment.getData<T> ();
+    auto samplingPeriod = 1.e6/segment.getSamplingRate();
+    auto startTime = segment.getStartTime().count();
+    auto gapStart = gap.first.count();
+    auto gapEnd = gap.second.count();
+    auto toTime = [&](const size_t i)
+    {
+        return startTime + static_cast<int64_t> (std::round(i*samplingPeriod));
+    };
+    size_t i0{0};
+    while (i0 < data.size() &&
+           (toTime(i0) < gapStart || (!includeStart && toTime(i0) == gapStart)))
+    {
+        i0 = i0 + 1;
+    }
+    auto i1 = i0;
+    while (i1 < data.size() &&
+           (toTime(i1) < gapEnd || (includeEnd && toTime(i1) == gapEnd)))
+    {
+        i1 = i1 + 1;
+    }
+    if (i1 <= i0){return;}
+    Segment trimmedSegment;
+    trimmedSegment.setStartTime(std::chrono::microseconds {toTime(i0)});
+    trimmedSegment.setSamplingRate(segment.getSamplingRate());
+    trimmedSegment.setData(std::vector<T> (data.begin() + i0,
+                                           data.begin() + i1));
+    waveform.addSegment(std::move(trimmedSegment));
+}
+
+void addTrimmedSegment(const Segment &segment,
+                       const ::Gap &gap,
+                       const bool includeStart,
+                       const bool includeEnd,
+                       Waveform &waveform)
+{
+    auto dataType = segment.getDataType();
+    if (dataType == Segment::DataType::Integer32)
+    {
+        ::addTrimmedSegment<int> (segment, gap, includeStart, includeEnd,
+                                  waveform);
+    }
+    else if (dataType == Segment::DataType::Float)
+    {
+        ::addTrimmedSegment<float> (segment, gap, includeStart, includeEnd,
+                                    waveform);
+    }
+    else if (dataType == Segment::DataType::Double)
+    {
+        ::addTrimmedSegment<double> (segment, gap, includeStart, includeEnd,
+                                     waveform);
+    }
+    else if (dataType == Segment::DataType::Integer64)
+    {
+        ::addTrimmedSegment<int64_t> (segment, gap, includeStart, includeEnd,
+                                      waveform);
+    }
+}
+
+/// The time since the start time
+std::chrono::microseconds elapsed(
+    const std::chrono::steady_clock::time_point &startTime)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>
+           (std::chrono::steady_clock::now() - startTime);
+}
+
+/// @brief A fixed-size pool of worker threads.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(const int nThreads)
+    {
+        for (int i = 0; i < nThreads; ++i)
+        {
+            mThreads.push_back(std::thread(&ThreadPool::work, this));
+        }
+    }
+    ~ThreadPool()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mKeepRunning = false;
+        }
+        mConditionVariable.notify_all();
+        for (auto &thread : mThreads)
         {
-            missingDuration = missingDuration
-                            + (endTime - segment.getEndTime());
+            if (thread.joinable()){thread.join();}
         }
     }
-    else
+    /// @result A future that is ready once the task has run.
+    [[nodiscard]] std::future<void> submit(std::function<void()> &&task)
     {
-        // This is a bit harder because we have gappy data.  Figure out
-        // the start gap.
-        auto nSegments = waveform.getNumberOfSegments();
-        int startSegment =-1;
-        for (int iSegment = 0; iSegment < nSegments; ++iSegment)
+        std::packaged_task<void()> packagedTask(std::move(task));
+        auto future = packagedTask.get_future();
         {
-            const auto &segment = waveform.at(iSegment);
-            if (segment.getEndTime() >= startTime)
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push_back(std::move(packagedTask));
+        }
+        mConditionVariable.notify_one();
+        return future;
+    }
+    /// @brief Queues a task whose completion is not waited on.
+    void post(std::function<void()> &&task)
+    {
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push_back(std::packaged_task<void()> (std::move(task)));
+        }
+        mConditionVariable.notify_one();
+    }
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool& operator=(const ThreadPool &) = delete;
+private:
+    void work()
+    {
+        while (true)
+        {
+            std::packaged_task<void()> task;
             {
-                if (segment.getStartTime() >= startTime)
-                {
-                    missingDuration = missingDuration
-                                    + (segment.getStartTime() - startTime);
-                }
-                startSegment = iSegment;
-                break;
+            std::unique_lock<std::mutex> lock(mMutex);
+            mConditionVariable.wait(lock,
+                                    [this]
+                                    {
+                                        return !mKeepRunning || !mTasks.empty();
+                                    });
+            if (mTasks.empty()){break;}
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
             }
+            task();
+        }
+    }
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::deque<std::packaged_task<void()>> mTasks;
+    std::vector<std::thread> mThreads;
+    bool mKeepRunning{true};
+};
+
+/// @brief Tracks a client's recent request latencies.
+class LatencyStatistics
+{
+public:
+    void add(const std::chrono::microseconds &latency)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLatencies.push_back(latency);
+        if (mLatencies.size() > mMaximumNumberOfSamples)
+        {
+            mLatencies.pop_front();
+        }
+    }
+    /// @result The given percentile of the recent latencies or the
+    ///         default if there are too few samples to say.
+    [[nodiscard]] std::chrono::microseconds
+        getPercentile(const double percentile,
+                      const std::chrono::microseconds &defaultLatency) const
+    {
+        std::vector<std::chrono::microseconds> latencies;
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mLatencies.size() < mMinimumNumberOfSamples)
+        {
+            return defaultLatency;
         }
-        // Never made it to the start - quit early
-        if (startSegment < 0){return 0;}
-        // Figure out the end gap.
-        int endSegment = nSegments;
-        for (int iSegment = nSegments - 1; iSegment >= startSegment; --iSegment)
+        latencies.assign(mLatencies.begin(), mLatencies.end());
+        }
+        auto index = static_cast<size_t>
+                     (std::ceil(percentile/100*latencies.size())) - 1;
+        index = std::min(index, latencies.size() - 1);
+        std::nth_element(latencies.begin(), latencies.begin() + index,
+                         latencies.end());
+        return latencies[index];
+    }
+private:
+    mutable std::mutex mMutex;
+    std::deque<std::chrono::microseconds> mLatencies;
+    size_t mMaximumNumberOfSamples{256};
+    size_t mMinimumNumberOfSamples{10};
+};
+
+/// @brief Tracks a client's rolling error rate and trips a circuit breaker
+///        when it is failing.  An open circuit rejects requests until the
+///        open duration elapses, after which a single probe request is let
+///        through (half-open).  A successful probe closes the circuit and a
+///        failed probe re-opens it.
+class HealthMonitor
+{
+public:
+    using CircuitState = MultiClient::CircuitState;
+    explicit HealthMonitor(const std::chrono::seconds &openDuration) :
+        mOpenDuration(openDuration)
+    {
+    }
+    /// @result True indicates the client may be queried now.
+    [[nodiscard]] bool allowRequest()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mState == CircuitState::Closed){return true;}
+        if (mState == CircuitState::Open)
         {
-            const auto &segment = waveform.at(iSegment);
-            if (segment.getStartTime() <= endTime)
+            if (std::chrono::steady_clock::now() < mOpenedAt + mOpenDuration)
             {
-                if (segment.getEndTime() <= endTime)
-                { 
-                    missingDuration = missingDuration
-                                    + (endTime - segment.getEndTime());
-                }
-                endSegment = iSegment;
-                break;
+                return false;
             }
+            mState = CircuitState::HalfOpen;
+            mProbeInFlight = false;
+        }
+        // Half-open - only one probe at a time
+        if (mProbeInFlight){return false;}
+        mProbeInFlight = true;
+        return true;
+    }
+    /// @brief Records the outcome of a request.  Requests slower than the
+    ///        slow call threshold count as failures.
+    void record(const bool success, const std::chrono::microseconds &latency)
+    {
+        auto failed = !success || latency > mSlowCallThreshold;
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOutcomes.push_back(failed);
+        if (failed){mFailures = mFailures + 1;}
+        if (mOutcomes.size() > mWindowSize)
+        {
+            if (mOutcomes.front()){mFailures = mFailures - 1;}
+            mOutcomes.pop_front();
         }
-        // Never made it to the end which should be impossible at this point.
-        if (endSegment == nSegments)
+        if (mState == CircuitState::HalfOpen)
         {
-            return 0; 
+            mProbeInFlight = false;
+            if (failed)
+            {
+                open();
+            }
+            else
+            {
+                mState = CircuitState::Closed;
+                mOutcomes.clear();
+                mFailures = 0;
+            }
         }
-        // Tally gaps for every segment between (assuming segments are ordered
-        // in time and there's no weird overlaps)
-        for (int iSegment = startSegment; iSegment < endSegment; ++iSegment)
+        else if (mState == CircuitState::Closed)
         {
-             auto segment0 = waveform.at(iSegment);
-             auto segment1 = waveform.at(iSegment + 1);            
-             auto gap = segment1.getStartTime() - segment0.getEndTime();
-             auto samplingPeriod = 1./segment0.getSamplingRate();
-             if (gap.count()*1.e-6 > samplingPeriod + 0.5*samplingPeriod)
-             {
-                 missingDuration = missingDuration + gap;
-             }
+            if (mOutcomes.size() >= mMinimumNumberOfRequests &&
+                getErrorRateUnlocked() >= mFailureRateThreshold)
+            {
+                open();
+            }
         }
-    } 
-    auto fraction = static_cast<double> (missingDuration.count())
-                   /static_cast<double> (desiredDuration.count());
-    return 100*(1 - fraction);
-}
+    }
+    [[nodiscard]] CircuitState getState() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mState;
+    }
+    /// @result The fraction of failed requests in the rolling window.
+    [[nodiscard]] double getErrorRate() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return getErrorRateUnlocked();
+    }
+    void setOpenDuration(const std::chrono::seconds &openDuration)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOpenDuration = openDuration;
+    }
+private:
+    [[nodiscard]] double getErrorRateUnlocked() const
+    {
+        if (mOutcomes.empty()){return 0;}
+        return static_cast<double> (mFailures)
+              /static_cast<double> (mOutcomes.size());
+    }
+    void open()
+    {
+        mState = CircuitState::Open;
+        mOpenedAt = std::chrono::steady_clock::now();
+    }
+    mutable std::mutex mMutex;
+    std::deque<bool> mOutcomes;
+    std::chrono::steady_clock::time_point mOpenedAt;
+    std::chrono::seconds mOpenDuration{30};
+    std::chrono::microseconds mSlowCallThreshold{30000000};
+    size_t mWindowSize{50};
+    size_t mMinimumNumberOfRequests{10};
+    size_t mFailures{0};
+    double mFailureRateThreshold{0.5};
+    CircuitState mState{CircuitState::Closed};
+    bool mProbeInFlight{false};
+};
+
+/// The outcome of a client's attempt at a hedged request
+struct HedgeOutcome
+{
+    Waveform waveform;
+    size_t client{0};
+    double percentComplete{0};
+};
+
+/// The state shared between a hedged request and the clients working on
+/// it.  This outlives the request if a losing client is still running.
+struct HedgedRequest
+{
+    std::mutex mutex;
+    std::condition_variable conditionVariable;
+    std::deque<HedgeOutcome> outcomes;
+    bool cancelled{false};
+};
+
 }
 
 class MultiClient::MultiClientImpl
 {
 public:
-    std::vector<std::pair<int, std::unique_ptr<IClient>>> mClients;
+    /// A client and what we have learned about it
+    struct Source
+    {
+        int priority{0};
+        std::unique_ptr<IClient> client{nullptr};
+        std::unique_ptr<::LatencyStatistics> latency{nullptr};
+        std::unique_ptr<::HealthMonitor> health{nullptr};
+        /// The hedge legs, including abandoned ones, still running
+        std::unique_ptr<std::atomic<int>> nHedgeLegs{nullptr};
+    };
+    ~MultiClientImpl()
+    {
+        // Abandoned hedges still reference the clients so let the pools
+        // drain before the clients are destroyed
+        mHedgeThreadPool = nullptr;
+        mThreadPool = nullptr;
+    }
+    /// Queries the source and records its latency and health
+    [[nodiscard]] Waveform query(const Source &source, const Request &request)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        Waveform waveform;
+        try
+        {
+            waveform = source.client->getData(request);
+        }
+        catch (...)
+        {
+            source.health->record(false, ::elapsed(startTime));
+            throw;
+        }
+        auto latency = ::elapsed(startTime);
+        source.latency->add(latency);
+        source.health->record(true, latency);
+        return waveform;
+    }
+    /// The next source at or after the index that is accepting requests
+    /// and has a hedge leg to spare.  A slot is reserved on the returned
+    /// source.  A client whose legs are all hung is skipped so that it
+    /// cannot tie up the workers the other clients need.
+    [[nodiscard]] size_t nextHedgeSource(size_t index)
+    {
+        for ( ; index < mClients.size(); ++index)
+        {
+            auto &nHedgeLegs = *mClients[index].nHedgeLegs;
+            if (nHedgeLegs.fetch_add(1) >= mMaximumNumberOfConcurrentRequests)
+            {
+                nHedgeLegs.fetch_sub(1);
+                spdlog::debug("Skipping client with too many requests in flight: "
+                            + mClients[index].client->getType());
+                continue;
+            }
+            if (mClients[index].health->allowRequest()){break;}
+            nHedgeLegs.fetch_sub(1);
+            spdlog::debug("Skipping client with open circuit: "
+                        + mClients[index].client->getType());
+        }
+        return index;
+    }
+    /// The time to wait on a source before hedging with the next one
+    [[nodiscard]] std::chrono::microseconds
+        getHedgeDelay(const Source &source) const
+    {
+        if (mHedgeDelay.count() > 0){return mHedgeDelay;}
+        return source.latency->getPercentile(mHedgePercentile,
+                                             mDefaultHedgeDelay);
+    }
+    /// Runs the source on the hedge thread pool.  The outcome is posted
+    /// to the shared state unless the request has already been decided.
+    /// The source's slot from nextHedgeSource() is released when the leg
+    /// finishes.  Each client has at most mMaximumNumberOfConcurrentRequests
+    /// legs and the pool has that many workers per client so a leg never
+    /// waits on another client's hung legs.
+    void launch(const size_t index,
+                const Request &request,
+                const std::shared_ptr<::HedgedRequest> &state)
+    {
+        getHedgeThreadPool().post([this, index, request, state]()
+        {
+            ::HedgeOutcome outcome;
+            outcome.client = index;
+            const auto &source = mClients[index];
+            try
+            {
+                outcome.waveform = query(source, request);
+                ::setIdentifiers(outcome.waveform, request);
+                outcome.percentComplete
+                    = ::percentComplete(outcome.waveform, request);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to request data from client: "
+                           + source.client->getType());
+                outcome.waveform = Waveform {};
+                outcome.percentComplete = 0;
+            }
+            source.nHedgeLegs->fetch_sub(1);
+            {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->cancelled)
+            {
+                state->outcomes.push_back(std::move(outcome));
+            }
+            }
+            state->conditionVariable.notify_all();
+        });
+    }
+    /// Launches the clients in priority order, starting the next one when
+    /// the current one fails, falls short, or exceeds its hedge delay.
+    /// The first sufficiently complete result wins and the rest are
+    /// abandoned.
+    [[nodiscard]] Waveform getHedgedData(const Request &request)
+    {
+        Waveform result;
+        auto nextSource = nextHedgeSource(0);
+        if (nextSource >= mClients.size()){return result;}
+        auto state = std::make_shared<::HedgedRequest> ();
+        double bestCompleteness{0};
+        size_t nLaunched{0};
+        size_t nFinished{0};
+        launch(nextSource, request, state);
+        auto nextLaunchTime = std::chrono::steady_clock::now()
+                            + getHedgeDelay(mClients[nextSource]);
+        nLaunched = nLaunched + 1;
+        nextSource = nextSource + 1;
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (nFinished < nLaunched)
+        {
+            bool launchNext{false};
+            if (state->outcomes.empty())
+            {
+                if (nextSource < mClients.size())
+                {
+                    state->conditionVariable.wait_until(
+                        lock, nextLaunchTime,
+                        [&state]{return !state->outcomes.empty();});
+                    // Hedge
+                    if (state->outcomes.empty()){launchNext = true;}
+                }
+                else
+                {
+                    state->conditionVariable.wait(
+                        lock,
+                        [&state]{return !state->outcomes.empty();});
+                }
+            }
+            while (!state->outcomes.empty())
+            {
+                auto outcome = std::move(state->outcomes.front());
+                state->outcomes.pop_front();
+                nFinished = nFinished + 1;
+                if (outcome.percentComplete >= mCompleteTolerance)
+                {
+                    spdlog::debug("Hedged request won by "
+                                + mClients[outcome.client].client->getType());
+                    state->cancelled = true;
+                    return std::move(outcome.waveform);
+                }
+                if (outcome.percentComplete > bestCompleteness)
+                {
+                    result = std::move(outcome.waveform);
+                    bestCompleteness = outcome.percentComplete;
+                }
+                // This client came up short so don't wait on the hedge delay
+                launchNext = true;
+            }
+            if (launchNext && nextSource < mClients.size())
+            {
+                lock.unlock();
+                nextSource = nextHedgeSource(nextSource);
+                if (nextSource < mClients.size())
+                {
+                    launch(nextSource, request, state);
+                    nextLaunchTime = std::chrono::steady_clock::now()
+                                   + getHedgeDelay(mClients[nextSource]);
+                    nLaunched = nLaunched + 1;
+                    nextSource = nextSource + 1;
+                }
+                lock.lock();
+            }
+        }
+        state->cancelled = true;
+        return result;
+    }
+    /// Hands the requests to the client's batched getData.  Clients that
+    /// batch (e.g., FDSN bounds its own concurrency and DataLink collects a
+    /// batch in one pass) get the whole vector in one call.  Otherwise, the
+    /// requests are split into contiguous chunks that run concurrently on
+    /// the thread pool.  A chunk that fails yields empty waveforms.
+    [[nodiscard]] std::vector<Waveform>
+        fanOut(const Source &source, const std::vector<Request> &requests)
+    {
+        std::vector<Waveform> result(requests.size());
+        auto getChunk = [&source, &requests, &result](const size_t i0,
+                                                      const size_t i1)
+        {
+            std::vector<Request> chunk(requests.begin() + i0,
+                                       requests.begin() + i1);
+            auto startTime = std::chrono::steady_clock::now();
+            try
+            {
+                auto waveforms = source.client->getData(chunk);
+                if (waveforms.size() != chunk.size())
+                {
+                    spdlog::warn("Client " + source.client->getType()
+                               + " returned the wrong number of waveforms");
+                    source.health->record(false, ::elapsed(startTime));
+                    return;
+                }
+                // Finding no data is not a failure.  The batched getData's
+                // throw when the whole chunk failed.
+                std::move(waveforms.begin(), waveforms.end(),
+                          result.begin() + i0);
+                source.health->record(true, ::elapsed(startTime));
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to request data from client: "
+                           + source.client->getType());
+                source.health->record(false, ::elapsed(startTime));
+            }
+        };
+        auto nChunks = std::min(requests.size(),
+                                static_cast<size_t> (mMaximumNumberOfConcurrentRequests));
+        if (nChunks < 2 || source.client->batchesRequests())
+        {
+            getChunk(0, requests.size());
+            return result;
+        }
+        auto& threadPool = getThreadPool();
+        std::vector<std::future<void>> futures;
+        futures.reserve(nChunks);
+        for (size_t iChunk = 0; iChunk < nChunks; ++iChunk)
+        {
+            auto i0 = (iChunk*requests.size())/nChunks;
+            auto i1 = ((iChunk + 1)*requests.size())/nChunks;
+            futures.push_back(threadPool.submit([&getChunk, i0, i1]()
+                                                {
+                                                    getChunk(i0, i1);
+                                                }));
+        }
+        for (auto &future : futures){future.get();}
+        return result;
+    }
+    /// The thread pool is created on first use
+    [[nodiscard]] ::ThreadPool &getThreadPool()
+    {
+        std::lock_guard<std::mutex> lock(mThreadPoolMutex);
+        if (!mThreadPool)
+        {
+            mThreadPool
+                = std::make_unique<::ThreadPool>
+                  (mMaximumNumberOfConcurrentRequests);
+        }
+        return *mThreadPool;
+    }
+    /// The hedge legs get their own pool so that slow, abandoned legs
+    /// cannot starve the batched requests.  There is a worker for each of
+    /// each client's hedge legs.
+    [[nodiscard]] ::ThreadPool &getHedgeThreadPool()
+    {
+        std::lock_guard<std::mutex> lock(mThreadPoolMutex);
+        if (!mHedgeThreadPool)
+        {
+            auto nClients = std::max(static_cast<int> (mClients.size()), 1);
+            mHedgeThreadPool
+                = std::make_unique<::ThreadPool>
+                  (mMaximumNumberOfConcurrentRequests*nClients);
+        }
+        return *mHedgeThreadPool;
+    }
+    /// Hands the outstanding requests to each client in priority order and
+    /// keeps the most complete waveform for each request.  This lets
+    /// clients that can batch (e.g., FDSN) fan the requests out.
+    void getBestData(const std::vector<Request> &requests,
+                     std::vector<Waveform> &bestWaveforms)
+    {
+        std::vector<double> bestCompleteness(requests.size(), 0);
+        std::vector<size_t> pending(requests.size());
+        std::iota(pending.begin(), pending.end(), 0);
+        for (const auto &source : mClients)
+        {
+            if (pending.empty()){break;}
+            if (!source.health->allowRequest()){continue;}
+            std::vector<Request> pendingRequests;
+            pendingRequests.reserve(pending.size());
+            for (const auto &index : pending)
+            {
+                pendingRequests.push_back(requests[index]);
+            }
+            auto sourceWaveforms = fanOut(source, pendingRequests);
+            std::vector<size_t> stillPending;
+            for (size_t k = 0; k < pending.size(); ++k)
+            {
+                auto index = pending[k];
+                try
+                {
+                    ::setIdentifiers(sourceWaveforms[k], requests[index]);
+                    auto percentComplete
+                        = ::percentComplete(sourceWaveforms[k], requests[index]);
+                    if (percentComplete > bestCompleteness[index])
+                    {
+                        bestWaveforms[index] = std::move(sourceWaveforms[k]);
+                        bestCompleteness[index] = percentComplete;
+                    }
+                    // Good enough to keep
+                    if (percentComplete >= mCompleteTolerance){continue;}
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to process waveform from client: "
+                               + source.client->getType());
+                }
+                stillPending.push_back(index);
+            }
+            pending = std::move(stillPending);
+        }
+    }
+    /// Fills the gaps in each waveform by asking each client, in priority
+    /// order, for only the intervals that are still missing.  Data from a
+    /// higher priority client is never overwritten.
+    void stitch(const std::vector<Request> &requests,
+                std::vector<Waveform> &waveforms)
+    {
+        for (const auto &source : mClients)
+        {
+            // Build the requests for the gaps
+            std::vector<Request> gapRequests;
+            std::vector<std::pair<size_t, ::Gap>> gapOwners;
+            for (size_t i = 0; i < requests.size(); ++i)
+            {
+                try
+                {
+                    for (const auto &gap : ::getGaps(waveforms[i], requests[i]))
+                    {
+                        auto gapRequest = requests[i];
+                        gapRequest.setStartAndEndTime(gap);
+                        gapRequests.push_back(std::move(gapRequest));
+                        gapOwners.push_back(std::pair {i, gap});
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to create gap requests; failed with: "
+                               + std::string {e.what()});
+                }
+            }
+            if (gapRequests.empty()){break;}
+            if (!source.health->allowRequest()){continue;}
+            auto slices = fanOut(source, gapRequests);
+            // Keep only the samples that fall in the gaps
+            for (size_t k = 0; k < slices.size(); ++k)
+            {
+                auto index = gapOwners[k].first;
+                const auto &gap = gapOwners[k].second;
+                auto includeStart = gap.first == requests[index].getStartTime();
+                auto includeEnd = gap.second == requests[index].getEndTime();
+                for (const auto &segment : slices[k])
+                {
+                    try
+                    {
+                        ::addTrimmedSegment(segment, gap,
+                                            includeStart, includeEnd,
+                                            waveforms[index]);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        spdlog::warn("Failed to stitch segment from client: "
+                                   + source.client->getType());
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            try
+            {
+                waveforms[i].mergeSegments();
+                ::setIdentifiers(waveforms[i], requests[i]);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to finalize stitched waveform; failed with: "
+                           + std::string {e.what()});
+            }
+        }
+    }
+    /// The health of each client in priority order
+    [[nodiscard]] std::vector<ClientHealth> getClientHealth() const
+    {
+        std::vector<ClientHealth> result;
+        result.reserve(mClients.size());
+        for (const auto &source : mClients)
+        {
+            ClientHealth health;
+            health.type = source.client->getType();
+            health.priority = source.priority;
+            health.state = source.health->getState();
+            health.errorRate = source.health->getErrorRate();
+            health.latency95
+                = source.latency->getPercentile(95,
+                                                std::chrono::microseconds {0});
+            result.push_back(std::move(health));
+        }
+        return result;
+    }
+    /// Logs each client's health if the logging interval has elapsed
+    void logClientHealth()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mHealthLogMutex);
+        auto now = std::chrono::steady_clock::now();
+        if (now < mLastHealthLog + mHealthLogInterval){return;}
+        mLastHealthLog = now;
+        }
+        for (const auto &health : getClientHealth())
+        {
+            std::string state{"closed"};
+            if (health.state == CircuitState::Open)
+            {
+                state = "open";
+            }
+            else if (health.state == CircuitState::HalfOpen)
+            {
+                state = "half-open";
+            }
+            auto message = "Client " + health.type
+                         + " (priority " + std::to_string(health.priority)
+                         + ") circuit is " + state
+                         + "; error rate is "
+                         + std::to_string(health.errorRate)
+                         + "; 95th percentile latency is "
+                         + std::to_string(health.latency95.count()*1.e-6)
+                         + " s";
+            if (health.state == CircuitState::Closed)
+            {
+                spdlog::info(message);
+            }
+            else
+            {
+                spdlog::warn(message);
+            }
+        }
+    }
+    /// True indicates the request's channel may have been operating
+    [[nodiscard]] bool mayHaveData(const ChannelEpochs *channelEpochs,
+                                   const Request &request) const
+    {
+        if (channelEpochs == nullptr){return true;}
+        try
+        {
+            return channelEpochs->mayHaveData(request);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::debug("Could not check channel epochs; failed with: "
+                        + std::string {e.what()});
+        }
+        return true;
+    }
+    std::vector<Source> mClients;
+    std::atomic<std::shared_ptr<const ChannelEpochs>> mChannelEpochs{nullptr};
+    std::unique_ptr<::ThreadPool> mThreadPool{nullptr};
+    std::unique_ptr<::ThreadPool> mHedgeThreadPool{nullptr};
+    std::mutex mThreadPoolMutex;
+    std::mutex mHealthLogMutex;
+    std::chrono::steady_clock::time_point mLastHealthLog;
+    std::chrono::seconds mHealthLogInterval{300};
+    std::chrono::microseconds mHedgeDelay{0};
+    std::chrono::microseconds mDefaultHedgeDelay{2000000};
+    double mHedgePercentile{95};
     double mCompleteTolerance{90};
+    std::chrono::seconds mCircuitOpenDuration{30};
+    int mMaximumNumberOfConcurrentRequests{8};
+    bool mHedge{false};
+    bool mStitch{false};
 };
 
 /// Constructor
@@ -118,61 +862,112 @@ MultiClient::MultiClient() :
 void MultiClient::insert(std::unique_ptr<IClient> &&client, int priority)
 {
     if (client == nullptr){throw std::invalid_argument("Clinet is null");}
-    pImpl->mClients.push_back(std::pair {priority, std::move(client)});
-    std::sort(pImpl->mClients.begin(), pImpl->mClients.end(),
-              [](const auto &lhs, const auto &rhs)
-              {
-                 return lhs.first > rhs.first;
-              }); 
+    MultiClientImpl::Source source;
+    source.priority = priority;
+    source.client = std::move(client);
+    source.latency = std::make_unique<::LatencyStatistics> ();
+    source.health
+        = std::make_unique<::HealthMonitor> (pImpl->mCircuitOpenDuration);
+    source.nHedgeLegs = std::make_unique<std::atomic<int>> (0);
+    // The hedge pool is sized by the number of clients
+    {
+    std::lock_guard<std::mutex> lock(pImpl->mThreadPoolMutex);
+    pImpl->mHedgeThreadPool = nullptr;
+    }
+    pImpl->mClients.push_back(std::move(source));
+    std::stable_sort(pImpl->mClients.begin(), pImpl->mClients.end(),
+                     [](const auto &lhs, const auto &rhs)
+                     {
+                        return lhs.priority > rhs.priority;
+                     });
 }
 
 /// Request data
 std::vector<Waveform>
 MultiClient::getData(const std::vector<Request> &requests) const
 {
-    std::vector<Waveform> result;
     // Create a unique set of requests
-    std::vector<std::pair<Request, Waveform>> filledRequests;
-    for (const auto &request: requests)
+    std::vector<Request> uniqueRequests;
+    std::vector<size_t> uniqueIndex(requests.size(), 0);
+    std::unordered_map<Request, size_t> requestToUniqueIndex;
+    requestToUniqueIndex.reserve(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i)
     {
-        bool found{false};
-        for (const auto &filledRequest : filledRequests)
+        auto [it, inserted]
+            = requestToUniqueIndex.try_emplace(requests[i],
+                                               uniqueRequests.size());
+        uniqueIndex[i] = it->second;
+        if (inserted)
         {
-            if (request == filledRequest.first)
-            {
-                spdlog::debug("Duplicate request; saving");
-                result.push_back(filledRequest.second);
-                found = true;
-                break;
-            }
+            uniqueRequests.push_back(requests[i]);
         }
-        if (!found)
+        else
         {
+            spdlog::debug("Duplicate request; saving");
+        }
+    }
+    // Skip the channels that were not operating during the request
+    auto channelEpochs = pImpl->mChannelEpochs.load();
+    std::vector<Request> plannedRequests;
+    std::vector<size_t> plannedIndex;
+    plannedRequests.reserve(uniqueRequests.size());
+    plannedIndex.reserve(uniqueRequests.size());
+    for (size_t index = 0; index < uniqueRequests.size(); ++index)
+    {
+        if (pImpl->mayHaveData(channelEpochs.get(), uniqueRequests[index]))
+        {
+            plannedRequests.push_back(uniqueRequests[index]);
+            plannedIndex.push_back(index);
+        }
+    }
+    if (plannedRequests.size() < uniqueRequests.size())
+    {
+        spdlog::debug("Skipping "
+                    + std::to_string(uniqueRequests.size()
+                                   - plannedRequests.size())
+                    + " requests for channels that were not operating");
+    }
+    std::vector<Waveform> plannedWaveforms(plannedRequests.size());
+    if (!plannedRequests.empty())
+    {
+        if (pImpl->mStitch)
+        {
+            pImpl->stitch(plannedRequests, plannedWaveforms);
+        }
+        else
+        {
+            pImpl->getBestData(plannedRequests, plannedWaveforms);
+        }
+    }
+    std::vector<Waveform> bestWaveforms(uniqueRequests.size());
+    for (size_t k = 0; k < plannedIndex.size(); ++k)
+    {
+        bestWaveforms[plannedIndex[k]] = std::move(plannedWaveforms[k]);
+    }
+    // Requests for which nothing was found get an empty waveform
+    for (size_t index = 0; index < uniqueRequests.size(); ++index)
+    {
+        if (bestWaveforms[index].getNumberOfSegments() == 0)
+        {
+            Waveform emptyWaveform;
             try
             {
-                auto waveform = getData(request);
-                result.push_back(waveform);
-                filledRequests.push_back(
-                    std::move(std::pair {request, std::move(waveform)}));
+                ::setIdentifiers(emptyWaveform, uniqueRequests[index]);
             }
             catch (const std::exception &e)
             {
-                spdlog::warn("Failed to get data for");
-                filledRequests.push_back(std::pair {request, Waveform {}});
-                Waveform emptyWaveform;
-                emptyWaveform.setNetwork(request.getNetwork());
-                emptyWaveform.setStation(request.getStation());
-                emptyWaveform.setChannel(request.getChannel());
-                if (request.haveLocationCode())
-                {
-                    emptyWaveform.setLocationCode(request.getLocationCode());
-                }
-                result.push_back(emptyWaveform);
-                filledRequests.push_back(
-                    std::move(std::pair {request, std::move(emptyWaveform)}));
+                spdlog::warn("Failed to get data for request");
             }
+            bestWaveforms[index] = std::move(emptyWaveform);
         }
     }
+    std::vector<Waveform> result;
+    result.reserve(requests.size());
+    for (const auto &index : uniqueIndex)
+    {
+        result.push_back(bestWaveforms[index]);
+    }
+    pImpl->logClientHealth();
     return result;
 }
 
@@ -180,32 +975,38 @@ MultiClient::getData(const std::vector<Request> &requests) const
 /// Get a waveform
 Waveform MultiClient::getData(const Request &request) const
 {
+    auto channelEpochs = pImpl->mChannelEpochs.load();
+    if (!pImpl->mayHaveData(channelEpochs.get(), request))
+    {
+        spdlog::debug("Skipping request for channel that was not operating");
+        Waveform emptyWaveform;
+        ::setIdentifiers(emptyWaveform, request);
+        return emptyWaveform;
+    }
+    if (pImpl->mStitch)
+    {
+        std::vector<Waveform> waveforms(1);
+        // Let the hedged request take the first pass
+        if (pImpl->mHedge){waveforms[0] = pImpl->getHedgedData(request);}
+        pImpl->stitch(std::vector<Request> {request}, waveforms);
+        pImpl->logClientHealth();
+        return std::move(waveforms[0]);
+    }
+    if (pImpl->mHedge)
+    {
+        auto waveform = pImpl->getHedgedData(request);
+        pImpl->logClientHealth();
+        return waveform;
+    }
     Waveform result;
     double bestCompleteness{0};
-    for (const auto &client : pImpl->mClients)
+    for (const auto &source : pImpl->mClients)
     {
+        if (!source.health->allowRequest()){continue;}
         try
         {
-            auto waveform = client.second->getData(request);
-            if (!waveform.haveNetwork())
-            {
-                waveform.setNetwork(request.getNetwork());
-            }
-            if (!waveform.haveStation())
-            {
-                waveform.setStation(request.getStation());
-            }
-            if (!waveform.haveChannel())
-            {
-                waveform.setChannel(request.getChannel());
-            }
-            if (!waveform.haveLocationCode())
-            {
-                if (request.haveLocationCode())
-                {
-                    waveform.setLocationCode(request.getLocationCode());
-                }
-            }
+            auto waveform = pImpl->query(source, request);
+            ::setIdentifiers(waveform, request);
             auto percentComplete = ::percentComplete(waveform, request); 
             // Good enough to keep
             if (percentComplete >= pImpl->mCompleteTolerance)
@@ -226,15 +1027,109 @@ Waveform MultiClient::getData(const Request &request) const
         catch (const std::exception &e)
         {
             spdlog::warn("Failed to request data from client: "
-                       + client.second->getType()); 
+                       + source.client->getType()); 
         } 
     }
+    pImpl->logClientHealth();
     return result;
 }
 
+/// Hedging
+void MultiClient::enableHedging(const std::chrono::milliseconds &hedgeDelay)
+{
+    if (hedgeDelay.count() < 0)
+    {
+        throw std::invalid_argument("Hedge delay must be non-negative");
+    }
+    pImpl->mHedgeDelay = hedgeDelay;
+    pImpl->mHedge = true;
+}
+
+void MultiClient::disableHedging() noexcept
+{
+    pImpl->mHedge = false;
+}
+
+bool MultiClient::isHedgingEnabled() const noexcept
+{
+    return pImpl->mHedge;
+}
+
+/// Concurrency
+void MultiClient::setMaximumNumberOfConcurrentRequests(const int nRequests)
+{
+    if (nRequests < 1)
+    {
+        throw std::invalid_argument("Number of requests must be positive");
+    }
+    std::lock_guard<std::mutex> lock(pImpl->mThreadPoolMutex);
+    pImpl->mMaximumNumberOfConcurrentRequests = nRequests;
+    pImpl->mThreadPool = nullptr;
+    pImpl->mHedgeThreadPool = nullptr;
+}
+
+int MultiClient::getMaximumNumberOfConcurrentRequests() const noexcept
+{
+    return pImpl->mMaximumNumberOfConcurrentRequests;
+}
+
+/// Health
+std::vector<MultiClient::ClientHealth> MultiClient::getClientHealth() const
+{
+    return pImpl->getClientHealth();
+}
+
+void MultiClient::setCircuitOpenDuration(
+    const std::chrono::seconds &openDuration)
+{
+    if (openDuration.count() < 0)
+    {
+        throw std::invalid_argument("Open duration must be non-negative");
+    }
+    pImpl->mCircuitOpenDuration = openDuration;
+    for (auto &source : pImpl->mClients)
+    {
+        source.health->setOpenDuration(openDuration);
+    }
+}
+
+std::chrono::seconds MultiClient::getCircuitOpenDuration() const noexcept
+{
+    return pImpl->mCircuitOpenDuration;
+}
+
+/// Stitching
+void MultiClient::enableStitching() noexcept
+{
+    pImpl->mStitch = true;
+}
+
+void MultiClient::disableStitching() noexcept
+{
+    pImpl->mStitch = false;
+}
+
+bool MultiClient::isStitchingEnabled() const noexcept
+{
+    return pImpl->mStitch;
+}
+
+/// Channel epochs
+void MultiClient::setChannelEpochs(
+    const std::shared_ptr<const ChannelEpochs> &channelEpochs) noexcept
+{
+    pImpl->mChannelEpochs.store(channelEpochs);
+}
+
 /// Destructor
 MultiClient::~MultiClient() = default;
 
+/// Batching
+bool MultiClient::batchesRequests() const noexcept
+{
+    return true;
+}
+
 /// Type
 std::string MultiClient::getType() const noexcept
 {
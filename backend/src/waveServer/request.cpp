@@ -267,3 +267,34 @@ bool MLReview::WaveServer::operator!=(const Request &lhs, const Request &rhs)
 {
     return !(lhs == rhs);
 }
+
+/// Hash
+size_t std::hash<MLReview::WaveServer::Request>::operator()(
+    const MLReview::WaveServer::Request &request) const noexcept
+{
+    // Combine as in boost::hash_combine
+    size_t seed{0};
+    auto combine = [&seed](const size_t value)
+    {
+        seed ^= value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+    };
+    std::hash<std::string> stringHash;
+    std::hash<int64_t> timeHash;
+    if (request.haveNetwork()){combine(stringHash(request.getNetwork()));}
+    combine(0);
+    if (request.haveStation()){combine(stringHash(request.getStation()));}
+    combine(0);
+    if (request.haveChannel()){combine(stringHash(request.getChannel()));}
+    combine(0);
+    if (request.haveLocationCode())
+    {
+        combine(stringHash(request.getLocationCode()));
+    }
+    combine(0);
+    if (request.haveStartAndEndTime())
+    {
+        combine(timeHash(request.getStartTime().count()));
+        combine(timeHash(request.getEndTime().count()));
+    }
+    return seed;
+}
@@ -0,0 +1,395 @@
+#include <string>
+#include <array>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <libdali.h>
+#include <spdlog/spdlog.h>
+#include "mlReview/waveServer/ringBuffer.hpp"
+#include "mlReview/waveServer/request.hpp"
+#include "mlReview/waveServer/waveform.hpp"
+#include "unpackMiniSEED3.hpp"
+#include "streamIdentifier.hpp"
+
+#define TYPE "RingBuffer"
+
+using namespace MLReview::WaveServer;
+
+namespace
+{
+
+dltime_t now()
+{
+    auto now = std::chrono::system_clock::now();
+    return static_cast<dltime_t>
+           (std::chrono::duration_cast<std::chrono::microseconds>
+               (now.time_since_epoch()).count());
+}
+
+/// A miniSEED record as it arrived from the server.  The records are kept
+/// compressed and are only decoded when requested.
+struct Record
+{
+    dltime_t startTime{0};
+    dltime_t endTime{0};
+    std::vector<char> data;
+};
+
+/// @brief The buffered records for a single stream sorted by start time.
+class Stream
+{
+public:
+    /// @brief Adds a record then evicts the records that are older than
+    ///        the retention duration.
+    void insert(const DLPacket &packet, const char *data,
+                const dltime_t duration)
+    {
+        Record record{packet.datastart,
+                      packet.dataend,
+                      std::vector<char> (data, data + packet.datasize)};
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLatestDataTime = std::max(mLatestDataTime, record.endTime);
+        // Packets almost always arrive in order
+        if (mRecords.empty() || record.startTime > mRecords.back().startTime)
+        {
+            mRecords.push_back(std::move(record));
+        }
+        else
+        {
+            auto it = std::lower_bound(mRecords.begin(), mRecords.end(),
+                                       record.startTime,
+                                       [](const Record &lhs,
+                                          const dltime_t startTime)
+                                       {
+                                           return lhs.startTime < startTime;
+                                       });
+            // Repositioning after a reconnect can replay records
+            if (it != mRecords.end() && it->startTime == record.startTime)
+            {
+                return;
+            }
+            mRecords.insert(it, std::move(record));
+        }
+        auto oldestTime = mRecords.back().endTime - duration;
+        while (!mRecords.empty() && mRecords.front().endTime < oldestTime)
+        {
+            mRecords.pop_front();
+        }
+    }
+    /// @result The concatenated records that overlap the window.
+    [[nodiscard]] std::vector<char> query(const dltime_t startTime,
+                                          const dltime_t endTime) const
+    {
+        std::vector<char> result;
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto first = std::partition_point(mRecords.begin(), mRecords.end(),
+                                          [=](const Record &record)
+                                          {
+                                              return record.endTime < startTime;
+                                          });
+        for (auto it = first; it != mRecords.end(); ++it)
+        {
+            if (it->startTime > endTime){break;}
+            result.insert(result.end(), it->data.begin(), it->data.end());
+        }
+        return result;
+    }
+    /// @result The end time of the newest record received for the stream.
+    [[nodiscard]] dltime_t getLatestDataTime() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mLatestDataTime;
+    }
+private:
+    mutable std::mutex mMutex;
+    std::deque<Record> mRecords;
+    dltime_t mLatestDataTime{std::numeric_limits<dltime_t>::lowest()};
+};
+
+}
+
+class RingBuffer::RingBufferImpl
+{
+public:
+    RingBufferImpl(const std::string &url,
+                   const std::string &matchPattern,
+                   const std::chrono::seconds &duration,
+                   const std::string &clientName) :
+        mURL(url),
+        mMatchPattern(matchPattern),
+        mClientName(clientName),
+        mDuration(std::chrono::duration_cast<std::chrono::microseconds>
+                  (duration).count())
+    {
+    }
+    ~RingBufferImpl()
+    {
+        stop();
+    }
+    void disconnect()
+    {
+        if (mDataLinkClient)
+        {
+            if (mDataLinkClient->link != -1){dl_disconnect(mDataLinkClient);}
+            dl_freedlcp(mDataLinkClient);
+            mDataLinkClient = nullptr;
+        }
+        mConnected = false;
+    }
+    /// (Re)subscribes to the server.  The stream resumes from the stream
+    /// that is furthest behind so that no gap is left by a reconnect.  The
+    /// streams that are further along drop the records they replay.
+    void connect()
+    {
+        disconnect();
+        auto urlCopy = mURL;
+        auto clientNameCopy = mClientName;
+        mDataLinkClient = dl_newdlcp(urlCopy.data(), clientNameCopy.data());
+        if (mDataLinkClient == nullptr)
+        {
+            throw std::runtime_error("Failed to create DataLink client");
+        }
+        mDataLinkClient->keepalive = 30;
+        if (dl_connect(mDataLinkClient) < 0)
+        {
+            disconnect();
+            throw std::runtime_error("Failed to connect to DataLink server at "
+                                   + mURL);
+        }
+        auto pattern = mMatchPattern;
+        if (dl_match(mDataLinkClient, pattern.data()) < 0)
+        {
+            disconnect();
+            throw std::runtime_error("Failed to set match pattern: "
+                                   + mMatchPattern);
+        }
+        auto startTime = std::max(::now() - mDuration,
+                                  getOldestLatestDataTime());
+        if (dl_position_after(mDataLinkClient, startTime) < 0)
+        {
+            disconnect();
+            throw std::runtime_error("Failed to position client");
+        }
+        mConnected = true;
+        spdlog::info("Ring buffer subscribed to " + mMatchPattern
+                   + " on " + mURL);
+    }
+    /// Adds a packet to its stream's buffer
+    void insert(const DLPacket &packet)
+    {
+        if (packet.datasize <= 0){return;}
+        std::shared_ptr<::Stream> stream;
+        std::string streamIdentifier{packet.streamid};
+        {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        auto it = mStreams.find(streamIdentifier);
+        if (it != mStreams.end()){stream = it->second;}
+        }
+        if (!stream)
+        {
+            std::unique_lock<std::shared_mutex> lock(mStreamsMutex);
+            auto it = mStreams.find(streamIdentifier);
+            if (it == mStreams.end())
+            {
+                it = mStreams.insert(
+                         std::pair {streamIdentifier,
+                                    std::make_shared<::Stream> ()}).first;
+            }
+            stream = it->second;
+        }
+        stream->insert(packet, mBuffer.data(), mDuration);
+    }
+    /// @result The earliest of the streams' newest data times.  Stations
+    ///         report with different latencies so the streams are not all
+    ///         caught up to the same time.
+    [[nodiscard]] dltime_t getOldestLatestDataTime() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        if (mStreams.empty()){return 0;}
+        auto result = std::numeric_limits<dltime_t>::max();
+        for (const auto &stream : mStreams)
+        {
+            result = std::min(result, stream.second->getLatestDataTime());
+        }
+        return result;
+    }
+    /// Waits for the given time or until stopped
+    void wait(const std::chrono::milliseconds &duration)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConditionVariable.wait_for(lock, duration,
+                                    [this]
+                                    {
+                                        return !mKeepRunning;
+                                    });
+    }
+    /// Reads packets from the server until stopped
+    void subscribe()
+    {
+        constexpr std::chrono::milliseconds noPacketWait{100};
+        constexpr std::chrono::seconds reconnectWait{5};
+        spdlog::info("Beginning ring buffer subscription...");
+        DLPacket dataLinkPacket;
+        while (mKeepRunning)
+        {
+            if (!mConnected)
+            {
+                try
+                {
+                    connect();
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn(std::string {e.what()}
+                               + "; retrying in "
+                               + std::to_string(reconnectWait.count()) + " s");
+                    wait(reconnectWait);
+                    continue;
+                }
+            }
+            auto returnCode = dl_collect_nb(mDataLinkClient,
+                                            &dataLinkPacket,
+                                            mBuffer.data(),
+                                            mBuffer.size(),
+                                            0);
+            if (returnCode == DLPACKET)
+            {
+                insert(dataLinkPacket);
+            }
+            else if (returnCode == DLNOPACKET)
+            {
+                wait(noPacketWait);
+            }
+            else
+            {
+                spdlog::warn("Ring buffer subscription interrupted; reconnecting");
+                disconnect();
+            }
+        }
+        disconnect();
+        spdlog::info("Ending ring buffer subscription");
+    }
+    void start()
+    {
+        stop();
+        mKeepRunning = true;
+        mSubscriptionThread = std::thread(&RingBufferImpl::subscribe, this);
+    }
+    void stop()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mKeepRunning = false;
+        }
+        mConditionVariable.notify_all();
+        if (mSubscriptionThread.joinable()){mSubscriptionThread.join();}
+    }
+    [[nodiscard]] std::shared_ptr<::Stream>
+        getStream(const std::string &streamIdentifier) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        auto it = mStreams.find(streamIdentifier);
+        if (it == mStreams.end()){return nullptr;}
+        return it->second;
+    }
+//private:
+    mutable std::shared_mutex mStreamsMutex;
+    std::unordered_map<std::string, std::shared_ptr<::Stream>> mStreams;
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::thread mSubscriptionThread;
+    std::array<char, MAXPACKETSIZE> mBuffer;
+    std::string mURL;
+    std::string mMatchPattern;
+    std::string mClientName{"RingBufferClient"};
+    DLCP *mDataLinkClient{nullptr};
+    dltime_t mDuration{3600000000};
+    std::atomic<bool> mConnected{false};
+    std::atomic<bool> mKeepRunning{false};
+};
+
+/// Constructor
+RingBuffer::RingBuffer(const std::string &url,
+                       const std::string &matchPattern,
+                       const std::chrono::seconds &duration,
+                       const std::string &clientName)
+{
+    if (url.empty()){throw std::invalid_argument("URL is empty");}
+    if (matchPattern.empty())
+    {
+        throw std::invalid_argument("Match pattern is empty");
+    }
+    if (duration.count() <= 0)
+    {
+        throw std::invalid_argument("Duration must be positive");
+    }
+    if (clientName.empty()){throw std::invalid_argument("clientName is empty");}
+    pImpl = std::make_unique<RingBufferImpl> (url, matchPattern,
+                                              duration, clientName);
+    pImpl->start();
+}
+
+/// Gets the data
+Waveform RingBuffer::getData(const Request &request) const
+{
+    Waveform result;
+    auto streamIdentifier = ::toStreamIdentifier(request);
+    auto stream = pImpl->getStream(streamIdentifier);
+    if (stream == nullptr)
+    {
+        spdlog::debug("Stream: " + streamIdentifier + " not in ring buffer");
+        return result;
+    }
+    auto startTime = static_cast<dltime_t> (request.getStartTime().count());
+    auto endTime = static_cast<dltime_t> (request.getEndTime().count());
+    auto packetData = stream->query(startTime, endTime);
+    if (packetData.empty()){return result;}
+    try
+    {
+        result = ::unpack(packetData.data(), packetData.size());
+        result.mergeSegments();
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error("Failed to create waveform; failed with: "
+                               + std::string {e.what()});
+    }
+    return result;
+}
+
+/// Connected?
+bool RingBuffer::isConnected() const noexcept
+{
+    return pImpl->mConnected;
+}
+
+/// Duration
+std::chrono::seconds RingBuffer::getDuration() const noexcept
+{
+    return std::chrono::duration_cast<std::chrono::seconds>
+           (std::chrono::microseconds {pImpl->mDuration});
+}
+
+/// Number of streams
+int RingBuffer::getNumberOfStreams() const noexcept
+{
+    std::shared_lock<std::shared_mutex> lock(pImpl->mStreamsMutex);
+    return static_cast<int> (pImpl->mStreams.size());
+}
+
+/// Type
+std::string RingBuffer::getType() const noexcept
+{
+    return TYPE;
+}
+
+/// Destructor
+RingBuffer::~RingBuffer() = default;
@@ -372,3 +372,7 @@ template void MLReview::WaveServer::Segment::getData(std::vector<double> *data)
 template void MLReview::WaveServer::Segment::getData(std::vector<float> *data) const;
 template void MLReview::WaveServer::Segment::getData(std::vector<int> *data) const;
 template void MLReview::WaveServer::Segment::getData(std::vector<int64_t> *data) const;
+template std::vector<double> MLReview::WaveServer::Segment::getData<double> () const;
+template std::vector<float> MLReview::WaveServer::Segment::getData<float> () const;
+template std::vector<int> MLReview::WaveServer::Segment::getData<int> () const;
+template std::vector<int64_t> MLReview::WaveServer::Segment::getData<int64_t> () const;
@@ -0,0 +1,62 @@
+#ifndef STREAM_IDENTIFIER_HPP
+#define STREAM_IDENTIFIER_HPP
+#include <string>
+#include <stdexcept>
+#include "mlReview/waveServer/request.hpp"
+namespace
+{
+
+/// Escapes the regular expression metacharacters in a stream identifier
+std::string escapeRegex(const std::string &input)
+{
+    std::string result;
+    result.reserve(input.size());
+    for (const auto &c : input)
+    {
+        if (std::string {".^$|()[]{}*+?\\"}.find(c) != std::string::npos)
+        {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    return result;
+}
+
+/// Creates the DataLink stream identifier for a request - e.g.,
+/// UU_CTU_01_HHZ/MSEED
+std::string toStreamIdentifier(const MLReview::WaveServer::Request &request)
+{
+    if (!request.haveNetwork())
+    {
+        throw std::invalid_argument("Network not set");
+    }
+    if (!request.haveStation())
+    {
+        throw std::invalid_argument("Station not set");
+    }
+    if (!request.haveChannel())
+    {
+        throw std::invalid_argument("Channel not set");
+    }
+    if (!request.haveStartAndEndTime())
+    {
+        throw std::invalid_argument("Start and end time not set");
+    }
+    std::string locationCode;
+    if (request.haveLocationCode())
+    {
+        locationCode = request.getLocationCode();
+        if (locationCode == "--"){locationCode = "";}
+    }
+    return request.getNetwork()
+         + "_"
+         + request.getStation()
+         + "_"
+         + locationCode
+         + "_"
+         + request.getChannel()
+         + "/MSEED";
+}
+
+}
+#endif
@@ -11,8 +11,87 @@
 #include "mlReview/waveServer/segment.hpp"
 namespace
 {
-[[nodiscard]] 
-MLReview::WaveServer::Waveform unpack(char *data, size_t dataLength,
+
+/// Adds the parsed record to the waveform.  If isFirst is true then the
+/// waveform's identifiers are set from the record and isFirst is set to false.
+void unpackRecord(const MS3Record *msr,
+                  MLReview::WaveServer::Waveform &result,
+                  bool &isFirst)
+{
+    // Waveform name
+    std::array<char, 64> networkWork, stationWork, channelWork, locationCodeWork;
+    std::fill(networkWork.begin(), networkWork.end(), '\0');
+    std::fill(stationWork.begin(), stationWork.end(), '\0');
+    std::fill(channelWork.begin(), channelWork.end(), '\0');
+    std::fill(locationCodeWork.begin(), locationCodeWork.end(), '\0');
+    auto returnCode
+        = ms_sid2nslc(msr->sid,
+                      networkWork.data(), stationWork.data(),
+                      locationCodeWork.data(), channelWork.data());
+    if (returnCode != MS_NOERROR)
+    {
+        throw std::runtime_error("Could not unpack sid");
+    }
+    // Copy waveform identification information
+    if (isFirst)
+    {
+        try
+        {
+            result.setNetwork(std::string {networkWork.data()});
+            result.setStation(std::string {stationWork.data()});
+            result.setChannel(std::string {channelWork.data()});
+            result.setLocationCode(
+                std::string {locationCodeWork.data()});
+            isFirst = false;
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error(
+                "Couldn't set waveform identifier information; failed with: "
+              + std::string {e.what()});
+        }
+    }
+    auto startTime = static_cast<double> (msr->starttime)/NSTMODULUS;
+    double samplingRate{msr->samprate};
+    // Data
+    auto nSamples = static_cast<int> (msr->numsamples);
+    // Finally get the data
+    MLReview::WaveServer::Segment::DataType dataType;
+    if (msr->sampletype == 'i')
+    {
+        dataType = MLReview::WaveServer::Segment::DataType::Integer32;
+    }
+    else if (msr->sampletype == 'f')
+    {
+        dataType = MLReview::WaveServer::Segment::DataType::Float;
+    }
+    else if (msr->sampletype == 'd')
+    {
+        dataType = MLReview::WaveServer::Segment::DataType::Double;
+    }
+    else
+    {
+        spdlog::warn("Unhandled data format: "
+                   + std::string {msr->sampletype} + "; skipping...");
+        return;
+    }
+    try
+    {
+        MLReview::WaveServer::Segment segment;
+        segment.setStartTime(startTime);
+        segment.setSamplingRate(samplingRate);
+        segment.setData(msr->datasamples, nSamples, dataType);
+        result.addSegment(std::move(segment));
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::warn("Failed to create segment.  Failed with "
+                   + std::string {e.what()});
+    }
+}
+
+[[nodiscard]]
+MLReview::WaveServer::Waveform unpack(const char *data, size_t dataLength,
                                       const int8_t verbose = 0)
 {
     MLReview::WaveServer::Waveform result;
@@ -28,87 +107,14 @@ MLReview::WaveServer::Waveform unpack(char *data, size_t dataLength,
                          &msr, MSF_UNPACKDATA, verbose);
         if (returnCode == MS_NOERROR && msr)
         {
-            // Waveform name
-            std::array<char, 64> networkWork, stationWork, channelWork, locationCodeWork;
-            std::fill(networkWork.begin(), networkWork.end(), '\0');
-            std::fill(stationWork.begin(), stationWork.end(), '\0');
-            std::fill(channelWork.begin(), channelWork.end(), '\0');
-            std::fill(locationCodeWork.begin(), locationCodeWork.end(), '\0');
-            returnCode
-                = ms_sid2nslc(msr->sid,
-                              networkWork.data(), stationWork.data(),
-                              locationCodeWork.data(), channelWork.data());
-            if (returnCode != MS_NOERROR)
-            {
-                if (msr){msr3_free(&msr);}
-                throw std::runtime_error("Could not unpack sid");
-            }
-            // Copy waveform identification information
-            if (isFirst)
-            {
-                try
-                {
-                    result.setNetwork(std::string {networkWork.data()});
-                    result.setStation(std::string {stationWork.data()});
-                    result.setChannel(std::string {channelWork.data()});
-                    result.setLocationCode(
-                        std::string {locationCodeWork.data()});
-                    isFirst = false;
-                }
-                catch (const std::exception &e)
-                {
-                    if (msr)
-                    {
-                        msr3_free(&msr);
-                        msr = nullptr;
-                    }
-                    throw std::runtime_error(
-                        "Couldn't set waveform identifier information; failed with: "
-                      + std::string {e.what()});
-                }
-            }
-            auto startTime = static_cast<double> (msr->starttime)/NSTMODULUS;
-            double samplingRate{msr->samprate};
-            // Data
-            auto nSamples = static_cast<int> (msr->numsamples);
-            // Finally get the data
-            MLReview::WaveServer::Segment::DataType dataType;
-            if (msr->sampletype == 'i')
-            {
-                dataType = MLReview::WaveServer::Segment::DataType::Integer32;
-            }
-            else if (msr->sampletype == 'f')
-            {
-                dataType = MLReview::WaveServer::Segment::DataType::Float;
-            }
-            else if (msr->sampletype == 'd')
-            {
-                dataType = MLReview::WaveServer::Segment::DataType::Double;
-            }
-            else
-            {
-                spdlog::warn("Unhandled data format: "
-                           + std::string {msr->sampletype} + "; skipping...");
-                if (msr)
-                {
-                    msr3_free(&msr);
-                    msr = nullptr;
-                }
-                offset = offset + msr->reclen;
-                continue;
-            }
             try
             {
-                MLReview::WaveServer::Segment segment;
-                segment.setStartTime(startTime);
-                segment.setSamplingRate(samplingRate); 
-                segment.setData(msr->datasamples, nSamples, dataType);
-                result.addSegment(std::move(segment));
+                ::unpackRecord(msr, result, isFirst);
             }
-            catch (const std::exception &e)
+            catch (...)
             {
-                spdlog::warn("Failed to create segment.  Failed with "
-                           + std::string {e.what()});
+                msr3_free(&msr);
+                throw;
             }
             offset = offset + msr->reclen;
         } // End check on have record and no error
@@ -127,10 +133,96 @@ MLReview::WaveServer::Waveform unpack(char *data, size_t dataLength,
 MLReview::WaveServer::Waveform unpack(const std::string &data,
                                       const int8_t verbose = 0)
 {
-    auto copy = data;
-    auto bufferLength = static_cast<uint64_t> (data.size());    
-    return ::unpack(copy.data(), bufferLength);
+    return ::unpack(data.data(), data.size(), verbose);
 }
 
+/// @brief Incrementally assembles miniSEED records from a byte stream
+///        (e.g., the body of an HTTP response) and decodes each record as
+///        soon as it is complete.  Only the trailing partial record is
+///        ever buffered.
+class MiniSEEDAssembler
+{
+public:
+    /// @brief Appends the next chunk of the stream and decodes any records
+    ///        that are now complete.
+    void append(const char *data, const size_t dataLength)
+    {
+        if (mFailed || dataLength == 0){return;}
+        mBuffer.insert(mBuffer.end(), data, data + dataLength);
+        decode();
+    }
+    /// @result The waveform assembled from all complete records.  Segments
+    ///         are merged.  On exit the assembler is reset.
+    [[nodiscard]] MLReview::WaveServer::Waveform finish()
+    {
+        if (!mFailed && mBuffer.size() > mOffset)
+        {
+            spdlog::debug("Discarding "
+                        + std::to_string(mBuffer.size() - mOffset)
+                        + " bytes of incomplete miniSEED record");
+        }
+        auto result = std::move(mWaveform);
+        result.mergeSegments();
+        clear();
+        return result;
+    }
+    /// @brief Resets the assembler.
+    void clear() noexcept
+    {
+        mWaveform = MLReview::WaveServer::Waveform {};
+        mBuffer.clear();
+        mOffset = 0;
+        mIsFirst = true;
+        mFailed = false;
+    }
+private:
+    void decode()
+    {
+        while (mBuffer.size() - mOffset > MINRECLEN)
+        {
+            MS3Record *msr{nullptr};
+            auto returnCode
+                = msr3_parse(mBuffer.data() + mOffset,
+                             static_cast<uint64_t> (mBuffer.size() - mOffset),
+                             &msr, MSF_UNPACKDATA, 0);
+            if (returnCode == MS_NOERROR && msr)
+            {
+                try
+                {
+                    ::unpackRecord(msr, mWaveform, mIsFirst);
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to unpack record; failed with: "
+                               + std::string {e.what()});
+                }
+                mOffset = mOffset + static_cast<size_t> (msr->reclen);
+                msr3_free(&msr);
+                continue;
+            }
+            if (msr){msr3_free(&msr);}
+            // Positive values indicate more data is required
+            if (returnCode > 0){break;}
+            spdlog::warn("Failed to parse miniSEED stream; ignoring remainder");
+            mFailed = true;
+            mBuffer.clear();
+            mOffset = 0;
+            return;
+        }
+        // Drop the consumed records
+        if (mOffset > 0)
+        {
+            mBuffer.erase(mBuffer.begin(),
+                          mBuffer.begin() + static_cast<std::ptrdiff_t> (mOffset));
+            mOffset = 0;
+        }
+    }
+    MLReview::WaveServer::Waveform mWaveform;
+    std::vector<char> mBuffer;
+    size_t mOffset{0};
+    bool mIsFirst{true};
+    bool mFailed{false};
+};
+
 }
 #endif
@@ -0,0 +1,74 @@
+#ifndef GENERATED_BODY_HPP
+#define GENERATED_BODY_HPP
+#include <string>
+#include <optional>
+#include <functional>
+#include <spdlog/spdlog.h>
+#include <boost/optional.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+namespace
+{
+
+/// @brief An HTTP body whose contents are produced as they are written.
+///        The body is a function that returns the next piece of the body
+///        and nothing when the body is complete.  This lets a response be
+///        sent, with chunked encoding, without ever holding all of it in
+///        memory.
+struct GeneratedBody
+{
+    using value_type = std::function<std::optional<std::string> ()>;
+
+    class writer
+    {
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template<bool isRequest, class Fields>
+        explicit writer(const boost::beast::http::header<isRequest, Fields> &,
+                        const value_type &body) :
+            mBody(body)
+        {
+        }
+
+        void init(boost::beast::error_code &errorCode)
+        {
+            errorCode = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>>
+            get(boost::beast::error_code &errorCode)
+        {
+            errorCode = {};
+            if (!mBody){return boost::none;}
+            // An empty chunk would end the body so skip empty pieces
+            while (true)
+            {
+                std::optional<std::string> piece;
+                try
+                {
+                    piece = mBody();
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::error("Failed to generate response body: "
+                                + std::string {e.what()});
+                    errorCode = boost::beast::errc::make_error_code(
+                                    boost::beast::errc::io_error);
+                    return boost::none;
+                }
+                if (!piece){return boost::none;}
+                if (piece->empty()){continue;}
+                mPiece = std::move(*piece);
+                return {{const_buffers_type {mPiece.data(), mPiece.size()},
+                         true}};
+            }
+        }
+    private:
+        value_type mBody;
+        std::string mPiece;
+    };
+};
+
+}
+#endif
@@ -217,7 +217,7 @@ createCORSResponse(
     result.set(boost::beast::http::field::access_control_allow_methods,
                "GET,HEAD,OPTIONS,POST,PUT");
     result.set(boost::beast::http::field::access_control_allow_headers,
-               "Access-Control-Allow-Origin, Access-Control-Allow-Headers, Access-Control-Allow-Methods, Connection, Origin, Accept, X-Requested-With, Content-Type, Access-Control-Request-Method, Access-Control-Request-Headers, Authorization");
+               "Access-Control-Allow-Origin, Access-Control-Allow-Headers, Access-Control-Allow-Methods, Connection, Origin, Accept, X-Requested-With, Content-Type, Access-Control-Request-Method, Access-Control-Request-Headers, Authorization, If-None-Match");
     //result.set(boost::beast::http::field::access_control_max_age,
     //           "3600");
     result.set(boost::beast::http::field::connection, //"Connection",
@@ -2,6 +2,10 @@
 #define SERVER_HPP
 #include <iostream>
 #include <queue>
+#include <map>
+#include <vector>
+#include <optional>
+#include <nlohmann/json.hpp>
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/signal_set.hpp>
@@ -21,7 +25,9 @@
 #include "mlReview/messages/message.hpp"
 #include "mlReview/messages/error.hpp"
 #include "responses.hpp"
+#include "generatedBody.hpp"
 #include "authorized.hpp"
+#include "subscribed.hpp"
 #include "base64.hpp"
 #include <boost/algorithm/string.hpp>
 
@@ -30,6 +36,37 @@
 namespace
 {
 
+// True indicates the If-None-Match header lists the ETag.  The header is
+// a comma-separated list of quoted, possibly weak, tags or *.
+bool matchesETag(const std::string &ifNoneMatch, const std::string &eTag)
+{
+    std::vector<std::string> tags;
+    boost::algorithm::split(tags, ifNoneMatch, boost::is_any_of(","));
+    for (auto &tag : tags)
+    {
+        boost::algorithm::trim(tag);
+        if (tag == "*"){return true;}
+        if (tag.starts_with("W/")){tag = tag.substr(2);}
+        if (tag == "\"" + eTag + "\""){return true;}
+    }
+    return false;
+}
+
+// True indicates the request asks for an export.  Exports are streamed
+// over HTTP as they are read from the database; a WebSocket reply would
+// have to hold the entire export in memory.
+bool isExportRequest(const std::string &requestMessage)
+{
+    auto object = nlohmann::json::parse(requestMessage, nullptr, false);
+    if (object.is_discarded() || !object.is_object() ||
+        !object.contains("export"))
+    {
+        return false;
+    }
+    return object["export"].is_boolean() &&
+           object["export"].template get<bool> ();
+}
+
 // The concrete type of the response message (which depends on the
 // request), is type-erased in message_generator.
 template <class Body, class Allocator>
@@ -44,7 +81,22 @@ handleRequest(
     std::shared_ptr<MLReview::Service::Handler> &callbackHandler)
 {
 
-    const auto successResponse = [&request](const std::string &payload)
+    // Tagged responses must be revalidated before a cached copy is used
+    const auto setETag = [](auto &result,
+                            const std::optional<std::string> &eTag)
+    {
+        if (!eTag){return;}
+        result.set(boost::beast::http::field::etag, "\"" + *eTag + "\"");
+        result.set(boost::beast::http::field::cache_control, "no-cache");
+#ifdef ENABLE_CORS
+        result.set(boost::beast::http::field::access_control_expose_headers,
+                   "ETag");
+#endif
+    };
+
+    const auto successResponse = [&request, &setETag](
+        const std::string &payload,
+        const std::optional<std::string> &eTag = std::nullopt)
     {
         spdlog::info("Success: Message response size: "
                    + std::to_string (payload.size()));
@@ -60,12 +112,60 @@ handleRequest(
                    BOOST_BEAST_VERSION_STRING);
         result.set(boost::beast::http::field::content_type,
                    "application/json");
+        setETag(result, eTag);
         result.keep_alive(request.keep_alive());
         result.body() = payload;
         result.prepare_payload();
         return result;
     };
 
+    // Sends the message as it is generated
+    const auto streamedResponse
+        = [&request, &setETag](
+              std::function<std::optional<std::string> ()> &&payload,
+              const std::optional<std::string> &eTag)
+    {
+        spdlog::info("Success: Streaming message response");
+        boost::beast::http::response<::GeneratedBody> result
+        {
+            boost::beast::http::status::ok,
+            request.version()
+        };
+#ifdef ENABLE_CORS
+        result.set(boost::beast::http::field::access_control_allow_origin, "*");
+#endif
+        result.set(boost::beast::http::field::server,
+                   BOOST_BEAST_VERSION_STRING);
+        result.set(boost::beast::http::field::content_type,
+                   "application/json");
+        setETag(result, eTag);
+        result.body() = std::move(payload);
+        // Without chunking the end of the body is the end of the connection
+        result.keep_alive(request.keep_alive() && request.version() == 11);
+        result.prepare_payload();
+        return result;
+    };
+
+    // The client already has this version of the data
+    const auto notModified = [&request, &setETag](const std::string &eTag)
+    {
+        spdlog::debug("Not modified: " + eTag);
+        boost::beast::http::response<boost::beast::http::empty_body> result
+        {
+            boost::beast::http::status::not_modified,
+            request.version()
+        };
+#ifdef ENABLE_CORS
+        result.set(boost::beast::http::field::access_control_allow_origin, "*");
+#endif
+        result.set(boost::beast::http::field::server,
+                   BOOST_BEAST_VERSION_STRING);
+        setETag(result, eTag);
+        result.keep_alive(request.keep_alive());
+        result.prepare_payload();
+        return result;
+    };
+
     const auto badRequest = [&request](boost::beast::string_view why)
     {
         spdlog::info("Bad request");
@@ -131,7 +231,7 @@ handleRequest(
         result.set(boost::beast::http::field::access_control_allow_methods,
                    "GET,HEAD,OPTIONS,POST,PUT");
         result.set(boost::beast::http::field::access_control_allow_headers,
-                   "Access-Control-Allow-Origin, Access-Control-Allow-Headers, Access-Control-Allow-Methods, Connection, Origin, Accept, X-Requested-With, Content-Type, Access-Control-Request-Method, Access-Control-Request-Headers, Authorization");
+                   "Access-Control-Allow-Origin, Access-Control-Allow-Headers, Access-Control-Allow-Methods, Connection, Origin, Accept, X-Requested-With, Content-Type, Access-Control-Request-Method, Access-Control-Request-Headers, Authorization, If-None-Match");
         result.set(boost::beast::http::field::access_control_max_age,
                    "3600");
         result.set(boost::beast::http::field::connection, //"Connection",
@@ -172,11 +272,31 @@ handleRequest(
                  = std::make_unique<MLReview::Messages::Authorized> (jsonWebToken);
             return successResponse(MLReview::Messages::toJSON(responseMessage));
         }
+        // Answer conditional requests before building the response
+        auto ifNoneMatch = request.find(boost::beast::http::field::if_none_match);
+        if (ifNoneMatch != request.end())
+        {
+            auto eTag = callbackHandler->getETag(requestMessage);
+            if (eTag && ::matchesETag(std::string {ifNoneMatch->value()}, *eTag))
+            {
+                return notModified(*eTag);
+            }
+        }
         // Otherwise process
         auto responseMessage = callbackHandler->process(requestMessage);
         if (responseMessage)
         {
-            return successResponse(MLReview::Messages::toJSON(responseMessage));
+            // An ETag given in the request body is answered in the body
+            // since body-style clients never see an HTTP 304
+            auto eTag = responseMessage->getETag();
+            if (responseMessage->getDataStream())
+            {
+                return streamedResponse(
+                    MLReview::Messages::toJSONStream(
+                        std::move(responseMessage)), eTag);
+            }
+            return successResponse(MLReview::Messages::toJSON(responseMessage),
+                                   eTag);
         }
         else
         {
@@ -222,6 +342,17 @@ public:
         // Accept the WebSocket upgrade request
         doAccept(std::move(request));
     }
+
+    // Release the session's subscriptions
+    ~WebSocketSession()
+    {
+        if (mSubscriptionHandler == nullptr){return;}
+        for (const auto &subscription : mSubscriptions)
+        {
+            mSubscriptionHandler->unsubscribe(subscription.first,
+                                              subscription.second);
+        }
+    }
 private:
     // Access the derived class, this is part of
     // the Curiously Recurring Template Pattern idiom.
@@ -310,6 +441,23 @@ private:
         // Attempt to do something with the thread
         try
         {
+            auto subscriptionReply = processSubscription(requestMessage);
+            if (subscriptionReply)
+            {
+                reply(*subscriptionReply);
+                doRead();
+                return;
+            }
+            if (::isExportRequest(requestMessage))
+            {
+                MLReview::Messages::Error errorMessage;
+                errorMessage.setStatusCode(400);
+                errorMessage.setMessage(
+                    "Exports are only available over HTTP");
+                reply(MLReview::Messages::toJSON(errorMessage.clone()));
+                doRead();
+                return;
+            }
             auto responseMessage
                 = derived().getCallbackHandler()->process(requestMessage);
             if (responseMessage)
@@ -354,6 +502,118 @@ private:
                 derived().shared_from_this()));
     }
 
+    // Handles {"resource": name, "subscribe": true|false}.  Subscribed
+    // sessions are pushed the resource's change notifications.  Nothing is
+    // returned if this is not a subscription request.
+    std::optional<std::string> processSubscription(
+        const std::string &requestMessage)
+    {
+        auto object = nlohmann::json::parse(requestMessage, nullptr, false);
+        if (object.is_discarded() || !object.is_object() ||
+            !object.contains("subscribe") || !object.contains("resource"))
+        {
+            return std::nullopt;
+        }
+        std::string resource;
+        bool subscribe{false};
+        try
+        {
+            resource = object["resource"].template get<std::string> ();
+            subscribe = object["subscribe"].template get<bool> ();
+            auto handler = derived().getCallbackHandler();
+            if (subscribe)
+            {
+                if (!mSubscriptions.contains(resource))
+                {
+                    std::weak_ptr<Derived> session
+                        = derived().shared_from_this();
+                    auto identifier = handler->subscribe(resource,
+                        [session](const std::shared_ptr<const std::string> &notification)
+                        {
+                            auto self = session.lock();
+                            if (!self){return;}
+                            boost::asio::post
+                            (
+                                self->ws().get_executor(),
+                                boost::beast::bind_front_handler
+                                (
+                                    &WebSocketSession::queueNotification,
+                                    self,
+                                    notification
+                                )
+                            );
+                        });
+                    mSubscriptions.insert(std::pair {resource, identifier});
+                    mSubscriptionHandler = handler;
+                }
+            }
+            else
+            {
+                auto subscription = mSubscriptions.find(resource);
+                if (subscription != mSubscriptions.end())
+                {
+                    handler->unsubscribe(subscription->first,
+                                         subscription->second);
+                    mSubscriptions.erase(subscription);
+                }
+            }
+        }
+        catch (const nlohmann::json::exception &e)
+        {
+            MLReview::Messages::Error errorMessage;
+            errorMessage.setStatusCode(400);
+            errorMessage.setMessage("malformed subscription request");
+            return MLReview::Messages::toJSON(errorMessage.clone());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            MLReview::Messages::Error errorMessage;
+            errorMessage.setStatusCode(400);
+            errorMessage.setMessage(std::string {e.what()});
+            return MLReview::Messages::toJSON(errorMessage.clone());
+        }
+        MLReview::Messages::Subscribed response{resource, subscribe};
+        return MLReview::Messages::toJSON(response.clone());
+    }
+
+    // Notifications are dropped while the client is not keeping up with
+    // its queue.  The client can detect the gap from the versions and
+    // catch up.  A client that keeps falling behind is disconnected.
+    void queueNotification(const std::shared_ptr<const std::string> &notification)
+    {
+        if (mClosing){return;}
+        if (mResponseQueue.size() >= mMaximumQueueSize)
+        {
+            mDroppedNotifications = mDroppedNotifications + 1;
+            spdlog::warn("WebSocketSession: slow consumer; dropped "
+                       + std::to_string(mDroppedNotifications)
+                       + " consecutive notifications");
+            if (mDroppedNotifications >= mMaximumDroppedNotifications)
+            {
+                mClosing = true;
+                derived().ws().async_close(
+                    boost::beast::websocket::close_code::policy_error,
+                    boost::beast::bind_front_handler(
+                        &WebSocketSession::onClose,
+                        derived().shared_from_this()));
+            }
+            return;
+        }
+        mDroppedNotifications = 0;
+        queueSend(notification);
+    }
+
+    void onClose(boost::beast::error_code errorCode)
+    {
+        if (errorCode)
+        {
+            spdlog::warn("WebSocketSession::onClose failed with "
+                       + std::string {errorCode.what()});
+            return;
+        }
+        spdlog::info("WebSocketSession: closed slow consumer");
+    }
+
     void reply(const std::string &responseString)
     {
         reply(std::make_shared<std::string> (responseString));
@@ -443,6 +703,12 @@ private:
     boost::beast::flat_buffer mReadBuffer;
     boost::beast::flat_buffer mWriteBuffer;
     std::queue<std::shared_ptr<const std::string>> mResponseQueue;
+    std::shared_ptr<MLReview::Service::Handler> mSubscriptionHandler{nullptr};
+    std::map<std::string, int64_t> mSubscriptions;
+    size_t mMaximumQueueSize{64};
+    int mDroppedNotifications{0};
+    int mMaximumDroppedNotifications{16};
+    bool mClosing{false};
     bool mWriting{false};
 };
 
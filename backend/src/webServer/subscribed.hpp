@@ -0,0 +1,68 @@
+#ifndef MLREVIEW_MESSAGES_SUBSCRIBED_HPP
+#define MLREVIEW_MESSAGES_SUBSCRIBED_HPP
+#include <memory>
+#include <string>
+#include <optional>
+#include <mlReview/messages/message.hpp>
+namespace MLReview::Messages
+{
+/// @class Subscribed "subscribed.hpp" "mlReview/messages/subscribed.hpp"
+/// @brief A one-off response to a websocket subscription request.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class Subscribed final : public IMessage
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] resource    The resource.
+    /// @param[in] subscribed  True indicates the session is now subscribed
+    ///                        and false indicates it is now unsubscribed.
+    Subscribed(const std::string &resource, const bool subscribed)
+    {
+        mData["resource"] = resource;
+        mData["subscribed"] = subscribed;
+    }
+    /// @brief Copy constructor.
+    Subscribed(const Subscribed &message) = default;
+    /// @brief Move constructor.
+    Subscribed(Subscribed &&message) noexcept = default;
+    /// @result The status code.
+    [[nodiscard]] int getStatusCode() const noexcept override final
+    {
+        return 200;
+    }
+    /// @result The details of the message.
+    [[nodiscard]] std::optional<std::string> getMessage() const noexcept final
+    {
+        if (mData["subscribed"].template get<bool> ())
+        {
+            return "Subscribed to "
+                 + mData["resource"].template get<std::string> ();
+        }
+        return "Unsubscribed from "
+             + mData["resource"].template get<std::string> ();
+    }
+    /// @result Flag indicating the request was successful.
+    [[nodiscard]] bool getSuccess() const noexcept override final
+    {
+        return true;
+    }
+    std::optional<nlohmann::json> getData() const noexcept override final
+    {
+        return std::optional<nlohmann::json> (mData);
+    }
+    /// @brief Destructor.
+    ~Subscribed() override = default;
+    /// @brief Clones this class.
+    std::unique_ptr<IMessage> clone() const
+    {
+        std::unique_ptr<MLReview::Messages::IMessage> result
+            = std::make_unique<Subscribed> (*this);
+        return result;
+    }
+    Subscribed& operator=(const Subscribed &message) = default;
+    Subscribed& operator=(Subscribed &&message) noexcept = default;
+private:
+    nlohmann::json mData;
+};
+}
+#endif
@@ -0,0 +1,316 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <bsoncxx/json.hpp>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+#include <mongocxx/client.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "mlReview/database/connection/mongodb.hpp"
+#include "mlReview/service/catalog/resource.hpp"
+#include "mlReview/messages/message.hpp"
+
+// These tests run against a disposable MongoDB replica set.  A single node
+// suffices; see testing/startReplicaSet.sh.  The events collection of the
+// test database is dropped so do not point this at a real database.  The
+// tests are skipped unless MLREVIEW_TEST_MONGODB_HOST is set.
+
+#define COLLECTION_NAME "events"
+
+namespace
+{
+
+/// The catalog polls every 30 s so anything faster came from the stream
+constexpr std::chrono::seconds TIMEOUT{10};
+
+std::string getEnvironmentVariable(const char *name,
+                                   const std::string &defaultValue)
+{
+    auto value = std::getenv(name);
+    if (value == nullptr){return defaultValue;}
+    return std::string {value};
+}
+
+std::shared_ptr<MLReview::Database::Connection::MongoDB> createConnection()
+{
+    auto address = std::getenv("MLREVIEW_TEST_MONGODB_HOST");
+    if (address == nullptr){return nullptr;}
+    auto connection
+        = std::make_shared<MLReview::Database::Connection::MongoDB> ();
+    connection->setAddress(address);
+    connection->setPort(
+        std::stoi(::getEnvironmentVariable("MLREVIEW_TEST_MONGODB_PORT",
+                                           "27017")));
+    connection->setUser(
+        ::getEnvironmentVariable("MLREVIEW_TEST_MONGODB_USER", "mlReviewTest"));
+    connection->setPassword(
+        ::getEnvironmentVariable("MLREVIEW_TEST_MONGODB_PASSWORD",
+                                 "mlReviewTest"));
+    connection->setDatabaseName(
+        ::getEnvironmentVariable("MLREVIEW_TEST_MONGODB_DATABASE",
+                                 "mlReviewTest"));
+    connection->setApplication("mlReviewChangeStreamTest");
+    connection->connect();
+    return connection;
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>
+           (std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/// An event document as written by the event builder
+bsoncxx::document::value createEventDocument(const int64_t identifier,
+                                             const double latitude,
+                                             const int64_t lastUpdate)
+{
+    nlohmann::json document;
+    document["eventIdentifier"] = identifier;
+    document["loadDate"] = ::now();
+    document["lastUpdate"] = lastUpdate;
+    document["parametricData"]["preferredOrigin"]["time"]
+        = static_cast<double> (::now() - 60);
+    document["parametricData"]["preferredOrigin"]["latitude"] = latitude;
+    document["parametricData"]["preferredOrigin"]["longitude"] =-112;
+    document["parametricData"]["preferredOrigin"]["depth"] = 5;
+    document["parametricData"]["preferredOrigin"]["reviewStatus"]
+        = "automatic";
+    return bsoncxx::from_json(document.dump());
+}
+
+/// Runs the function on the events collection
+void modifyEvents(
+    const MLReview::Database::Connection::MongoDB &connection,
+    const std::function<void (mongocxx::collection &)> &modify)
+{
+    auto lease = connection.acquire();
+    auto client = reinterpret_cast<mongocxx::client *> (lease.getSession());
+    auto collection
+        = client->database(connection.getDatabaseName())
+                 .collection(COLLECTION_NAME);
+    modify(collection);
+}
+
+/// Collects what the catalog reports
+class Observer
+{
+public:
+    void addNewEvents(const std::vector<int64_t> &identifiers)
+    {
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mNewEvents.insert(mNewEvents.end(),
+                          identifiers.begin(), identifiers.end());
+        }
+        mConditionVariable.notify_all();
+    }
+    void addNotification(const std::shared_ptr<const std::string> &message)
+    {
+        auto object = nlohmann::json::parse(*message);
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mNotifications.push_back(std::move(object["data"]));
+        }
+        mConditionVariable.notify_all();
+    }
+    /// True indicates the event was reported as new
+    [[nodiscard]] bool waitForNewEvent(const int64_t identifier)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return mConditionVariable.wait_for(lock, TIMEOUT, [&]()
+               {
+                   return std::find(mNewEvents.begin(), mNewEvents.end(),
+                                    identifier) != mNewEvents.end();
+               });
+    }
+    /// @result The upserted event with the identifier from the first delta
+    ///         notification that satisfies the predicate.
+    [[nodiscard]] std::optional<nlohmann::json>
+        waitForUpsert(const int64_t identifier,
+                      const std::function<bool (const nlohmann::json &)> &predicate)
+    {
+        std::optional<nlohmann::json> result;
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConditionVariable.wait_for(lock, TIMEOUT, [&]()
+        {
+            for (const auto &data : mNotifications)
+            {
+                if (!data.contains("upserted")){continue;}
+                for (const auto &event : data["upserted"])
+                {
+                    if (event["eventIdentifier"] == std::to_string(identifier) &&
+                        predicate(event))
+                    {
+                        result = event;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        });
+        return result;
+    }
+    /// True indicates the event was reported as removed
+    [[nodiscard]] bool waitForRemoval(const int64_t identifier)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return mConditionVariable.wait_for(lock, TIMEOUT, [&]()
+               {
+                   for (const auto &data : mNotifications)
+                   {
+                       if (!data.contains("removed")){continue;}
+                       for (const auto &removed : data["removed"])
+                       {
+                           if (removed == identifier){return true;}
+                       }
+                   }
+                   return false;
+               });
+    }
+private:
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::vector<int64_t> mNewEvents;
+    std::vector<nlohmann::json> mNotifications;
+};
+
+std::unique_ptr<MLReview::Service::Catalog::Resource>
+    createResource(std::shared_ptr<MLReview::Database::Connection::MongoDB> &connection,
+                   ::Observer &observer)
+{
+    auto resource
+        = std::make_unique<MLReview::Service::Catalog::Resource> (connection);
+    resource->setNewEventsCallback(
+        [&observer](const std::vector<int64_t> &identifiers)
+        {
+            observer.addNewEvents(identifiers);
+        });
+    [[maybe_unused]] auto subscription
+        = resource->subscribe(
+            [&observer](const std::shared_ptr<const std::string> &message)
+            {
+                observer.addNotification(message);
+            });
+    resource->enableChangeStream();
+    return resource;
+}
+
+/// True indicates the catalog holds the event
+bool haveEvent(MLReview::Service::Catalog::Resource &resource,
+               const int64_t identifier)
+{
+    nlohmann::json request;
+    request["resource"] = "catalog";
+    auto message = resource.processRequest(request);
+    auto object = nlohmann::json::parse(MLReview::Messages::toJSON(message));
+    for (const auto &event : object["data"]["events"])
+    {
+        if (event["eventIdentifier"] == std::to_string(identifier))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+TEST_CASE("Catalog change stream", "[catalog][mongodb]")
+{
+    auto connection = ::createConnection();
+    if (!connection)
+    {
+        SKIP("MLREVIEW_TEST_MONGODB_HOST not set");
+    }
+    ::modifyEvents(*connection, [](mongocxx::collection &collection)
+                   {
+                       collection.drop();
+                       collection.insert_one(
+                           ::createEventDocument(1, 40, ::now()));
+                   });
+    // The observers must outlive the resources that call them
+    ::Observer observer;
+    ::Observer restartObserver;
+    auto resource = ::createResource(connection, observer);
+    // The initial load
+    auto deadline = std::chrono::steady_clock::now() + TIMEOUT;
+    while (!::haveEvent(*resource, 1) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds {100});
+    }
+    REQUIRE(::haveEvent(*resource, 1));
+
+    SECTION("Insert, update, and delete")
+    {
+        ::modifyEvents(*connection, [](mongocxx::collection &collection)
+                       {
+                           collection.insert_one(
+                               ::createEventDocument(2, 41, ::now()));
+                       });
+        REQUIRE(observer.waitForNewEvent(2));
+        CHECK(::haveEvent(*resource, 2));
+
+        ::modifyEvents(*connection, [](mongocxx::collection &collection)
+                       {
+                           using namespace bsoncxx::builder::basic;
+                           collection.replace_one(
+                               make_document(kvp("eventIdentifier", 2)),
+                               ::createEventDocument(2, 42, ::now() + 1));
+                       });
+        auto updated
+            = observer.waitForUpsert(2, [](const nlohmann::json &event)
+                                     {
+                                         return event["preferredOrigin"]
+                                                     ["latitude"] == 42;
+                                     });
+        CHECK(updated);
+
+        ::modifyEvents(*connection, [](mongocxx::collection &collection)
+                       {
+                           using namespace bsoncxx::builder::basic;
+                           collection.delete_one(
+                               make_document(kvp("eventIdentifier", 1)));
+                       });
+        CHECK(observer.waitForRemoval(1));
+        CHECK_FALSE(::haveEvent(*resource, 1));
+        CHECK(::haveEvent(*resource, 2));
+    }
+
+    SECTION("Restart")
+    {
+        resource.reset();
+        // Changes made while no one is watching are caught up on restart
+        ::modifyEvents(*connection, [](mongocxx::collection &collection)
+                       {
+                           collection.insert_one(
+                               ::createEventDocument(3, 43, ::now()));
+                       });
+        resource = ::createResource(connection, restartObserver);
+        deadline = std::chrono::steady_clock::now() + TIMEOUT;
+        while (!(::haveEvent(*resource, 1) && ::haveEvent(*resource, 3)) &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds {100});
+        }
+        CHECK(::haveEvent(*resource, 1));
+        CHECK(::haveEvent(*resource, 3));
+        ::modifyEvents(*connection, [](mongocxx::collection &collection)
+                       {
+                           collection.insert_one(
+                               ::createEventDocument(4, 44, ::now()));
+                       });
+        CHECK(restartObserver.waitForNewEvent(4));
+    }
+    resource.reset();
+}
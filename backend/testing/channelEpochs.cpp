@@ -0,0 +1,175 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <catch2/catch_test_macros.hpp>
+#include "mlReview/waveServer/channelEpochs.hpp"
+#include "mlReview/waveServer/request.hpp"
+#include "requests.hpp"
+
+using namespace MLReview::WaveServer;
+
+namespace
+{
+
+ChannelEpochs::Epoch createEpoch(const std::string &station,
+                                 const std::string &channel,
+                                 const std::string &locationCode,
+                                 const int64_t onDate,
+                                 const int64_t offDate,
+                                 const double samplingRate = 100)
+{
+    ChannelEpochs::Epoch epoch;
+    epoch.network = "uu";
+    epoch.station = station;
+    epoch.channel = channel;
+    epoch.locationCode = locationCode;
+    epoch.samplingRate = samplingRate;
+    epoch.onDate = std::chrono::microseconds {onDate};
+    epoch.offDate = std::chrono::microseconds {offDate};
+    return epoch;
+}
+
+ChannelEpochs createChannelEpochs()
+{
+    // Deliberately out of order; CTU's HHZ was upgraded at t = 200 and
+    // was down from t = 300 to t = 400
+    std::vector<ChannelEpochs::Epoch> epochs
+    {
+        ::createEpoch("ctu", "hhz", "01", 400, 1000, 200),
+        ::createEpoch("CTU", "HHZ", "01", 0, 200, 40),
+        ::createEpoch("CTU", "HHZ", "01", 200, 300, 100),
+        ::createEpoch("CTU", "EHZ", "--", 0, 1000),
+        ::createEpoch("MOUT", "HHZ", "  ", 500, 600)
+    };
+    return ChannelEpochs {std::move(epochs)};
+}
+
+}
+
+TEST_CASE("MLReview::WaveServer::ChannelEpochs", "[channelEpochs]")
+{
+    auto channelEpochs = ::createChannelEpochs();
+    REQUIRE(channelEpochs.size() == 5);
+
+    SECTION("Stations")
+    {
+        CHECK(channelEpochs.haveStation("UU", "CTU"));
+        CHECK(channelEpochs.haveStation("uu", "mout"));
+        CHECK_FALSE(channelEpochs.haveStation("UU", "FORK"));
+        CHECK_FALSE(channelEpochs.haveStation("WY", "CTU"));
+    }
+
+    SECTION("Find")
+    {
+        auto epoch = channelEpochs.find("UU", "CTU", "HHZ", "01",
+                                        std::chrono::microseconds {250});
+        REQUIRE(epoch);
+        CHECK(epoch->network == "UU");
+        CHECK(epoch->station == "CTU");
+        CHECK(epoch->samplingRate == 100);
+        // On dates are inclusive and off dates are exclusive
+        epoch = channelEpochs.find("uu", "ctu", "hhz", "01",
+                                   std::chrono::microseconds {200});
+        REQUIRE(epoch);
+        CHECK(epoch->samplingRate == 100);
+        epoch = channelEpochs.find("UU", "CTU", "HHZ", "01",
+                                   std::chrono::microseconds {199});
+        REQUIRE(epoch);
+        CHECK(epoch->samplingRate == 40);
+        epoch = channelEpochs.find("UU", "CTU", "HHZ", "01",
+                                   std::chrono::microseconds {999});
+        REQUIRE(epoch);
+        CHECK(epoch->samplingRate == 200);
+        // Down time, before the first epoch, and after the last epoch
+        CHECK_FALSE(channelEpochs.find("UU", "CTU", "HHZ", "01",
+                                       std::chrono::microseconds {350}));
+        CHECK_FALSE(channelEpochs.find("UU", "CTU", "HHZ", "01",
+                                       std::chrono::microseconds {-1}));
+        CHECK_FALSE(channelEpochs.find("UU", "CTU", "HHZ", "01",
+                                       std::chrono::microseconds {1000}));
+        // Other location codes and channels are distinct
+        CHECK_FALSE(channelEpochs.find("UU", "CTU", "HHZ", "",
+                                       std::chrono::microseconds {250}));
+        CHECK_FALSE(channelEpochs.find("UU", "CTU", "HHN", "01",
+                                       std::chrono::microseconds {250}));
+    }
+
+    SECTION("Blank location codes")
+    {
+        for (const std::string locationCode : {"", "--", "  "})
+        {
+            CHECK(channelEpochs.find("UU", "CTU", "EHZ", locationCode,
+                                     std::chrono::microseconds {10}));
+            CHECK(channelEpochs.find("UU", "MOUT", "HHZ", locationCode,
+                                     std::chrono::microseconds {550}));
+        }
+    }
+
+    SECTION("Station epochs")
+    {
+        auto epochs = channelEpochs.getEpochs("UU", "CTU");
+        REQUIRE(epochs.size() == 4);
+        // Sorted by channel then on date
+        CHECK(epochs[0].channel == "EHZ");
+        CHECK(epochs[1].onDate == std::chrono::microseconds {0});
+        CHECK(epochs[2].onDate == std::chrono::microseconds {200});
+        CHECK(epochs[3].onDate == std::chrono::microseconds {400});
+        CHECK(channelEpochs.getEpochs("UU", "CTU",
+                                      std::chrono::microseconds {350}).size()
+           == 1);
+        CHECK(channelEpochs.getEpochs("UU", "CTU",
+                                      std::chrono::microseconds {450}).size()
+           == 2);
+        CHECK(channelEpochs.getEpochs("UU", "FORK").empty());
+    }
+
+    SECTION("May have data")
+    {
+        CHECK(channelEpochs.mayHaveData(
+            ::createRequest("CTU", "HHZ", "01", 250, 260)));
+        // Overlaps the end of one epoch
+        CHECK(channelEpochs.mayHaveData(
+            ::createRequest("CTU", "HHZ", "01", 290, 350)));
+        // Entirely in the down time
+        CHECK_FALSE(channelEpochs.mayHaveData(
+            ::createRequest("CTU", "HHZ", "01", 300, 400)));
+        // After the station was removed
+        CHECK_FALSE(channelEpochs.mayHaveData(
+            ::createRequest("MOUT", "HHZ", "", 600, 700)));
+        // A channel that never existed at a known station
+        CHECK_FALSE(channelEpochs.mayHaveData(
+            ::createRequest("CTU", "HHN", "01", 250, 260)));
+        // Unknown stations are assumed to have data
+        CHECK(channelEpochs.mayHaveData(
+            ::createRequest("FORK", "HHZ", "01", 250, 260)));
+    }
+
+    SECTION("Empty")
+    {
+        ChannelEpochs empty;
+        CHECK(empty.size() == 0);
+        CHECK(empty.mayHaveData(
+            ::createRequest("CTU", "HHZ", "01", 250, 260)));
+    }
+
+    SECTION("Copy")
+    {
+        auto copy = channelEpochs;
+        CHECK(copy.size() == channelEpochs.size());
+        CHECK(copy.find("UU", "CTU", "HHZ", "01",
+                        std::chrono::microseconds {250}));
+    }
+}
+
+TEST_CASE("MLReview::WaveServer::ChannelEpochs invalid epochs",
+          "[channelEpochs]")
+{
+    for (auto epoch : {::createEpoch("", "HHZ", "01", 0, 1),
+                       ::createEpoch("CTU", " ", "01", 0, 1),
+                       ::createEpoch("CTU", "HHZ", "01", 1, 0)})
+    {
+        CHECK_THROWS_AS(ChannelEpochs(std::vector<ChannelEpochs::Epoch> {epoch}),
+                        std::invalid_argument);
+    }
+}
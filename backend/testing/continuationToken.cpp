@@ -0,0 +1,59 @@
+#include <chrono>
+#include <limits>
+#include <string>
+#include <stdexcept>
+#include <catch2/catch_test_macros.hpp>
+#include "service/catalog/continuationToken.hpp"
+
+TEST_CASE("Catalog continuation token", "[catalog]")
+{
+    SECTION("Round trip")
+    {
+        for (const auto &key :
+             {::EventKey {std::chrono::microseconds {0}, 0},
+              ::EventKey {std::chrono::microseconds {1700000000123456}, 60512345},
+              // Events before 1970 have negative origin times
+              ::EventKey {std::chrono::microseconds {-1}, 1},
+              ::EventKey {std::chrono::microseconds
+                          {std::numeric_limits<int64_t>::lowest()},
+                          std::numeric_limits<int64_t>::max()}})
+        {
+            auto token = ::toContinuationToken(key);
+            CHECK(token.size() == 32);
+            CHECK(token.find_first_not_of("0123456789abcdef")
+               == std::string::npos);
+            CHECK(::fromContinuationToken(token) == key);
+        }
+    }
+
+    SECTION("Tokens preserve the page order of non-negative keys")
+    {
+        auto token1
+            = ::toContinuationToken({std::chrono::microseconds {100}, 2});
+        auto token2
+            = ::toContinuationToken({std::chrono::microseconds {100}, 10});
+        auto token3
+            = ::toContinuationToken({std::chrono::microseconds {101}, 1});
+        CHECK(token1 < token2);
+        CHECK(token2 < token3);
+    }
+
+    SECTION("Invalid tokens")
+    {
+        auto token
+            = ::toContinuationToken({std::chrono::microseconds {100}, 2});
+        CHECK_THROWS_AS(::fromContinuationToken(""), std::invalid_argument);
+        CHECK_THROWS_AS(::fromContinuationToken(token.substr(1)),
+                        std::invalid_argument);
+        CHECK_THROWS_AS(::fromContinuationToken(token + "0"),
+                        std::invalid_argument);
+        auto upperCase = token;
+        upperCase[31] = 'A';
+        CHECK_THROWS_AS(::fromContinuationToken(upperCase),
+                        std::invalid_argument);
+        auto notHex = token;
+        notHex[0] = 'g';
+        CHECK_THROWS_AS(::fromContinuationToken(notHex),
+                        std::invalid_argument);
+    }
+}
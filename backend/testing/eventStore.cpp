@@ -0,0 +1,240 @@
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "mlReview/service/catalog/event.hpp"
+#include "service/catalog/eventStore.hpp"
+
+namespace
+{
+
+::StoredEvent createEvent(const int64_t identifier,
+                          const int64_t originTime,
+                          const int64_t lastUpdate = 1,
+                          const double magnitude = 1,
+                          const int64_t loadDate = 1)
+{
+    ::StoredEvent storedEvent;
+    storedEvent.event.setIdentifier(identifier);
+    storedEvent.object["eventIdentifier"] = identifier;
+    storedEvent.object["originTime"] = originTime;
+    storedEvent.object["magnitude"] = magnitude;
+    storedEvent.originTime = std::chrono::microseconds {originTime};
+    storedEvent.latitude = 40;
+    storedEvent.longitude =-112;
+    storedEvent.loadDate = std::chrono::seconds {loadDate};
+    storedEvent.lastUpdate = std::chrono::seconds {lastUpdate};
+    return storedEvent;
+}
+
+std::vector<int64_t> getIdentifiers(const nlohmann::json &events)
+{
+    std::vector<int64_t> result;
+    for (const auto &event : events)
+    {
+        result.push_back(event["eventIdentifier"].get<int64_t> ());
+    }
+    return result;
+}
+
+}
+
+TEST_CASE("EventStore upsert", "[eventStore]")
+{
+    ::EventStore store;
+    CHECK(store.size() == 0);
+    CHECK(store.getHash() == 0);
+    auto version0 = store.getVersion();
+    // Versions keep increasing across restarts
+    CHECK(version0 > 1600000000000000);
+
+    REQUIRE(store.upsert(::createEvent(1, 100)) == ::EventStore::Change::Inserted);
+    auto hash1 = store.getHash();
+    CHECK(hash1 != 0);
+    CHECK(store.getVersion() == version0 + 1);
+    REQUIRE(store.contains(1));
+    REQUIRE(store.find(1) != nullptr);
+    CHECK(store.find(1)->serialized == store.find(1)->object.dump());
+    CHECK(store.find(2) == nullptr);
+
+    SECTION("Unchanged events are not recorded")
+    {
+        CHECK(store.upsert(::createEvent(1, 100)) == ::EventStore::Change::None);
+        CHECK(store.getVersion() == version0 + 1);
+        CHECK(store.getHash() == hash1);
+    }
+
+    SECTION("Changed events replace the stored event")
+    {
+        CHECK(store.upsert(::createEvent(1, 100, 2, 3.5))
+           == ::EventStore::Change::Updated);
+        CHECK(store.size() == 1);
+        CHECK(store.getVersion() == version0 + 2);
+        CHECK(store.getHash() != hash1);
+        CHECK(store.find(1)->object["magnitude"] == 3.5);
+        // Reverting the content reverts the hash
+        store.upsert(::createEvent(1, 100, 3));
+        CHECK(store.getHash() == hash1);
+    }
+
+    SECTION("The hash is independent of the order of insertion")
+    {
+        ::EventStore other;
+        other.upsert(::createEvent(2, 200));
+        other.upsert(::createEvent(1, 100));
+        store.upsert(::createEvent(2, 200));
+        CHECK(other.getHash() == store.getHash());
+        CHECK(other.erase(2));
+        CHECK_FALSE(other.erase(2));
+        CHECK(other.getHash() == hash1);
+    }
+
+    SECTION("Age out and retain")
+    {
+        store.upsert(::createEvent(2, 200, 1, 1, 5));
+        store.upsert(::createEvent(3, 300, 1, 1, 10));
+        CHECK(store.ageOut(std::chrono::seconds {1})
+           == std::vector<int64_t> {1});
+        CHECK(store.retainOnly(std::set<int64_t> {3})
+           == std::vector<int64_t> {2});
+        CHECK(store.size() == 1);
+        CHECK(store.contains(3));
+    }
+
+    SECTION("Serialize")
+    {
+        store.upsert(::createEvent(2, 200));
+        auto catalog = nlohmann::json::parse(store.serialize());
+        CHECK(catalog["full"] == true);
+        CHECK(catalog["hash"].get<size_t> () == store.getHash());
+        CHECK(catalog["version"].get<uint64_t> () == store.getVersion());
+        CHECK(::getIdentifiers(catalog["events"])
+           == std::vector<int64_t> {1, 2});
+        ::EventStore empty;
+        CHECK(nlohmann::json::parse(empty.serialize())["events"].empty());
+    }
+}
+
+TEST_CASE("EventStore change log", "[eventStore]")
+{
+    ::EventStore store;
+    auto version0 = store.getVersion();
+    store.upsert(::createEvent(1, 100));
+    store.upsert(::createEvent(2, 200));
+    auto version2 = store.getVersion();
+    store.upsert(::createEvent(2, 200, 2, 4));
+    store.upsert(::createEvent(3, 300));
+    store.erase(1);
+
+    SECTION("Changes since a version")
+    {
+        auto changes = store.getChangesSince(version2);
+        REQUIRE(changes);
+        CHECK((*changes)["fromVersion"].get<uint64_t> () == version2);
+        CHECK((*changes)["version"].get<uint64_t> () == store.getVersion());
+        CHECK(::getIdentifiers((*changes)["upserted"])
+           == std::vector<int64_t> {2, 3});
+        CHECK((*changes)["upserted"][0]["magnitude"] == 4);
+        CHECK((*changes)["removed"].get<std::vector<int64_t>> ()
+           == std::vector<int64_t> {1});
+    }
+
+    SECTION("An event changed and removed is only removed")
+    {
+        auto changes = store.getChangesSince(version0);
+        REQUIRE(changes);
+        CHECK(::getIdentifiers((*changes)["upserted"])
+           == std::vector<int64_t> {2, 3});
+        CHECK((*changes)["removed"].get<std::vector<int64_t>> ()
+           == std::vector<int64_t> {1});
+    }
+
+    SECTION("Up to date")
+    {
+        auto changes = store.getChangesSince(store.getVersion());
+        REQUIRE(changes);
+        CHECK((*changes)["upserted"].empty());
+        CHECK((*changes)["removed"].empty());
+    }
+
+    SECTION("Versions from the future need the full catalog")
+    {
+        CHECK_FALSE(store.getChangesSince(store.getVersion() + 1));
+    }
+
+    SECTION("Versions older than the log need the full catalog")
+    {
+        for (int64_t identifier = 10; identifier < 8300; ++identifier)
+        {
+            store.upsert(::createEvent(identifier, identifier));
+        }
+        CHECK_FALSE(store.getChangesSince(version0));
+        CHECK_FALSE(store.getChangesSince(version2));
+        auto recent = store.getChangesSince(store.getVersion() - 8000);
+        REQUIRE(recent);
+        CHECK((*recent)["upserted"].size() == 8000);
+    }
+}
+
+TEST_CASE("EventStore paging", "[eventStore]")
+{
+    ::EventStore store;
+    // Events 1 and 2 share an origin time
+    store.upsert(::createEvent(2, 100));
+    store.upsert(::createEvent(1, 100));
+    store.upsert(::createEvent(3, 200));
+    store.upsert(::createEvent(4, 300));
+    store.upsert(::createEvent(5, 400));
+    std::chrono::microseconds startTime{100};
+    std::chrono::microseconds endTime{400};
+
+    SECTION("Window")
+    {
+        auto page = store.query(startTime, endTime, std::nullopt, 10);
+        CHECK(::getIdentifiers(page.events)
+           == std::vector<int64_t> {1, 2, 3, 4});
+        CHECK_FALSE(page.next);
+        REQUIRE(page.last);
+        CHECK(*page.last == ::EventKey {std::chrono::microseconds {300}, 4});
+    }
+
+    SECTION("Pages")
+    {
+        std::vector<int64_t> identifiers;
+        std::optional<::EventKey> after;
+        int nPages{0};
+        size_t hash{0};
+        while (true)
+        {
+            auto page = store.query(startTime, endTime + std::chrono::microseconds {1},
+                                    after, 2);
+            CHECK(page.events.size() <= 2);
+            for (const auto &identifier : ::getIdentifiers(page.events))
+            {
+                identifiers.push_back(identifier);
+            }
+            hash = hash ^ page.hash;
+            nPages = nPages + 1;
+            if (!page.next){break;}
+            after = page.next;
+        }
+        // Ties on origin time are split by identifier
+        CHECK(identifiers == std::vector<int64_t> {1, 2, 3, 4, 5});
+        CHECK(nPages == 3);
+        CHECK(hash == store.getHash());
+    }
+
+    SECTION("Relocated events move in time")
+    {
+        store.upsert(::createEvent(1, 350, 2));
+        auto page = store.query(startTime, endTime, std::nullopt, 10);
+        CHECK(::getIdentifiers(page.events)
+           == std::vector<int64_t> {2, 3, 4, 1});
+        store.erase(3);
+        page = store.query(startTime, endTime, std::nullopt, 10);
+        CHECK(::getIdentifiers(page.events)
+           == std::vector<int64_t> {2, 4, 1});
+    }
+}
@@ -0,0 +1,132 @@
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <libmseed.h>
+#include <catch2/catch_test_macros.hpp>
+#include "mlReview/waveServer/waveform.hpp"
+#include "mlReview/waveServer/segment.hpp"
+#include "waveServer/unpackMiniSEED3.hpp"
+
+namespace
+{
+
+constexpr double SAMPLING_RATE{100};
+constexpr int64_t START_TIME{1700000000}; // UTC seconds
+
+void appendRecord(char *record, int recordLength, void *handlerData)
+{
+    auto buffer = reinterpret_cast<std::string *> (handlerData);
+    buffer->append(record, static_cast<size_t> (recordLength));
+}
+
+/// Packs the samples into 512 byte Steim2 miniSEED3 records
+std::string pack(std::vector<int> samples, int *nRecords)
+{
+    std::string result;
+    auto msr = msr3_init(nullptr);
+    REQUIRE(msr != nullptr);
+    ms_nslc2sid(msr->sid, LM_SIDLEN, 0, "UU", "CTU", "01", "HHZ");
+    msr->formatversion = 3;
+    msr->reclen = 512;
+    msr->samprate = SAMPLING_RATE;
+    msr->starttime = START_TIME*NSTMODULUS;
+    msr->encoding = DE_STEIM2;
+    msr->sampletype = 'i';
+    msr->datasamples = samples.data();
+    msr->numsamples = static_cast<int64_t> (samples.size());
+    int64_t packedSamples{0};
+    *nRecords = msr3_pack(msr, &appendRecord, &result, &packedSamples,
+                          MSF_FLUSHDATA, 0);
+    // The samples belong to the vector
+    msr->datasamples = nullptr;
+    msr3_free(&msr);
+    REQUIRE(packedSamples == static_cast<int64_t> (samples.size()));
+    return result;
+}
+
+std::vector<int> createSamples(const int nSamples)
+{
+    std::vector<int> samples(nSamples);
+    for (int i = 0; i < nSamples; ++i)
+    {
+        samples[i] = static_cast<int> (std::lround(1000*std::sin(0.05*i)))
+                   + i%7;
+    }
+    return samples;
+}
+
+}
+
+TEST_CASE("MLReview::WaveServer::MiniSEEDAssembler", "[miniSEED]")
+{
+    auto samples = createSamples(3000);
+    int nRecords{0};
+    auto records = pack(samples, &nRecords);
+    REQUIRE(nRecords > 2);
+    REQUIRE(records.size() == static_cast<size_t> (nRecords)*512);
+
+    SECTION("Stream in arbitrary chunks")
+    {
+        ::MiniSEEDAssembler assembler;
+        for (const size_t chunkSize : {size_t {1}, size_t {37},
+                                       size_t {512}, size_t {1000}})
+        {
+            for (size_t offset = 0; offset < records.size();
+                 offset = offset + chunkSize)
+            {
+                assembler.append(records.data() + offset,
+                                 std::min(chunkSize, records.size() - offset));
+            }
+            auto waveform = assembler.finish();
+            CHECK(waveform.getNetwork() == "UU");
+            CHECK(waveform.getStation() == "CTU");
+            CHECK(waveform.getChannel() == "HHZ");
+            CHECK(waveform.getLocationCode() == "01");
+            REQUIRE(waveform.getNumberOfSegments() == 1);
+            const auto &segment = waveform.at(0);
+            CHECK(segment.getStartTime()
+               == std::chrono::microseconds {START_TIME*1000000});
+            CHECK(segment.getSamplingRate() == SAMPLING_RATE);
+            CHECK(segment.getData<int> () == samples);
+        }
+    }
+
+    SECTION("Discard a trailing partial record")
+    {
+        ::MiniSEEDAssembler assembler;
+        assembler.append(records.data(), records.size() - 100);
+        auto waveform = assembler.finish();
+        REQUIRE(waveform.getNumberOfSegments() == 1);
+        auto nSamples = waveform.at(0).getNumberOfSamples();
+        CHECK(nSamples > 0);
+        CHECK(nSamples < static_cast<int> (samples.size()));
+        auto data = waveform.at(0).getData<int> ();
+        CHECK(std::equal(data.begin(), data.end(), samples.begin()));
+    }
+
+    SECTION("Finish resets the assembler")
+    {
+        ::MiniSEEDAssembler assembler;
+        assembler.append(records.data(), records.size());
+        CHECK(assembler.finish().getNumberOfSegments() == 1);
+        CHECK(assembler.finish().getNumberOfSegments() == 0);
+        assembler.append(records.data(), 300);
+        assembler.clear();
+        assembler.append(records.data() + 512, records.size() - 512);
+        auto waveform = assembler.finish();
+        REQUIRE(waveform.getNumberOfSegments() == 1);
+        CHECK(waveform.at(0).getStartTime()
+            > std::chrono::microseconds {START_TIME*1000000});
+    }
+
+    SECTION("Stop at garbage")
+    {
+        ::MiniSEEDAssembler assembler;
+        std::string garbage(1024, 'x');
+        assembler.append(garbage.data(), garbage.size());
+        assembler.append(records.data(), records.size());
+        CHECK(assembler.finish().getNumberOfSegments() == 0);
+    }
+}
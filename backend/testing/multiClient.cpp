@@ -0,0 +1,326 @@
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <catch2/catch_test_macros.hpp>
+#include "mlReview/waveServer/multiClient.hpp"
+#include "mlReview/waveServer/waveform.hpp"
+#include "mlReview/waveServer/segment.hpp"
+#include "mlReview/waveServer/request.hpp"
+#include "waveServer/completeness.hpp"
+#include "requests.hpp"
+
+using namespace MLReview::WaveServer;
+
+namespace
+{
+
+/// Creates a 1 Hz segment starting at the given second
+Segment createSegment(const int64_t startTime, const std::vector<int> &data)
+{
+    Segment segment;
+    segment.setStartTime(std::chrono::microseconds {startTime*1000000});
+    segment.setSamplingRate(1);
+    segment.setData(data);
+    return segment;
+}
+
+/// Serves the samples of a 1 Hz series of constant value that fall in the
+/// requested window except in the given holes [start, end) in seconds.
+class FakeClient : public IClient
+{
+public:
+    FakeClient(const int value,
+               std::vector<std::pair<int64_t, int64_t>> holes = {}) :
+        mHoles(std::move(holes)),
+        mValue(value)
+    {
+    }
+    Waveform getData(const Request &request) const override
+    {
+        mRequests.push_back(request);
+        Waveform waveform;
+        auto startTime = (request.getStartTime().count() + 999999)/1000000;
+        auto endTime = request.getEndTime().count()/1000000;
+        std::vector<int> data;
+        int64_t segmentStart{startTime};
+        for (int64_t t = startTime; t <= endTime + 1; ++t)
+        {
+            bool inHole{t > endTime};
+            for (const auto &hole : mHoles)
+            {
+                if (t >= hole.first && t < hole.second){inHole = true;}
+            }
+            if (inHole)
+            {
+                if (!data.empty())
+                {
+                    waveform.addSegment(::createSegment(segmentStart, data));
+                    data.clear();
+                }
+                continue;
+            }
+            if (data.empty()){segmentStart = t;}
+            data.push_back(mValue);
+        }
+        return waveform;
+    }
+    std::string getType() const noexcept override
+    {
+        return "Fake";
+    }
+    std::vector<std::pair<int64_t, int64_t>> mHoles;
+    mutable std::vector<Request> mRequests;
+    int mValue{0};
+};
+
+/// A client whose requests always fail
+class FailingClient : public IClient
+{
+public:
+    Waveform getData(const Request &) const override
+    {
+        throw std::runtime_error("Server unavailable");
+    }
+    std::string getType() const noexcept override
+    {
+        return "Failing";
+    }
+};
+
+/// Holds requests until it is opened
+class Gate
+{
+public:
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConditionVariable.wait(lock, [this]{return mOpen;});
+    }
+    void open()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOpen = true;
+        }
+        mConditionVariable.notify_all();
+    }
+private:
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    bool mOpen{false};
+};
+
+/// Opens the gate when it goes out of scope
+struct GateOpener
+{
+    ~GateOpener(){gate->open();}
+    std::shared_ptr<Gate> gate;
+};
+
+/// A client that hangs until the gate is opened
+class HungClient : public IClient
+{
+public:
+    explicit HungClient(std::shared_ptr<Gate> gate) :
+        mGate(std::move(gate))
+    {
+    }
+    Waveform getData(const Request &) const override
+    {
+        mGate->wait();
+        return Waveform {};
+    }
+    std::string getType() const noexcept override
+    {
+        return "Hung";
+    }
+    std::shared_ptr<Gate> mGate;
+};
+
+}
+
+TEST_CASE("MLReview::WaveServer::getGaps", "[completeness]")
+{
+    auto request = ::createRequest("CTU", "HHZ", "01", 0, 10000000);
+
+    SECTION("No data")
+    {
+        Waveform waveform;
+        auto gaps = ::getGaps(waveform, request);
+        REQUIRE(gaps.size() == 1);
+        CHECK(gaps[0].first == request.getStartTime());
+        CHECK(gaps[0].second == request.getEndTime());
+        CHECK(::percentComplete(waveform, request) == 0);
+    }
+
+    SECTION("Complete")
+    {
+        Waveform waveform;
+        waveform.addSegment(::createSegment(0, std::vector<int> (11, 1)));
+        CHECK(::getGaps(waveform, request).empty());
+        CHECK(::percentComplete(waveform, request) == 100);
+    }
+
+    SECTION("Interior and trailing gaps")
+    {
+        Waveform waveform;
+        waveform.addSegment(::createSegment(0, std::vector<int> (4, 1)));
+        waveform.addSegment(::createSegment(7, std::vector<int> (1, 1)));
+        auto gaps = ::getGaps(waveform, request);
+        REQUIRE(gaps.size() == 2);
+        CHECK(gaps[0].first == std::chrono::seconds {3});
+        CHECK(gaps[0].second == std::chrono::seconds {7});
+        CHECK(gaps[1].first == std::chrono::seconds {7});
+        CHECK(gaps[1].second == std::chrono::seconds {10});
+    }
+
+    SECTION("Leading gap")
+    {
+        Waveform waveform;
+        waveform.addSegment(::createSegment(5, std::vector<int> (6, 1)));
+        auto gaps = ::getGaps(waveform, request);
+        REQUIRE(gaps.size() == 1);
+        CHECK(gaps[0].first == std::chrono::seconds {0});
+        CHECK(gaps[0].second == std::chrono::seconds {5});
+    }
+
+    SECTION("A break of one sampling period is not a gap")
+    {
+        Waveform waveform;
+        waveform.addSegment(::createSegment(0, std::vector<int> (5, 1)));
+        waveform.addSegment(::createSegment(5, std::vector<int> (6, 1)));
+        CHECK(::getGaps(waveform, request).empty());
+    }
+}
+
+TEST_CASE("MLReview::WaveServer::MultiClient stitching", "[stitching]")
+{
+    auto request = ::createRequest("CTU", "HHZ", "01", 0, 10000000);
+    MultiClient multiClient;
+    multiClient.setMaximumNumberOfConcurrentRequests(1);
+    auto primary
+        = std::make_unique<::FakeClient>
+          (1, std::vector<std::pair<int64_t, int64_t>> {{4, 7}});
+    auto secondary = std::make_unique<::FakeClient> (2);
+    auto primaryPointer = primary.get();
+    auto secondaryPointer = secondary.get();
+    multiClient.insert(std::move(primary), 2);
+    multiClient.insert(std::move(secondary), 1);
+
+    SECTION("Best source only")
+    {
+        multiClient.disableStitching();
+        auto waveform = multiClient.getData(std::vector<Request> {request});
+        REQUIRE(waveform.size() == 1);
+        // The primary is 70 percent complete and the secondary is complete
+        REQUIRE(waveform[0].getNumberOfSegments() == 1);
+        CHECK(waveform[0].at(0).getData<int> () == std::vector<int> (11, 2));
+    }
+
+    SECTION("Fill the primary's gap from the secondary")
+    {
+        multiClient.enableStitching();
+        REQUIRE(multiClient.isStitchingEnabled());
+        auto waveforms = multiClient.getData(std::vector<Request> {request});
+        REQUIRE(waveforms.size() == 1);
+        const auto &waveform = waveforms[0];
+        CHECK(waveform.getNetwork() == "UU");
+        CHECK(waveform.getStation() == "CTU");
+        REQUIRE(waveform.getNumberOfSegments() == 1);
+        const auto &segment = waveform.at(0);
+        CHECK(segment.getStartTime() == std::chrono::seconds {0});
+        CHECK(segment.getData<int> ()
+           == std::vector<int> {1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1});
+        // The secondary is only asked for the gap
+        REQUIRE(secondaryPointer->mRequests.size() == 1);
+        CHECK(secondaryPointer->mRequests[0].getStartTime()
+           == std::chrono::seconds {3});
+        CHECK(secondaryPointer->mRequests[0].getEndTime()
+           == std::chrono::seconds {7});
+        CHECK(primaryPointer->mRequests.size() == 1);
+        // The single request path stitches the same way
+        auto single = multiClient.getData(request);
+        REQUIRE(single.getNumberOfSegments() == 1);
+        CHECK(single.at(0).getData<int> () == segment.getData<int> ());
+    }
+}
+
+TEST_CASE("MLReview::WaveServer::MultiClient hedging", "[hedging]")
+{
+    constexpr std::chrono::milliseconds hedgeDelay{250};
+    auto request = ::createRequest("CTU", "HHZ", "01", 0, 10000000);
+    auto gate = std::make_shared<::Gate> ();
+    MultiClient multiClient;
+    multiClient.setMaximumNumberOfConcurrentRequests(2);
+    multiClient.insert(std::make_unique<::HungClient> (gate), 2);
+    multiClient.insert(std::make_unique<::FakeClient> (2), 1);
+    multiClient.enableHedging(hedgeDelay);
+    REQUIRE(multiClient.isHedgingEnabled());
+    // The abandoned legs must finish before the multi-client is destroyed
+    ::GateOpener opener{gate};
+
+    // The hung primary is given the hedge delay before the secondary
+    // is launched
+    for (int i = 0; i < multiClient.getMaximumNumberOfConcurrentRequests(); ++i)
+    {
+        auto waveform = multiClient.getData(request);
+        REQUIRE(waveform.getNumberOfSegments() == 1);
+        CHECK(waveform.at(0).getData<int> () == std::vector<int> (11, 2));
+    }
+    // Once the primary's legs are all hung it is skipped and the secondary
+    // answers straight away rather than waiting on a free worker
+    for (int i = 0; i < 4; ++i)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        auto waveform = multiClient.getData(request);
+        CHECK(std::chrono::steady_clock::now() - startTime < hedgeDelay);
+        REQUIRE(waveform.getNumberOfSegments() == 1);
+        CHECK(waveform.at(0).getData<int> () == std::vector<int> (11, 2));
+    }
+}
+
+TEST_CASE("MLReview::WaveServer::MultiClient circuit breaker", "[health]")
+{
+    auto request = ::createRequest("CTU", "HHZ", "01", 0, 10000000);
+    MultiClient multiClient;
+    multiClient.setMaximumNumberOfConcurrentRequests(1);
+
+    SECTION("No data is not a failure")
+    {
+        // Every request falls in the hole
+        multiClient.insert(
+            std::make_unique<::FakeClient>
+            (1, std::vector<std::pair<int64_t, int64_t>> {{-100, 100}}), 1);
+        for (int i = 0; i < 20; ++i)
+        {
+            auto waveforms
+                = multiClient.getData(std::vector<Request> {request});
+            REQUIRE(waveforms.size() == 1);
+            CHECK(waveforms[0].getNumberOfSegments() == 0);
+        }
+        auto health = multiClient.getClientHealth();
+        REQUIRE(health.size() == 1);
+        CHECK(health[0].state == MultiClient::CircuitState::Closed);
+        CHECK(health[0].errorRate == 0);
+    }
+
+    SECTION("Failures open the circuit")
+    {
+        multiClient.insert(std::make_unique<::FailingClient> (), 1);
+        for (int i = 0; i < 20; ++i)
+        {
+            auto waveforms
+                = multiClient.getData(std::vector<Request> {request});
+            REQUIRE(waveforms.size() == 1);
+            CHECK(waveforms[0].getNumberOfSegments() == 0);
+        }
+        auto health = multiClient.getClientHealth();
+        REQUIRE(health.size() == 1);
+        CHECK(health[0].state == MultiClient::CircuitState::Open);
+        CHECK(health[0].errorRate == 1);
+    }
+}
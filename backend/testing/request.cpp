@@ -0,0 +1,82 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <catch2/catch_test_macros.hpp>
+#include "mlReview/waveServer/request.hpp"
+#include "requests.hpp"
+
+using namespace MLReview::WaveServer;
+
+TEST_CASE("MLReview::WaveServer::Request hash", "[request]")
+{
+    std::hash<Request> hash;
+    auto request = ::createRequest("CTU", "HHZ", "01", 100, 200);
+
+    SECTION("Equal requests hash equally")
+    {
+        auto copy = request;
+        REQUIRE(copy == request);
+        CHECK(hash(copy) == hash(request));
+        // Case is normalized by the setters
+        auto lowerCase = ::createRequest("ctu", "hhz", "01", 100, 200);
+        REQUIRE(lowerCase == request);
+        CHECK(hash(lowerCase) == hash(request));
+    }
+
+    SECTION("Each field distinguishes requests")
+    {
+        std::vector<Request> others
+        {
+            ::createRequest("CTU", "HHZ", "01", 100, 201),
+            ::createRequest("CTU", "HHZ", "01", 99, 200),
+            ::createRequest("CTU", "HHZ", "02", 100, 200),
+            ::createRequest("CTU", "HHZ", "", 100, 200),
+            ::createRequest("CTU", "HHN", "01", 100, 200),
+            ::createRequest("MOUT", "HHZ", "01", 100, 200)
+        };
+        for (const auto &other : others)
+        {
+            CHECK(other != request);
+            CHECK(hash(other) != hash(request));
+        }
+    }
+
+    SECTION("Fields do not run together")
+    {
+        // Concatenating the fields would make these collide
+        auto lhs = ::createRequest("AB", "CDE", "", 100, 200);
+        auto rhs = ::createRequest("ABC", "DE", "", 100, 200);
+        REQUIRE(lhs != rhs);
+        CHECK(hash(lhs) != hash(rhs));
+    }
+
+    SECTION("Unset fields")
+    {
+        Request empty;
+        Request other;
+        CHECK(empty == other);
+        CHECK(hash(empty) == hash(other));
+        other.setNetwork("UU");
+        CHECK(empty != other);
+        CHECK(hash(empty) != hash(other));
+    }
+
+    SECTION("Deduplicate with an unordered map")
+    {
+        std::unordered_map<Request, int> counts;
+        std::vector<Request> requests
+        {
+            request,
+            ::createRequest("CTU", "HHN", "01", 100, 200),
+            ::createRequest("ctu", "hhz", "01", 100, 200),
+            ::createRequest("CTU", "HHN", "01", 100, 200),
+            request
+        };
+        for (const auto &r : requests){counts[r] = counts[r] + 1;}
+        REQUIRE(counts.size() == 2);
+        CHECK(counts.at(request) == 3);
+        CHECK(counts.at(::createRequest("CTU", "HHN", "01", 100, 200)) == 2);
+    }
+}
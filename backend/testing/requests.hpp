@@ -0,0 +1,30 @@
+#ifndef TESTING_REQUESTS_HPP
+#define TESTING_REQUESTS_HPP
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include "mlReview/waveServer/request.hpp"
+namespace
+{
+
+/// Creates a request for a channel in the UU network.  The times are in
+/// microseconds and a blank location code is left unset.
+MLReview::WaveServer::Request createRequest(const std::string &station,
+                                            const std::string &channel,
+                                            const std::string &locationCode,
+                                            const int64_t startTime,
+                                            const int64_t endTime)
+{
+    MLReview::WaveServer::Request request;
+    request.setNetwork("UU");
+    request.setStation(station);
+    request.setChannel(channel);
+    if (!locationCode.empty()){request.setLocationCode(locationCode);}
+    request.setStartAndEndTime(
+        std::pair {std::chrono::microseconds {startTime},
+                   std::chrono::microseconds {endTime}});
+    return request;
+}
+
+}
+#endif
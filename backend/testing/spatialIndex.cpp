@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include "private/spatialIndex.hpp"
+
+namespace
+{
+
+std::vector<std::string> sorted(std::vector<std::string> keys)
+{
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+::SpatialIndex<std::string> createIndex()
+{
+    ::SpatialIndex<std::string> index;
+    index.insert("fiji",          -17.7,  178.1);
+    index.insert("samoa",         -13.8, -172.1);
+    index.insert("dateline",        0,    180);
+    index.insert("westDateline",    0,   -179.5);
+    index.insert("eastDateline",    0,    179.5);
+    index.insert("utah",           40,   -112);
+    index.insert("greenwich",      51.5,    0);
+    return index;
+}
+
+}
+
+TEST_CASE("SpatialFilter", "[spatial]")
+{
+    SECTION("Great circle distance")
+    {
+        using Catch::Matchers::WithinAbs;
+        CHECK_THAT(::greatCircleDistance(0, 179.5, 0, -179.5),
+                   WithinAbs(111.2, 0.1));
+        CHECK_THAT(::greatCircleDistance(10, 0, 10, 360),
+                   WithinAbs(0, 1.e-6));
+    }
+
+    SECTION("Bounding box across the antimeridian")
+    {
+        ::SpatialFilter filter;
+        filter.boundingBox = std::array<double, 4> {-10, 170, 10, -170};
+        CHECK(filter.contains(0, 175, nullptr));
+        CHECK(filter.contains(0, -175, nullptr));
+        CHECK(filter.contains(0, 180, nullptr));
+        CHECK(filter.contains(0, -180, nullptr));
+        CHECK(filter.contains(0, 185, nullptr));
+        CHECK_FALSE(filter.contains(0, 0, nullptr));
+        CHECK_FALSE(filter.contains(0, 165, nullptr));
+        CHECK_FALSE(filter.contains(0, -165, nullptr));
+        CHECK_FALSE(filter.contains(20, 180, nullptr));
+    }
+
+    SECTION("Circle across the antimeridian")
+    {
+        ::SpatialFilter filter;
+        filter.circle = ::Circle {0, 179.5, 200};
+        CHECK(filter.contains(0, -179.5, nullptr));
+        CHECK(filter.contains(0, 178, nullptr));
+        CHECK_FALSE(filter.contains(0, -178, nullptr));
+        CHECK_FALSE(filter.contains(0, 177, nullptr));
+        auto box = filter.getBoundingBox(nullptr);
+        // The box wraps
+        CHECK(box[1] > box[3]);
+        CHECK(box[1] < 179.5);
+        CHECK(box[3] > -180);
+        CHECK(box[3] < -178);
+    }
+
+    SECTION("Circle around a pole")
+    {
+        ::SpatialFilter filter;
+        filter.circle = ::Circle {89, 0, 500};
+        auto box = filter.getBoundingBox(nullptr);
+        CHECK(box[1] == -180);
+        CHECK(box[3] == 180);
+        CHECK(box[2] == 90);
+        CHECK(filter.contains(89.5, 180, nullptr));
+    }
+
+    SECTION("Parse")
+    {
+        auto request = nlohmann::json::parse(R"({
+            "bbox": {"minLatitude": -10, "minLongitude": 170,
+                     "maxLatitude": 10, "maxLongitude": 190}
+        })");
+        auto filter = ::parseSpatialFilter(request, nullptr);
+        REQUIRE(filter);
+        REQUIRE(filter->boundingBox);
+        CHECK((*filter->boundingBox)[1] == 170);
+        CHECK((*filter->boundingBox)[3] == -170);
+        CHECK_FALSE(filter->circle);
+        CHECK_FALSE(::parseSpatialFilter(nlohmann::json::object(), nullptr));
+        auto radius = nlohmann::json::parse(R"({
+            "radius": {"latitude": 0, "longitude": 359.5, "distance": 10}
+        })");
+        filter = ::parseSpatialFilter(radius, nullptr);
+        REQUIRE(filter);
+        REQUIRE(filter->circle);
+        CHECK(filter->circle->longitude == -0.5);
+    }
+
+    SECTION("Bounding box of every longitude")
+    {
+        for (const auto &longitudes : {std::pair {-180.0, 180.0},
+                                       std::pair {0.0, 360.0},
+                                       std::pair {-200.0, 170.0}})
+        {
+            nlohmann::json request;
+            request["bbox"]["minLatitude"] = -90;
+            request["bbox"]["minLongitude"] = longitudes.first;
+            request["bbox"]["maxLatitude"] = 90;
+            request["bbox"]["maxLongitude"] = longitudes.second;
+            auto filter = ::parseSpatialFilter(request, nullptr);
+            REQUIRE(filter);
+            REQUIRE(filter->boundingBox);
+            CHECK((*filter->boundingBox)[1] == -180);
+            CHECK((*filter->boundingBox)[3] == 180);
+            CHECK(filter->contains(40, -111, nullptr));
+            CHECK(filter->contains(0, 180, nullptr));
+            CHECK(filter->contains(0, 0, nullptr));
+        }
+    }
+
+    SECTION("Invalid filters")
+    {
+        CHECK_THROWS_AS(::parseSpatialFilter(nlohmann::json::parse(R"({
+            "bbox": {"minLatitude": 10, "minLongitude": 0,
+                     "maxLatitude": -10, "maxLongitude": 10}})"), nullptr),
+            std::invalid_argument);
+        CHECK_THROWS_AS(::parseSpatialFilter(nlohmann::json::parse(R"({
+            "radius": {"latitude": 0, "longitude": 0, "distance": 0}})"),
+            nullptr),
+            std::invalid_argument);
+        CHECK_THROWS_AS(::parseSpatialFilter(nlohmann::json::parse(R"({
+            "radius": {"latitude": 91, "longitude": 0, "distance": 1}})"),
+            nullptr),
+            std::invalid_argument);
+        // Regions require a geofence
+        CHECK_THROWS_AS(::parseSpatialFilter(nlohmann::json::parse(R"({
+            "region": "utah"})"), nullptr),
+            std::invalid_argument);
+    }
+}
+
+TEST_CASE("SpatialIndex", "[spatial]")
+{
+    auto index = ::createIndex();
+    REQUIRE(index.size() == 7);
+
+    SECTION("Bounding box across the antimeridian")
+    {
+        ::SpatialFilter filter;
+        filter.boundingBox = std::array<double, 4> {-20, 175, 5, -170};
+        CHECK(::sorted(index.query(filter, nullptr))
+           == std::vector<std::string> {"dateline", "eastDateline",
+                                        "fiji", "samoa", "westDateline"});
+    }
+
+    SECTION("Bounding box that does not cross")
+    {
+        ::SpatialFilter filter;
+        filter.boundingBox = std::array<double, 4> {30, -120, 60, 10};
+        CHECK(::sorted(index.query(filter, nullptr))
+           == std::vector<std::string> {"greenwich", "utah"});
+    }
+
+    SECTION("Circle across the antimeridian")
+    {
+        ::SpatialFilter filter;
+        filter.circle = ::Circle {0, -179.9, 100};
+        CHECK(::sorted(index.query(filter, nullptr))
+           == std::vector<std::string> {"dateline", "eastDateline",
+                                        "westDateline"});
+    }
+
+    SECTION("Everything")
+    {
+        ::SpatialFilter filter;
+        CHECK(index.query(filter, nullptr).size() == 7);
+        auto world = ::parseSpatialFilter(nlohmann::json::parse(R"({
+            "bbox": {"minLatitude": -90, "minLongitude": -180,
+                     "maxLatitude": 90, "maxLongitude": 180}})"), nullptr);
+        REQUIRE(world);
+        CHECK(index.query(*world, nullptr).size() == 7);
+    }
+
+    SECTION("Erase")
+    {
+        index.erase("dateline", 0, -180);
+        CHECK(index.size() == 6);
+        index.erase("fiji", -17.7, 178.1);
+        ::SpatialFilter filter;
+        filter.boundingBox = std::array<double, 4> {-20, 175, 5, -170};
+        CHECK(::sorted(index.query(filter, nullptr))
+           == std::vector<std::string> {"eastDateline", "samoa",
+                                        "westDateline"});
+        index.clear();
+        CHECK(index.size() == 0);
+    }
+}
@@ -0,0 +1,42 @@
+#!/bin/bash
+# Starts a disposable single-node MongoDB replica set for the catalog change
+# stream tests and prints the environment variables the tests read.  For
+# example:
+#
+#   eval $(testing/startReplicaSet.sh)
+#   ctest -R catalogChangeStreamTests --output-on-failure
+#
+# Usage: startReplicaSet.sh [port] [data directory]
+# Stop the server with:
+#   mongosh --port <port> admin --eval "db.shutdownServer()"
+set -e
+PORT=${1:-27117}
+DATA_DIRECTORY=${2:-$(mktemp -d -t mlReviewReplicaSet.XXXXXX)}
+DATABASE=mlReviewTest
+MONGODB_USER=mlReviewTest
+MONGODB_PASSWORD=mlReviewTest
+
+mkdir -p ${DATA_DIRECTORY}
+mongod --replSet rs0 \
+       --port ${PORT} \
+       --bind_ip 127.0.0.1 \
+       --dbpath ${DATA_DIRECTORY} \
+       --fork \
+       --logpath ${DATA_DIRECTORY}/mongod.log > /dev/null
+mongosh --quiet --port ${PORT} \
+        --eval "rs.initiate({_id: 'rs0', members: [{_id: 0, host: '127.0.0.1:${PORT}'}]})" > /dev/null
+# Change streams require a primary
+for i in $(seq 1 30); do
+    if mongosh --quiet --port ${PORT} --eval "db.hello().isWritablePrimary" | grep -q true; then
+        break
+    fi
+    sleep 1
+done
+mongosh --quiet --port ${PORT} ${DATABASE} \
+        --eval "if (db.getUser('${MONGODB_USER}') === null) { db.createUser({user: '${MONGODB_USER}', pwd: '${MONGODB_PASSWORD}', roles: [{role: 'readWrite', db: '${DATABASE}'}]}) }" > /dev/null
+
+echo "export MLREVIEW_TEST_MONGODB_HOST=127.0.0.1"
+echo "export MLREVIEW_TEST_MONGODB_PORT=${PORT}"
+echo "export MLREVIEW_TEST_MONGODB_USER=${MONGODB_USER}"
+echo "export MLREVIEW_TEST_MONGODB_PASSWORD=${MONGODB_PASSWORD}"
+echo "export MLREVIEW_TEST_MONGODB_DATABASE=${DATABASE}"